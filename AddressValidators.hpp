@@ -0,0 +1,424 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Hand-written DFA validators for stream URLs, MAC addresses and host:port
+// strings. Each is a single forward pass over the input with one table
+// lookup per character: no allocation, no backtracking, and the parsed
+// components come back as views into the input.
+
+namespace addr_detail
+{
+
+enum CharClass : uint8_t
+{
+    kDigit = 1,
+    kHex = 2,
+    kHostChar = 4,    ///< [A-Za-z0-9.-]
+    kPathChar = 8,    ///< [A-Za-z0-9-._~%!$&'()*+,;=:@/]
+    kQueryChar = 16,  ///< kPathChar plus '?'
+    kLabelChar = 32   ///< [A-Za-z0-9-]
+};
+
+struct CharTable
+{
+    uint8_t bits[256];
+
+    constexpr CharTable() : bits()
+    {
+        for (int c = '0'; c <= '9'; ++c)
+        {
+            bits[c] |= kDigit | kHex | kHostChar | kPathChar | kQueryChar | kLabelChar;
+        }
+        for (int c = 'a'; c <= 'z'; ++c)
+        {
+            bits[c] |= kHostChar | kPathChar | kQueryChar | kLabelChar;
+            bits[c - 'a' + 'A'] |= kHostChar | kPathChar | kQueryChar | kLabelChar;
+        }
+        for (int c = 'a'; c <= 'f'; ++c)
+        {
+            bits[c] |= kHex;
+            bits[c - 'a' + 'A'] |= kHex;
+        }
+        bits[static_cast<int>('.')] |= kHostChar;
+        bits[static_cast<int>('-')] |= kHostChar | kLabelChar;
+        const char* path = "-._~%!$&'()*+,;=:@/";
+        for (const char* p = path; *p; ++p)
+        {
+            bits[static_cast<unsigned char>(*p)] |= kPathChar | kQueryChar;
+        }
+        bits[static_cast<int>('?')] |= kQueryChar;
+    }
+};
+
+constexpr CharTable kChars;
+
+inline bool is(char c, uint8_t cls)
+{
+    return (kChars.bits[static_cast<unsigned char>(c)] & cls) != 0;
+}
+
+inline int hexValue(char c)
+{
+    return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+}
+
+// Skip characters of a class; returns the first position not in it
+inline const char* span(const char* p, const char* end, uint8_t cls)
+{
+    while (p < end && is(*p, cls))
+    {
+        ++p;
+    }
+    return p;
+}
+
+} // namespace addr_detail
+
+struct RtspUrlParts
+{
+    std::string_view host;
+    std::string_view port;   ///< Digits only; empty if absent
+    std::string_view path;   ///< Starts with '/'; empty if absent
+    std::string_view query;  ///< Without the '?'; empty if absent
+};
+
+// rtsp://host[:port][/path][?query], accepting exactly what the pattern
+// ^rtsp://[a-zA-Z0-9.-]+(?::\d+)?(/[path chars]*)?(\?[query chars]*)?$ does
+inline bool parseRtspUrl(std::string_view url, RtspUrlParts* parts = nullptr)
+{
+    using namespace addr_detail;
+    if (url.size() < 8 || memcmp(url.data(), "rtsp://", 7) != 0)
+    {
+        return false;
+    }
+    const char* begin = url.data() + 7;
+    const char* end = url.data() + url.size();
+
+    const char* p = span(begin, end, kHostChar);
+    if (p == begin)
+    {
+        return false;
+    }
+    const char* hostEnd = p;
+    const char* portBegin = p;
+    if (p < end && *p == ':')
+    {
+        portBegin = ++p;
+        p = span(p, end, kDigit);
+        if (p == portBegin)
+        {
+            return false;
+        }
+    }
+    const char* portEnd = p;
+    const char* pathBegin = p;
+    if (p < end && *p == '/')
+    {
+        p = span(p + 1, end, kPathChar);
+    }
+    const char* pathEnd = p;
+    const char* queryBegin = p;
+    if (p < end && *p == '?')
+    {
+        queryBegin = ++p;
+        p = span(p, end, kQueryChar);
+    }
+    if (p != end)
+    {
+        return false;
+    }
+    if (parts)
+    {
+        parts->host = std::string_view(begin, static_cast<size_t>(hostEnd - begin));
+        parts->port = std::string_view(portBegin, static_cast<size_t>(portEnd - portBegin));
+        parts->path = std::string_view(pathBegin, static_cast<size_t>(pathEnd - pathBegin));
+        parts->query = std::string_view(queryBegin, static_cast<size_t>(end - queryBegin));
+    }
+    return true;
+}
+
+struct MacAddressParts
+{
+    std::array<std::string_view, 6> octets;
+    std::array<uint8_t, 6> bytes;
+};
+
+// Six hex pairs separated by ':' or '-' (each separator independently, as
+// ^([0-9A-Fa-f]{2}[:-]){5}([0-9A-Fa-f]{2})$ allows)
+inline bool parseMacAddress(std::string_view mac, MacAddressParts* parts = nullptr)
+{
+    using namespace addr_detail;
+    if (mac.size() != 17)
+    {
+        return false;
+    }
+    const char* s = mac.data();
+    for (int i = 0; i < 6; ++i)
+    {
+        const char* o = s + 3 * i;
+        if (!is(o[0], kHex) || !is(o[1], kHex) || (i < 5 && o[2] != ':' && o[2] != '-'))
+        {
+            return false;
+        }
+        if (parts)
+        {
+            parts->octets[i] = std::string_view(o, 2);
+            parts->bytes[i] = static_cast<uint8_t>(hexValue(o[0]) << 4 | hexValue(o[1]));
+        }
+    }
+    return true;
+}
+
+// Dotted quad with no leading zeros, as inet_pton(AF_INET) accepts
+inline bool parseIPv4(std::string_view s, uint8_t out[4] = nullptr)
+{
+    const char* p = s.data();
+    const char* end = p + s.size();
+    for (int i = 0; i < 4; ++i)
+    {
+        if (i > 0)
+        {
+            if (p == end || *p != '.')
+            {
+                return false;
+            }
+            ++p;
+        }
+        const char* digits = p;
+        unsigned value = 0;
+        while (p < end && addr_detail::is(*p, addr_detail::kDigit) && p - digits < 3)
+        {
+            value = value * 10 + static_cast<unsigned>(*p++ - '0');
+        }
+        if (p == digits || value > 255 || (*digits == '0' && p - digits > 1))
+        {
+            return false;
+        }
+        if (out)
+        {
+            out[i] = static_cast<uint8_t>(value);
+        }
+    }
+    return p == end;
+}
+
+// RFC 4291 text form: up to eight 1-4 digit hex groups, one "::" and an
+// optional trailing dotted quad
+inline bool parseIPv6(std::string_view s, uint8_t out[16] = nullptr)
+{
+    uint8_t bytes[16] = {};
+    const char* p = s.data();
+    const char* end = p + s.size();
+    int groups = 0;       // 16-bit groups written
+    int gap = -1;         // group index of "::"
+    if (end - p >= 2 && p[0] == ':' && p[1] == ':')
+    {
+        gap = 0;
+        p += 2;
+        if (p == end)
+        {
+            if (out)
+            {
+                memcpy(out, bytes, 16);
+            }
+            return true;
+        }
+    }
+    else if (p < end && *p == ':')
+    {
+        return false;
+    }
+    while (p < end)
+    {
+        if (groups == 8)
+        {
+            return false;
+        }
+        const char* digits = p;
+        unsigned value = 0;
+        while (p < end && addr_detail::is(*p, addr_detail::kHex) && p - digits < 4)
+        {
+            value = value << 4 | static_cast<unsigned>(addr_detail::hexValue(*p++));
+        }
+        if (p < end && *p == '.')
+        {
+            // Embedded IPv4 takes the last two groups
+            if (groups > 6 || !parseIPv4(std::string_view(digits, static_cast<size_t>(end - digits)), bytes + 2 * groups))
+            {
+                return false;
+            }
+            groups += 2;
+            p = end;
+            break;
+        }
+        if (p == digits)
+        {
+            return false;
+        }
+        bytes[2 * groups] = static_cast<uint8_t>(value >> 8);
+        bytes[2 * groups + 1] = static_cast<uint8_t>(value);
+        ++groups;
+        if (p == end)
+        {
+            break;
+        }
+        if (*p != ':')
+        {
+            return false;
+        }
+        ++p;
+        if (p < end && *p == ':')
+        {
+            if (gap >= 0)
+            {
+                return false;
+            }
+            gap = groups;
+            ++p;
+        }
+        else if (p == end)
+        {
+            return false; // trailing single ':'
+        }
+    }
+    if (gap >= 0)
+    {
+        if (groups == 8)
+        {
+            return false;
+        }
+        int tail = groups - gap;
+        memmove(bytes + 16 - 2 * tail, bytes + 2 * gap, static_cast<size_t>(2 * tail));
+        memset(bytes + 2 * gap, 0, static_cast<size_t>(16 - 2 * groups));
+    }
+    else if (groups != 8)
+    {
+        return false;
+    }
+    if (out)
+    {
+        memcpy(out, bytes, 16);
+    }
+    return true;
+}
+
+// DNS name: dot-separated labels of [A-Za-z0-9-], 1-63 characters each,
+// not starting or ending with '-', at most 253 characters overall
+inline bool parseHostName(std::string_view s)
+{
+    if (s.empty() || s.size() > 253)
+    {
+        return false;
+    }
+    const char* p = s.data();
+    const char* end = p + s.size();
+    for (;;)
+    {
+        const char* label = p;
+        p = addr_detail::span(p, end, addr_detail::kLabelChar);
+        if (p == label || p - label > 63 || *label == '-' || p[-1] == '-')
+        {
+            return false;
+        }
+        if (p == end)
+        {
+            return true;
+        }
+        if (*p != '.')
+        {
+            return false;
+        }
+        ++p;
+    }
+}
+
+struct HostPortParts
+{
+    enum Family
+    {
+        IPv4,
+        IPv6,
+        Name
+    };
+
+    Family family;
+    std::string_view host;   ///< Without brackets for IPv6
+    std::string_view port;
+    uint16_t portNumber;
+    uint8_t address[16];     ///< Network order; 4 bytes for IPv4, unset for names
+};
+
+// host:port where host is a dotted quad, a bracketed IPv6 address or a DNS
+// name, and port is a decimal number up to 65535. Hosts made only of digits
+// and dots must be valid IPv4.
+inline bool parseHostPort(std::string_view s, HostPortParts* parts = nullptr)
+{
+    HostPortParts local;
+    HostPortParts& out = parts ? *parts : local;
+    size_t colon;
+    if (!s.empty() && s[0] == '[')
+    {
+        size_t close = s.find(']');
+        if (close == std::string_view::npos || close + 1 >= s.size() || s[close + 1] != ':')
+        {
+            return false;
+        }
+        out.family = HostPortParts::IPv6;
+        out.host = s.substr(1, close - 1);
+        if (!parseIPv6(out.host, out.address))
+        {
+            return false;
+        }
+        colon = close + 1;
+    }
+    else
+    {
+        colon = s.rfind(':');
+        if (colon == std::string_view::npos)
+        {
+            return false;
+        }
+        out.host = s.substr(0, colon);
+        if (out.host.find_first_not_of("0123456789.") == std::string_view::npos)
+        {
+            out.family = HostPortParts::IPv4;
+            if (!parseIPv4(out.host, out.address))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            out.family = HostPortParts::Name;
+            if (!parseHostName(out.host))
+            {
+                return false;
+            }
+        }
+    }
+
+    out.port = s.substr(colon + 1);
+    if (out.port.empty() || out.port.size() > 5)
+    {
+        return false;
+    }
+    unsigned port = 0;
+    for (char c : out.port)
+    {
+        if (!addr_detail::is(c, addr_detail::kDigit))
+        {
+            return false;
+        }
+        port = port * 10 + static_cast<unsigned>(c - '0');
+    }
+    if (port > 65535)
+    {
+        return false;
+    }
+    out.portNumber = static_cast<uint16_t>(port);
+    return true;
+}
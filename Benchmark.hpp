@@ -0,0 +1,236 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+// Keep a value alive so the optimizer cannot drop the work producing it
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// User-space CPU cycle counter through perf_event_open; falls back to
+// "unavailable" when the kernel or container forbids it
+class PerfCycles
+{
+public:
+    PerfCycles()
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    ~PerfCycles()
+    {
+        if (fd_ >= 0)
+        {
+            close(fd_);
+        }
+    }
+
+    PerfCycles(const PerfCycles&) = delete;
+    PerfCycles& operator=(const PerfCycles&) = delete;
+
+    bool available() const { return fd_ >= 0; }
+
+    void start()
+    {
+        if (fd_ >= 0)
+        {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    uint64_t stop()
+    {
+        uint64_t count = 0;
+        if (fd_ >= 0)
+        {
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd_, &count, sizeof(count)) != sizeof(count))
+            {
+                count = 0;
+            }
+        }
+        return count;
+    }
+
+private:
+    int fd_;
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    uint64_t iterations = 0;   ///< Operations per timed run
+    int runs = 0;              ///< Number of timed runs
+    double medianNs = 0;       ///< Median ns/op across runs
+    double madNs = 0;          ///< Median absolute deviation of ns/op
+    double minNs = 0;          ///< Fastest run, ns/op
+    double cyclesPerOp = -1;   ///< Median cycles/op, -1 when perf is unavailable
+};
+
+// Minimal microbenchmark runner. Each benchmark is a callable taking the
+// number of operations to perform; the runner sizes that count so a run
+// lasts at least minRunTime, does warmup runs, then repeats and reports
+// robust statistics (median and MAD) rather than a mean.
+class BenchmarkRunner
+{
+public:
+    typedef std::function<void(uint64_t iterations)> Body;
+
+    int warmupRuns = 3;
+    int timedRuns = 15;
+    std::chrono::nanoseconds minRunTime = std::chrono::milliseconds(20);
+
+    void add(const std::string& name, Body body)
+    {
+        benchmarks_.push_back(Entry{name, std::move(body)});
+    }
+
+    // Run every benchmark whose name contains filter (empty = all)
+    std::vector<BenchmarkResult> run(const std::string& filter = std::string())
+    {
+        std::vector<BenchmarkResult> results;
+        PerfCycles cycles;
+        for (auto& b : benchmarks_)
+        {
+            if (!filter.empty() && b.name.find(filter) == std::string::npos)
+            {
+                continue;
+            }
+            results.push_back(runOne(b, cycles));
+            printRow(std::cout, results.back());
+        }
+        return results;
+    }
+
+    static void writeJson(std::ostream& out, const std::vector<BenchmarkResult>& results)
+    {
+        char host[256] = "unknown";
+        gethostname(host, sizeof(host) - 1);
+        out << "{\n  \"context\": {\"host\": \"" << host << "\", \"timestamp\": "
+            << std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count()
+            << "},\n  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const BenchmarkResult& r = results[i];
+            out << (i ? ",\n" : "\n") << std::setprecision(6)
+                << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+                << ", \"runs\": " << r.runs << ", \"median_ns\": " << r.medianNs
+                << ", \"mad_ns\": " << r.madNs << ", \"min_ns\": " << r.minNs
+                << ", \"cycles_per_op\": ";
+            if (r.cyclesPerOp < 0)
+            {
+                out << "null";
+            }
+            else
+            {
+                out << r.cyclesPerOp;
+            }
+            out << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+private:
+    struct Entry
+    {
+        std::string name;
+        Body body;
+    };
+
+    static double median(std::vector<double> v)
+    {
+        std::sort(v.begin(), v.end());
+        size_t n = v.size();
+        return n % 2 ? v[n / 2] : 0.5 * (v[n / 2 - 1] + v[n / 2]);
+    }
+
+    BenchmarkResult runOne(Entry& b, PerfCycles& cycles)
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        // Grow the iteration count until one run is long enough to time reliably
+        uint64_t iterations = 1;
+        for (;;)
+        {
+            auto start = Clock::now();
+            b.body(iterations);
+            auto elapsed = Clock::now() - start;
+            if (elapsed >= minRunTime || iterations >= (1ULL << 40))
+            {
+                break;
+            }
+            double scale = elapsed.count() > 0 ? 1.2 * minRunTime.count() / elapsed.count() : 10.0;
+            iterations = static_cast<uint64_t>(iterations * std::min(10.0, std::max(2.0, scale)));
+        }
+
+        for (int i = 0; i < warmupRuns; ++i)
+        {
+            b.body(iterations);
+        }
+
+        std::vector<double> ns, cyc;
+        for (int i = 0; i < timedRuns; ++i)
+        {
+            cycles.start();
+            auto start = Clock::now();
+            b.body(iterations);
+            auto elapsed = Clock::now() - start;
+            uint64_t c = cycles.stop();
+            ns.push_back(std::chrono::duration<double, std::nano>(elapsed).count() / iterations);
+            cyc.push_back(static_cast<double>(c) / iterations);
+        }
+
+        BenchmarkResult r;
+        r.name = b.name;
+        r.iterations = iterations;
+        r.runs = timedRuns;
+        r.medianNs = median(ns);
+        std::vector<double> dev;
+        for (double v : ns)
+        {
+            dev.push_back(std::fabs(v - r.medianNs));
+        }
+        r.madNs = median(dev);
+        r.minNs = *std::min_element(ns.begin(), ns.end());
+        r.cyclesPerOp = cycles.available() ? median(cyc) : -1;
+        return r;
+    }
+
+    static void printRow(std::ostream& out, const BenchmarkResult& r)
+    {
+        out << std::left << std::setw(48) << r.name << std::right << std::fixed << std::setprecision(2)
+            << std::setw(12) << r.medianNs << " ns/op  +/- " << std::setw(8) << r.madNs;
+        if (r.cyclesPerOp >= 0)
+        {
+            out << "  " << std::setw(10) << r.cyclesPerOp << " cycles/op";
+        }
+        out << std::defaultfloat << std::endl;
+    }
+
+    std::vector<Entry> benchmarks_;
+};
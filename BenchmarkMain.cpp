@@ -0,0 +1,452 @@
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include "Benchmark.hpp"
+#include "BitHacks.hpp"
+#include "SuccinctBitset.hpp"
+#include "ByteSwap.hpp"
+#include "WireCodec.hpp"
+#include "NtpConvert.hpp"
+#include "XmlConfigRead.hpp"
+#include "XmlPullParser.hpp"
+#include "XmlDocument.hpp"
+#include "TimerWheel.hpp"
+#include "UtcClock.hpp"
+#include "AddressValidators.hpp"
+#include "RegexRegistry.hpp"
+#include "OuiTable.hpp"
+#include "greatCircleDistance.hpp"
+#include "LatLongHeightToRangeBearingElevation.hpp"
+#include "RangeBearingElevationToLatLongHeight.hpp"
+#include "CartesianToPolar.hpp"
+
+// Usage: snippet_bench [--filter SUBSTRING] [--json FILE|-] [--runs N] [--warmup N]
+
+static void registerGeodesy(BenchmarkRunner& runner)
+{
+    runner.add("geodesy/greatCircleDistance", [](uint64_t n)
+    {
+        double lat = 51.5;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            doNotOptimize(greatCircleDistance(lat, -0.12, 48.85, 2.35));
+            lat += 1e-9;
+        }
+    });
+
+    runner.add("geodesy/latLonHeightToRangeBearingElevation", [](uint64_t n)
+    {
+        LatLonHeight a = {51.5, -0.12, 10.0};
+        LatLonHeight b = {48.85, 2.35, 35.0};
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            doNotOptimize(latLonHeightToRangeBearingElevation(a, b));
+            a.latitude += 1e-9;
+        }
+    });
+
+    runner.add("geodesy/RangeBearingElevationToLatLongHeight", [](uint64_t n)
+    {
+        double lat, lon, h;
+        double range = 1000.0;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            RangeBearingElevationToLatLongHeight(range, 45.0, 2.0, 51.5, -0.12, 10.0, lat, lon, h);
+            doNotOptimize(lat);
+            range += 1e-3;
+        }
+    });
+
+    runner.add("geodesy/cartesianToPolar", [](uint64_t n)
+    {
+        double r, theta;
+        double x = 1.0;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            cartesianToPolar(x, 2.0, r, theta);
+            doNotOptimize(theta);
+            x += 1e-9;
+        }
+    });
+}
+
+// Rank/select index over 64M random bits, built on first use
+static const RankSelect& benchIndex()
+{
+    static RankSelect rs;
+    if (rs.size() == 0)
+    {
+        std::mt19937_64 rng(2);
+        BitVector bits(1ULL << 26);
+        for (uint64_t i = 0; i < bits.size(); ++i)
+        {
+            if ((rng() & 7) == 0)
+            {
+                bits.set(i);
+            }
+        }
+        rs = RankSelect(bits);
+    }
+    return rs;
+}
+
+static void registerBitHacks(BenchmarkRunner& runner)
+{
+    static std::vector<uint32_t> words;
+    if (words.empty())
+    {
+        std::mt19937 rng(1);
+        words.resize(4096);
+        for (auto& w : words)
+        {
+            w = rng();
+        }
+    }
+
+    runner.add("bithacks/countSetBits", [](uint64_t n)
+    {
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            doNotOptimize(countSetBits(words[i & 4095]));
+        }
+    });
+
+    runner.add("bithacks/reverseBits", [](uint64_t n)
+    {
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            doNotOptimize(reverseBits(words[i & 4095]));
+        }
+    });
+
+    runner.add("bithacks/RankSelect::rank1", [](uint64_t n)
+    {
+        const RankSelect& rs = benchIndex();
+        uint64_t p = 12345;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            p = (p * 6364136223846793005ULL + 1442695040888963407ULL);
+            doNotOptimize(rs.rank1((p >> 20) % rs.size()));
+        }
+    });
+
+    runner.add("bithacks/RankSelect::select1", [](uint64_t n)
+    {
+        const RankSelect& rs = benchIndex();
+        uint64_t p = 12345;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            p = (p * 6364136223846793005ULL + 1442695040888963407ULL);
+            doNotOptimize(rs.select1((p >> 20) % rs.ones()));
+        }
+    });
+}
+
+static void registerEndian(BenchmarkRunner& runner)
+{
+    static std::vector<uint32_t> buffer(1 << 16);
+
+    runner.add("endian/swapBytesArray<uint32_t> (per element)", [](uint64_t n)
+    {
+        for (uint64_t done = 0; done < n; done += buffer.size())
+        {
+            swapBytesArray(buffer.data(), buffer.size());
+            doNotOptimize(buffer[0]);
+        }
+    });
+
+    runner.add("endian/scalar bswap32 (per element)", [](uint64_t n)
+    {
+        for (uint64_t done = 0; done < n; done += buffer.size())
+        {
+            byteswap_detail::scalar32(buffer.data(), buffer.data(), buffer.size());
+            doNotOptimize(buffer[0]);
+        }
+    });
+
+    typedef WireLayout<Field<uint16_t>, Field<uint16_t>, Field<uint32_t>, Field<uint64_t>> Header;
+    static std::vector<unsigned char> frames(Header::size * 1024);
+
+    runner.add("endian/WireLayout decode 4 fields", [](uint64_t n)
+    {
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            const unsigned char* p = frames.data() + (i & 1023) * Header::size;
+            doNotOptimize(Header::get<0>(p) + Header::get<1>(p) + Header::get<2>(p) + Header::get<3>(p));
+        }
+    });
+}
+
+static void registerNtp(BenchmarkRunner& runner)
+{
+    runner.add("ntp/ntpToUtc", [](uint64_t n)
+    {
+        uint64_t t = 0x83AA7F7F0145C000ULL;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            doNotOptimize(ntpToUtc(t + (i << 20)));
+        }
+    });
+
+    runner.add("ntp/NtpTimestamp::toUnixNanos", [](uint64_t n)
+    {
+        uint64_t t = 0x83AA7F7F0145C000ULL;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            doNotOptimize(NtpTimestamp(t + (i << 20)).toUnixNanos());
+        }
+    });
+
+    runner.add("ntp/ntpToUnixNanos batch (per timestamp)", [](uint64_t n)
+    {
+        uint64_t in[256];
+        int64_t out[256];
+        for (size_t i = 0; i < 256; ++i)
+        {
+            in[i] = 0x83AA7F7F0145C000ULL + (i << 20);
+        }
+        for (uint64_t i = 0; i < n; i += 256)
+        {
+            ntpToUnixNanos(in, out, 256);
+            doNotOptimize(out[i % 256]);
+        }
+    });
+}
+
+static void registerXml(BenchmarkRunner& runner)
+{
+    static std::string doc;
+    if (doc.empty())
+    {
+        doc = "<config>";
+        for (int i = 0; i < 1000; ++i)
+        {
+            doc += "<destination host=\"10.0.0." + std::to_string(i % 255) + "\" port=\"7777\">dest" + std::to_string(i) + "</destination>";
+        }
+        doc += "</config>";
+    }
+
+    runner.add("xml/parseXML (per byte)", [](uint64_t n)
+    {
+        for (uint64_t done = 0; done < n; done += doc.size())
+        {
+            doNotOptimize(parseXML(doc).size());
+        }
+    });
+
+    runner.add("xml/XmlPullParser (per byte)", [](uint64_t n)
+    {
+        for (uint64_t done = 0; done < n; done += doc.size())
+        {
+            XmlPullParser p(doc);
+            size_t events = 0;
+            for (XmlEvent e = p.next(); e != XmlEvent::EndDocument && e != XmlEvent::Error; e = p.next())
+            {
+                ++events;
+            }
+            doNotOptimize(events);
+        }
+    });
+
+    runner.add("xml/XmlDocument parse + query (per byte)", [](uint64_t n)
+    {
+        for (uint64_t done = 0; done < n; done += doc.size())
+        {
+            XmlDocument d = XmlDocument::parse(doc);
+            doNotOptimize(d.query("config/destination[@port]").size());
+        }
+    });
+}
+
+static void registerValidators(BenchmarkRunner& runner)
+{
+    runner.add("validate/parseRtspUrl", [](uint64_t n)
+    {
+        const char* urls[] = {"rtsp://example.com:8554/stream1", "rtsp://10.0.0.1/live?x=1", "rtsp://bad host/"};
+        RtspUrlParts parts;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            doNotOptimize(parseRtspUrl(urls[i % 3], &parts));
+        }
+    });
+
+    runner.add("validate/parseMacAddress", [](uint64_t n)
+    {
+        const char* macs[] = {"00:1A:2b:3C:4d:5E", "AA-BB-CC-DD-EE-FF", "00:1A:2b:3C:4d:5"};
+        MacAddressParts parts;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            doNotOptimize(parseMacAddress(macs[i % 3], &parts));
+        }
+    });
+
+    runner.add("validate/parseHostPort", [](uint64_t n)
+    {
+        const char* hosts[] = {"192.168.0.1:554", "[2001:db8::2:1]:8554", "camera-1.example.com:554"};
+        HostPortParts parts;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            doNotOptimize(parseHostPort(hosts[i % 3], &parts));
+        }
+    });
+
+    runner.add("validate/OuiTable classify batch (per MAC)", [](uint64_t n)
+    {
+        static OuiTable table = []()
+        {
+            OuiTable t;
+            std::mt19937 rng(11);
+            for (int i = 0; i < 40000; ++i)
+            {
+                t.add(rng() & 0xFCFFFF, "vendor");
+            }
+            t.build();
+            return t;
+        }();
+        std::mt19937_64 rng(5);
+        uint64_t macs[256];
+        uint32_t vendors[256];
+        for (auto& m : macs)
+        {
+            m = rng() & 0xFCFFFFFFFFFFull;
+        }
+        for (uint64_t i = 0; i < n; i += 256)
+        {
+            table.classify(macs, 256, vendors);
+            doNotOptimize(vendors[i % 256]);
+        }
+    });
+
+    runner.add("validate/PatternSet scan (per line)", [](uint64_t n)
+    {
+        static RegexRegistry registry;
+        static PatternSet set = []()
+        {
+            std::vector<std::shared_ptr<const CompiledPattern>> patterns;
+            for (const char* p : {"connection reset", "svc-3\\[\\d+\\]: (WARN|ERROR)", "latency=\\d{4,}ms", "code=E17 "})
+            {
+                patterns.push_back(registry.get(registry.add(p)));
+            }
+            return PatternSet(patterns);
+        }();
+        std::string text = "2024-05-12T12:00:31Z host-7 svc-3[1234]: WARN user=bob action=read code=E17 latency=12ms\n";
+        size_t hits = 0;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            hits += set.scan(text, [](size_t, std::string_view, const std::vector<uint32_t>&) {});
+        }
+        doNotOptimize(hits);
+    });
+}
+
+static void registerTimers(BenchmarkRunner& runner)
+{
+    runner.add("timers/system_clock::now", [](uint64_t n)
+    {
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            doNotOptimize(std::chrono::system_clock::now());
+        }
+    });
+
+    runner.add("timers/clock_gettime(CLOCK_REALTIME)", [](uint64_t n)
+    {
+        struct timespec ts;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            clock_gettime(CLOCK_REALTIME, &ts);
+            doNotOptimize(ts);
+        }
+    });
+
+    runner.add("timers/UtcClock::nowNanos", [](uint64_t n)
+    {
+        UtcClock& clock = UtcClock::global();
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            doNotOptimize(clock.nowNanos());
+        }
+    });
+
+    runner.add("timers/UtcClock::format (per timestamp)", [](uint64_t n)
+    {
+        char text[32];
+        int64_t t = 1700000000000000000LL;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            UtcClock::format(t + static_cast<int64_t>(i) * 1000, text, 6);
+            doNotOptimize(text[25]);
+        }
+    });
+
+    runner.add("timers/TimerWheel schedule+cancel", [](uint64_t n)
+    {
+        static TimerWheel wheel(std::chrono::milliseconds(1), 0);
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            TimerWheel::TimerId id = wheel.schedule(std::chrono::milliseconds(1 + (i & 4095)), []() {});
+            wheel.cancel(id);
+        }
+    });
+}
+
+int main(int argc, char** argv)
+{
+    std::string filter;
+    std::string jsonPath;
+    BenchmarkRunner runner;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if (arg == "--json" && i + 1 < argc)
+        {
+            jsonPath = argv[++i];
+        }
+        else if (arg == "--runs" && i + 1 < argc)
+        {
+            runner.timedRuns = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--warmup" && i + 1 < argc)
+        {
+            runner.warmupRuns = std::max(0, std::stoi(argv[++i]));
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--filter SUBSTRING] [--json FILE|-] [--runs N] [--warmup N]" << std::endl;
+            return 1;
+        }
+    }
+
+    registerGeodesy(runner);
+    registerBitHacks(runner);
+    registerEndian(runner);
+    registerNtp(runner);
+    registerXml(runner);
+    registerValidators(runner);
+    registerTimers(runner);
+
+    std::vector<BenchmarkResult> results = runner.run(filter);
+
+    if (jsonPath == "-")
+    {
+        BenchmarkRunner::writeJson(std::cout, results);
+    }
+    else if (!jsonPath.empty())
+    {
+        std::ofstream out(jsonPath);
+        if (!out)
+        {
+            std::cerr << "Failed to open " << jsonPath << std::endl;
+            return 1;
+        }
+        BenchmarkRunner::writeJson(out, results);
+    }
+    return 0;
+}
@@ -1,8 +1,10 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <climits>
 #include <iostream>
 #include <algorithm>
+#include "BitHacks.hpp"
 
 //Compute the sign of an integer
 int sign(int x) 
@@ -13,7 +15,7 @@ int sign(int x)
 //Compute the integer absolute value (abs) without branching 
 int abs_no_branching(int x) 
 {
-    int const mask = x >> sizeof(int) * CHAR_BIT - 1;
+    int const mask = x >> (sizeof(int) * CHAR_BIT - 1);
     return (x + mask) ^ mask;
 }
 
@@ -59,7 +61,7 @@ int max_no_branch(int a, int b) {
 
 
 // Swapping values with subtraction and addition 
-void swap(int& a, int& b) 
+void swapAddSub(int& a, int& b) 
 {
     a = a + b;
     b = a - b;
@@ -67,7 +69,7 @@ void swap(int& a, int& b)
 }
 
 //Swapping values with XOR 
-void swap(int& a, int& b) 
+void swapXor(int& a, int& b) 
 {
     a = a ^ b;
     b = a ^ b;
@@ -75,8 +77,6 @@ void swap(int& a, int& b)
 }
 
 // Swapping individual bits with XOR 
-#include <bitset>
-using namespace std;
 int swapBits(int n, int i, int j) 
 {
     // Create a bit mask with 1s at positions i and j
@@ -87,9 +87,7 @@ int swapBits(int n, int i, int j)
 }
 
 // Reverse bits the obvious way 
-#include <iostream>
-#include <bitset>
-uint32_t reverseBits(uint32_t n) 
+uint32_t reverseBitsObvious(uint32_t n) 
 {
     uint32_t reversed = 0;
     for (int i = 0; i < 32; i++) 
@@ -102,9 +100,6 @@ uint32_t reverseBits(uint32_t n)
 }
 
 // Reverse bits in word by lookup table 
-#include <iostream>
-#include <bitset>
-
 uint32_t reverseBits(uint32_t n) 
 {
     static const uint32_t lookupTable[16] = 
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+
+//Compute the sign of an integer
+int sign(int x);
+
+//Compute the integer absolute value (abs) without branching 
+int abs_no_branching(int x);
+
+//Detect if two integers have opposite signs
+bool haveOppositeSign(int a, int b);
+
+//Compute the minimum (min) or maximum (max) of two integers without branching 
+int min_no_branch(int a, int b);
+int max_no_branch(int a, int b);
+
+// Swapping values with subtraction and addition 
+void swapAddSub(int& a, int& b);
+
+//Swapping values with XOR 
+void swapXor(int& a, int& b);
+
+// Swapping individual bits with XOR 
+int swapBits(int n, int i, int j);
+
+// Reverse bits the obvious way 
+uint32_t reverseBitsObvious(uint32_t n);
+
+// Reverse bits in word by lookup table 
+uint32_t reverseBits(uint32_t n);
+
+// Function to check if a number is a power of 2
+int isPowerOfTwo(uint32_t n);
+
+// Function to count the number of set bits in an integer
+int countSetBits(uint32_t n);
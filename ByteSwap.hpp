@@ -0,0 +1,317 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#if __has_include(<bit>)
+#include <bit>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BYTESWAP_HAVE_X86 1
+#endif
+
+// Single-value swaps. These compile to one bswap/rol instruction.
+constexpr uint16_t bswap16(uint16_t v)
+{
+#if defined(__cpp_lib_byteswap)
+    return std::byteswap(v);
+#else
+    return __builtin_bswap16(v);
+#endif
+}
+
+constexpr uint32_t bswap32(uint32_t v)
+{
+#if defined(__cpp_lib_byteswap)
+    return std::byteswap(v);
+#else
+    return __builtin_bswap32(v);
+#endif
+}
+
+constexpr uint64_t bswap64(uint64_t v)
+{
+#if defined(__cpp_lib_byteswap)
+    return std::byteswap(v);
+#else
+    return __builtin_bswap64(v);
+#endif
+}
+
+// Swap any trivially copyable value of width 1/2/4/8 without type punning
+template <typename T>
+inline T bswapValue(T value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "bswapValue needs a trivially copyable type");
+    static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8, "unsupported width");
+    if constexpr (sizeof(T) == 1)
+    {
+        return value;
+    }
+    else if constexpr (sizeof(T) == 2)
+    {
+        uint16_t u;
+        std::memcpy(&u, &value, 2);
+        u = bswap16(u);
+        std::memcpy(&value, &u, 2);
+    }
+    else if constexpr (sizeof(T) == 4)
+    {
+        uint32_t u;
+        std::memcpy(&u, &value, 4);
+        u = bswap32(u);
+        std::memcpy(&value, &u, 4);
+    }
+    else
+    {
+        uint64_t u;
+        std::memcpy(&u, &value, 8);
+        u = bswap64(u);
+        std::memcpy(&value, &u, 8);
+    }
+    return value;
+}
+
+constexpr bool hostIsLittleEndian()
+{
+    return __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+}
+
+// Endian-aware loads and stores from unaligned byte buffers
+template <typename T>
+inline T loadBE(const void* p)
+{
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    return hostIsLittleEndian() ? bswapValue(v) : v;
+}
+
+template <typename T>
+inline T loadLE(const void* p)
+{
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    return hostIsLittleEndian() ? v : bswapValue(v);
+}
+
+template <typename T>
+inline void storeBE(void* p, T v)
+{
+    v = hostIsLittleEndian() ? bswapValue(v) : v;
+    std::memcpy(p, &v, sizeof(T));
+}
+
+template <typename T>
+inline void storeLE(void* p, T v)
+{
+    v = hostIsLittleEndian() ? v : bswapValue(v);
+    std::memcpy(p, &v, sizeof(T));
+}
+
+namespace byteswap_detail
+{
+
+// Bulk kernel signature: swap n elements of the given width from src to dst.
+// src == dst is allowed (in-place); partial overlap is not.
+typedef void (*SwapFn)(const void* src, void* dst, size_t n);
+
+template <typename U, U (*Swap)(U)>
+inline void swapScalar(const void* src, void* dst, size_t n)
+{
+    const unsigned char* s = static_cast<const unsigned char*>(src);
+    unsigned char* d = static_cast<unsigned char*>(dst);
+    for (size_t i = 0; i < n; ++i)
+    {
+        U v;
+        std::memcpy(&v, s + i * sizeof(U), sizeof(U));
+        v = Swap(v);
+        std::memcpy(d + i * sizeof(U), &v, sizeof(U));
+    }
+}
+
+inline uint16_t swap16(uint16_t v) { return bswap16(v); }
+inline uint32_t swap32(uint32_t v) { return bswap32(v); }
+inline uint64_t swap64(uint64_t v) { return bswap64(v); }
+
+inline void scalar16(const void* s, void* d, size_t n) { swapScalar<uint16_t, swap16>(s, d, n); }
+inline void scalar32(const void* s, void* d, size_t n) { swapScalar<uint32_t, swap32>(s, d, n); }
+inline void scalar64(const void* s, void* d, size_t n) { swapScalar<uint64_t, swap64>(s, d, n); }
+
+#if defined(BYTESWAP_HAVE_X86)
+
+// pshufb control reversing each Width-byte lane of a 16-byte vector
+template <size_t Width>
+struct ShuffleMask
+{
+    alignas(32) unsigned char bytes[32];
+
+    constexpr ShuffleMask() : bytes()
+    {
+        for (size_t i = 0; i < 32; ++i)
+        {
+            size_t lane = (i % 16) / Width * Width;
+            bytes[i] = static_cast<unsigned char>(lane + (Width - 1 - (i % 16) % Width));
+        }
+    }
+};
+
+template <size_t Width>
+__attribute__((target("ssse3")))
+inline void swapSSSE3(const void* src, void* dst, size_t n)
+{
+    static constexpr ShuffleMask<Width> mask;
+    const __m128i m = _mm_load_si128(reinterpret_cast<const __m128i*>(mask.bytes));
+    const unsigned char* s = static_cast<const unsigned char*>(src);
+    unsigned char* d = static_cast<unsigned char*>(dst);
+    size_t bytes = n * Width;
+    size_t i = 0;
+    for (; i + 32 <= bytes; i += 32)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), _mm_shuffle_epi8(a, m));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i + 16), _mm_shuffle_epi8(b, m));
+    }
+    for (; i + 16 <= bytes; i += 16)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), _mm_shuffle_epi8(a, m));
+    }
+    if (Width == 2) scalar16(s + i, d + i, (bytes - i) / Width);
+    if (Width == 4) scalar32(s + i, d + i, (bytes - i) / Width);
+    if (Width == 8) scalar64(s + i, d + i, (bytes - i) / Width);
+}
+
+template <size_t Width>
+__attribute__((target("avx2")))
+inline void swapAVX2(const void* src, void* dst, size_t n)
+{
+    static constexpr ShuffleMask<Width> mask;
+    const __m256i m = _mm256_load_si256(reinterpret_cast<const __m256i*>(mask.bytes));
+    const unsigned char* s = static_cast<const unsigned char*>(src);
+    unsigned char* d = static_cast<unsigned char*>(dst);
+    size_t bytes = n * Width;
+    size_t i = 0;
+    for (; i + 64 <= bytes; i += 64)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i + 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + i), _mm256_shuffle_epi8(a, m));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + i + 32), _mm256_shuffle_epi8(b, m));
+    }
+    for (; i + 32 <= bytes; i += 32)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + i), _mm256_shuffle_epi8(a, m));
+    }
+    if (Width == 2) scalar16(s + i, d + i, (bytes - i) / Width);
+    if (Width == 4) scalar32(s + i, d + i, (bytes - i) / Width);
+    if (Width == 8) scalar64(s + i, d + i, (bytes - i) / Width);
+}
+
+#endif
+
+enum class SwapKernel
+{
+    Scalar,
+    SSSE3,
+    AVX2
+};
+
+// Best kernel the running CPU supports, probed once
+inline SwapKernel bestKernel()
+{
+#if defined(BYTESWAP_HAVE_X86)
+    static const SwapKernel best = []()
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return SwapKernel::AVX2;
+        }
+        if (__builtin_cpu_supports("ssse3"))
+        {
+            return SwapKernel::SSSE3;
+        }
+        return SwapKernel::Scalar;
+    }();
+    return best;
+#else
+    return SwapKernel::Scalar;
+#endif
+}
+
+template <size_t Width>
+inline SwapFn kernelFor(SwapKernel kernel)
+{
+#if defined(BYTESWAP_HAVE_X86)
+    if (kernel == SwapKernel::AVX2)
+    {
+        return swapAVX2<Width>;
+    }
+    if (kernel == SwapKernel::SSSE3)
+    {
+        return swapSSSE3<Width>;
+    }
+#else
+    (void)kernel;
+#endif
+    return Width == 2 ? scalar16 : Width == 4 ? scalar32 : scalar64;
+}
+
+template <size_t Width>
+inline SwapFn dispatch()
+{
+    static const SwapFn fn = kernelFor<Width>(bestKernel());
+    return fn;
+}
+
+} // namespace byteswap_detail
+
+// Bulk byte swap of n elements, out-of-place (src and dst must not partially overlap)
+template <typename T>
+inline void swapBytesArray(const T* src, T* dst, size_t n)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "swapBytesArray needs a trivially copyable type");
+    static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8, "unsupported width");
+    if constexpr (sizeof(T) == 1)
+    {
+        if (src != dst)
+        {
+            std::memmove(dst, src, n);
+        }
+    }
+    else
+    {
+        byteswap_detail::dispatch<sizeof(T)>()(src, dst, n);
+    }
+}
+
+// Bulk byte swap of n elements in place
+template <typename T>
+inline void swapBytesArray(T* data, size_t n)
+{
+    swapBytesArray<T>(data, data, n);
+}
+
+// Convert an array between host order and big-endian (network) order; a no-op copy on big-endian hosts
+template <typename T>
+inline void hostToBigEndianArray(const T* src, T* dst, size_t n)
+{
+    if (hostIsLittleEndian())
+    {
+        swapBytesArray(src, dst, n);
+    }
+    else if (src != dst)
+    {
+        std::memmove(dst, src, n * sizeof(T));
+    }
+}
+
+template <typename T>
+inline void bigEndianToHostArray(const T* src, T* dst, size_t n)
+{
+    hostToBigEndianArray(src, dst, n);
+}
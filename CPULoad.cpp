@@ -1,58 +1,150 @@
-
 #include <iostream>
-#include <fstream>
 #include <string>
 #include <vector>
-#include <sstream>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "CpuSampler.hpp"
 
-std::vector<std::string> split(const std::string& str, char delim) 
+// PIDs whose /proc/<pid>/comm equals processName
+std::vector<pid_t> findProcesses(const std::string& processName)
 {
-    std::vector<std::string> tokens;
-    std::stringstream ss(str);
-    std::string token;
-    while (std::getline(ss, token, delim)) 
+    std::vector<pid_t> pids;
+    DIR* dir = opendir("/proc");
+    if (dir == nullptr)
     {
-        tokens.push_back(token);
+        return pids;
     }
-    return tokens;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        char* end;
+        long pid = strtol(entry->d_name, &end, 10);
+        if (*end != '\0' || pid <= 0)
+        {
+            continue;
+        }
+        char path[64];
+        char comm[64];
+        snprintf(path, sizeof(path), "/proc/%ld/comm", pid);
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            continue;
+        }
+        ssize_t n = read(fd, comm, sizeof(comm) - 1);
+        close(fd);
+        if (n > 0)
+        {
+            comm[n - 1] = '\0'; // drop the trailing newline
+            if (processName == comm)
+            {
+                pids.push_back(static_cast<pid_t>(pid));
+            }
+        }
+    }
+    closedir(dir);
+    return pids;
 }
 
-double getCPULoad(const std::string& processName) 
+// CPU load of every process named processName over interval, as a percentage
+// of one core (so a process saturating two cores reports 200)
+double getCPULoad(const std::string& processName, std::chrono::milliseconds interval = std::chrono::milliseconds(500))
 {
-    std::ifstream stat("/proc/stat");
-    std::string line;
-    std::getline(stat, line);
-    std::vector<std::string> tokens = split(line, ' ');
+    CpuSampler sampler;
+    for (pid_t pid : findProcesses(processName))
+    {
+        sampler.watch(pid);
+    }
+    sampler.sample();
+    std::this_thread::sleep_for(interval);
+    sampler.sample();
 
-    unsigned long long user = std::stoull(tokens[1]);
-    unsigned long long nice = std::stoull(tokens[2]);
-    unsigned long long system = std::stoull(tokens[3]);
-    unsigned long long idle = std::stoull(tokens[4]);
+    double load = 0.0;
+    sampler.forEachProcess([&](pid_t, double l) { load += l; });
+    return load;
+}
+
+static double cpuSeconds()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
 
-    std::ifstream proc("/proc/stat");
-    std::string procLine;
-    while (std::getline(proc, procLine)) 
+// Sample every process at 10 Hz and report what the sampler itself costs
+static void benchmarkSampler(int seconds)
+{
+    CpuSampler sampler;
+    size_t watched = sampler.watchAll();
+    sampler.sample();
+
+    const int hz = 10;
+    auto next = std::chrono::steady_clock::now();
+    double cpuStart = cpuSeconds();
+    int64_t sampleNs = 0;
+    for (int i = 0; i < seconds * hz; ++i)
     {
-        if (procLine.find(processName) != std::string::npos) 
-        {
-            std::vector<std::string> procTokens = split(procLine, ' ');
-            unsigned long long procUser = std::stoull(procTokens[13]);
-            unsigned long long procSystem = std::stoull(procTokens[14]);
+        next += std::chrono::milliseconds(1000 / hz);
+        std::this_thread::sleep_until(next);
+        int64_t t0 = procfs::monotonicNs();
+        sampler.sample();
+        sampleNs += procfs::monotonicNs() - t0;
+    }
+    double cpu = cpuSeconds() - cpuStart;
 
-            unsigned long long totalCPU = user + nice + system + idle;
-            unsigned long long procCPU = procUser + procSystem;
+    // Fixed /proc/stat cost, measured with no processes watched
+    CpuSampler systemOnly;
+    int64_t t0 = procfs::monotonicNs();
+    for (int i = 0; i < 100; ++i)
+    {
+        systemOnly.sample();
+    }
+    double systemNs = (procfs::monotonicNs() - t0) / 100.0;
+    double perSampleNs = sampleNs / static_cast<double>(seconds * hz);
+    double perProcessNs = std::max(0.0, perSampleNs - systemNs) / std::max<size_t>(1, sampler.processCount());
 
-            double cpuLoad = static_cast<double>(procCPU) / totalCPU * 100.0;
-            return cpuLoad;
-        }
+    std::cout << "Watched " << watched << " processes on " << sampler.coreCount() << " cores at " << hz << " Hz for "
+              << seconds << " s" << std::endl;
+    std::cout << "  sampler CPU: " << 100.0 * cpu / seconds << "% of a core" << std::endl;
+    std::cout << "  /proc/stat per sample: " << systemNs << " ns, per process per sample: " << perProcessNs << " ns"
+              << std::endl;
+    // The target was 5000 PIDs at 10 Hz in under 1% of a core. Each PID
+    // costs one pread() of schedstat, and at a 10 Hz cadence the caches are
+    // cold again by every sample, so this is usually missed
+    double projected = 100.0 * (systemNs + perProcessNs * 5000) * hz / 1e9;
+    std::cout << "  projected for 5000 processes at 10 Hz: " << projected << "% of a core ("
+              << (projected < 1.0 ? "within" : "MISSES") << " the 1% target)" << std::endl;
+
+    std::cout << "Per-core load:";
+    for (size_t c = 0; c < sampler.coreCount(); ++c)
+    {
+        std::cout << " cpu" << c << "=" << sampler.coreLoad(c) << "%";
     }
+    std::cout << std::endl;
 
-    return 0.0;
+    std::vector<std::pair<double, pid_t>> top;
+    sampler.forEachProcess([&](pid_t pid, double l) { top.push_back(std::make_pair(l, pid)); });
+    std::sort(top.rbegin(), top.rend());
+    for (size_t i = 0; i < top.size() && i < 5; ++i)
+    {
+        std::cout << "  pid " << top[i].second << ": " << top[i].first << "%" << std::endl;
+    }
 }
 
-int main() 
+int main(int argc, char** argv)
 {
-    std::string processName = "your_process_name";
+    if (argc > 1 && std::string(argv[1]) == "--bench")
+    {
+        benchmarkSampler(argc > 2 ? atoi(argv[2]) : 3);
+        return 0;
+    }
+
+    std::string processName = argc > 1 ? argv[1] : "your_process_name";
     double cpuLoad = getCPULoad(processName);
     std::cout << "CPU Load for " << processName << ": " << cpuLoad << "%" << std::endl;
     return 0;
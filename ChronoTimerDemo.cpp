@@ -6,19 +6,24 @@
 
 using namespace std;
 
+// Fires callback every interval ms against absolute deadlines, so the
+// schedule does not drift with callback time and the thread sleeps in between
 void periodicTimer(int interval, const function<void()>& callback) 
 {
-    auto start = chrono::steady_clock::now();
+    auto period = chrono::milliseconds(interval);
+    auto next = chrono::steady_clock::now() + period;
     while (true) 
     {
+        this_thread::sleep_until(next);
+        callback();
+        next += period;
+
+        // Skip missed periods instead of firing a burst to catch up
         auto now = chrono::steady_clock::now();
-        auto elapsed = chrono::duration_cast<chrono::milliseconds>(now - start).count();
-        if (elapsed >= interval) 
+        if (next <= now) 
         {
-            callback();
-            start = now;
+            next += ((now - next) / period + 1) * period;
         }
-        this_thread::sleep_for(chrono::milliseconds(1));
     }
 }
 
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <sys/timex.h>
+#include "NtpTime.hpp"
+
+// Clock discipline loop in the style of RFC 5905 section 11.3: offset
+// samples (server clock minus local clock, e.g. SntpResult::offset) steer
+// the local clock's frequency so it converges on the servers without the
+// time ever jumping.
+//
+//   - The first sample (or the first after a step) starts a frequency
+//     measurement: nothing is corrected until stepout has passed, then the
+//     frequency error is the offset drift over that interval.
+//   - After that, each sample updates the frequency as a type-II PLL (the
+//     integral of offset, time constant 4 * tau) plus, for sample intervals
+//     beyond the Allan intercept, an FLL term (the offset left over that
+//     the frequency should have removed). The phase is slewed off at
+//     offset / tau on top of the frequency, so it decays smoothly.
+//   - Offsets beyond stepThreshold are treated as spikes and ignored; if
+//     they persist for stepout the clock is stepped once and the
+//     frequency measurement starts again.
+//
+// The clock is a policy class, so the loop runs unchanged against
+// KernelClock (adjtimex) or a simulated clock:
+//   bool step(int64_t ns);            // move the time by ns
+//   bool setFrequency(double ppm);    // rate correction, positive = faster
+//   bool setSynchronized(int64_t estimatedError, int64_t maxError);
+
+struct ClockDisciplineOptions
+{
+    int64_t stepThreshold = 128000000;      ///< ns; 0 never steps
+    int64_t stepout = 300000000000LL;       ///< Spike persistence and frequency measurement time, ns
+    double tau = 256;                       ///< Phase time constant, s (keep above twice the sample interval)
+    double allanIntercept = 1500;           ///< Sample intervals beyond this use the FLL too, s
+    double maxFrequency = 500;              ///< Kernel limit for the total correction, ppm
+};
+
+struct ClockDisciplineStats
+{
+    enum State
+    {
+        Unset,      ///< No sample yet
+        Frequency,  ///< Measuring the frequency error
+        Sync,       ///< Tracking
+        Spike       ///< Ignoring an offset beyond the step threshold
+    };
+
+    State state = Unset;
+    int64_t offset = 0;       ///< Last accepted offset, ns
+    double frequency = 0;     ///< Frequency correction, ppm (excluding the phase slew)
+    double jitter = 0;        ///< RMS of offset differences between samples, ns
+    double wander = 0;        ///< RMS of frequency changes between samples, ppm
+    uint64_t updates = 0;
+    uint64_t steps = 0;
+    uint64_t spikes = 0;      ///< Samples ignored as spikes
+};
+
+// The system clock through clock_adjtime(CLOCK_REALTIME). Setting needs
+// CAP_SYS_TIME, and no other NTP daemon should be adjusting the clock.
+class KernelClock
+{
+public:
+    KernelClock()
+    {
+        struct timex tx;
+        memset(&tx, 0, sizeof(tx));
+        status_ = clock_adjtime(CLOCK_REALTIME, &tx) >= 0 ? tx.status : STA_UNSYNC;
+        frequency_ = tx.freq / 65536.0;
+        // The kernel's own PLL/FLL would fight this loop
+        status_ &= ~(STA_PLL | STA_FLL | STA_PPSFREQ | STA_PPSTIME);
+    }
+
+    // Frequency correction found at startup, e.g. left by a previous run
+    double initialFrequency() const { return frequency_; }
+
+    bool step(int64_t ns)
+    {
+        struct timex tx;
+        memset(&tx, 0, sizeof(tx));
+        tx.modes = ADJ_SETOFFSET | ADJ_NANO;
+        int64_t s = ntp_detail::floorSeconds(ns);
+        tx.time.tv_sec = static_cast<time_t>(s);
+        tx.time.tv_usec = static_cast<long>(ns - s * ntp_detail::kNanosPerSecond); // nanoseconds with ADJ_NANO
+        return clock_adjtime(CLOCK_REALTIME, &tx) >= 0;
+    }
+
+    bool setFrequency(double ppm)
+    {
+        struct timex tx;
+        memset(&tx, 0, sizeof(tx));
+        tx.modes = ADJ_FREQUENCY | ADJ_STATUS;
+        tx.freq = std::lround(ppm * 65536.0); // 16.16 fixed point ppm
+        tx.status = status_;
+        return clock_adjtime(CLOCK_REALTIME, &tx) >= 0;
+    }
+
+    // Clears STA_UNSYNC and publishes the error bounds (seen by ntp_gettime()
+    // and adjtimex -p); the kernel ages maxError by itself between updates
+    bool setSynchronized(int64_t estimatedError, int64_t maxError)
+    {
+        status_ &= ~STA_UNSYNC;
+        struct timex tx;
+        memset(&tx, 0, sizeof(tx));
+        tx.modes = ADJ_STATUS | ADJ_ESTERROR | ADJ_MAXERROR;
+        tx.status = status_;
+        tx.esterror = static_cast<long>(estimatedError / 1000);
+        tx.maxerror = static_cast<long>(maxError / 1000);
+        return clock_adjtime(CLOCK_REALTIME, &tx) >= 0;
+    }
+
+private:
+    int status_;
+    double frequency_;
+};
+
+template <typename Clock = KernelClock>
+class ClockDiscipline
+{
+public:
+    typedef ClockDisciplineStats::State State;
+
+    explicit ClockDiscipline(Clock clock = Clock(), ClockDisciplineOptions options = ClockDisciplineOptions(),
+                             double initialFrequency = 0)
+        : clock_(std::move(clock)), options_(options)
+    {
+        stats_.frequency = initialFrequency;
+    }
+
+    enum Action
+    {
+        Ignored,    ///< Spike, or frequency measurement still running
+        Slewed,
+        Stepped,
+        Failed      ///< The clock refused the adjustment (errno is set)
+    };
+
+    // Feed one offset sample (server minus local, ns) taken at now, a
+    // monotonic time in ns (e.g. CLOCK_MONOTONIC)
+    Action update(int64_t offset, int64_t now)
+    {
+        double mu = static_cast<double>(now - last_) / 1e9;
+        bool big = options_.stepThreshold > 0 && std::llabs(offset) > options_.stepThreshold;
+        if (big && stats_.state != ClockDisciplineStats::Unset)
+        {
+            // Spike: ignore it unless it lasts
+            if (stats_.state != ClockDisciplineStats::Spike)
+            {
+                resume_ = stats_.state;
+                stats_.state = ClockDisciplineStats::Spike;
+                spikeStart_ = now;
+            }
+            if (now - spikeStart_ < options_.stepout)
+            {
+                stats_.spikes++;
+                return Ignored;
+            }
+        }
+        stats_.updates++;
+        if (big)
+        {
+            if (!clock_.step(offset) || !clock_.setFrequency(stats_.frequency))
+            {
+                return Failed;
+            }
+            stats_.steps++;
+            startFrequency(0, now);
+            return Stepped;
+        }
+
+        if (stats_.state == ClockDisciplineStats::Spike)
+        {
+            stats_.state = resume_;
+        }
+        if (stats_.state == ClockDisciplineStats::Unset)
+        {
+            startFrequency(offset, now);
+            return clock_.setFrequency(stats_.frequency) ? Ignored : Failed;
+        }
+
+        double diff = static_cast<double>(offset - stats_.offset);
+        stats_.jitter = std::sqrt(stats_.jitter * stats_.jitter + (diff * diff - stats_.jitter * stats_.jitter) / 4);
+        double before = stats_.frequency;
+        if (stats_.state == ClockDisciplineStats::Frequency)
+        {
+            double elapsed = static_cast<double>(now - measureStart_) / 1e9;
+            if (now - measureStart_ < options_.stepout)
+            {
+                stats_.offset = offset;
+                last_ = now;
+                return Ignored;
+            }
+            // ns of drift per second is ppb
+            stats_.frequency += static_cast<double>(offset - measureOffset_) / elapsed / 1000;
+            stats_.state = ClockDisciplineStats::Sync;
+        }
+        else
+        {
+            // The offset the last command should have left if the frequency
+            // were right; the FLL corrects the frequency by the difference
+            double predicted = static_cast<double>(stats_.offset) - phaseRate_ * 1000 * mu;
+            // No integration while the slew is at the limit, or a large
+            // offset winds the frequency up and overshoots
+            double pll = 4 * options_.tau;
+            if (std::fabs(stats_.frequency + static_cast<double>(offset) / options_.tau / 1000) < options_.maxFrequency)
+            {
+                stats_.frequency += static_cast<double>(offset) * std::min(mu, options_.tau) / (pll * pll) / 1000;
+            }
+            if (mu >= options_.allanIntercept)
+            {
+                stats_.frequency += (static_cast<double>(offset) - predicted) / mu / 1000 / 4;
+            }
+        }
+        stats_.frequency = clamp(stats_.frequency);
+        double change = stats_.frequency - before;
+        stats_.wander = std::sqrt(stats_.wander * stats_.wander + (change * change - stats_.wander * stats_.wander) / 4);
+        stats_.offset = offset;
+        last_ = now;
+
+        // Frequency plus a slew that removes the offset over tau
+        double command = clamp(stats_.frequency + static_cast<double>(offset) / options_.tau / 1000);
+        phaseRate_ = command - stats_.frequency;
+        if (!clock_.setFrequency(command))
+        {
+            return Failed;
+        }
+        clock_.setSynchronized(std::llabs(offset) / 2 + static_cast<int64_t>(stats_.jitter),
+                               std::llabs(offset) + static_cast<int64_t>(3 * stats_.jitter));
+        return Slewed;
+    }
+
+    // Monotonic ns for update()
+    static int64_t monotonicNanos()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * ntp_detail::kNanosPerSecond + ts.tv_nsec;
+    }
+
+    const ClockDisciplineStats& stats() const { return stats_; }
+    const ClockDisciplineOptions& options() const { return options_; }
+    Clock& clock() { return clock_; }
+
+private:
+    void startFrequency(int64_t offset, int64_t now)
+    {
+        stats_.state = ClockDisciplineStats::Frequency;
+        stats_.offset = offset;
+        measureOffset_ = offset;
+        measureStart_ = now;
+        last_ = now;
+        phaseRate_ = 0;
+    }
+
+    double clamp(double ppm) const
+    {
+        return std::max(-options_.maxFrequency, std::min(options_.maxFrequency, ppm));
+    }
+
+    Clock clock_;
+    ClockDisciplineOptions options_;
+    ClockDisciplineStats stats_;
+    State resume_ = ClockDisciplineStats::Unset;   ///< State to return to after a spike
+    int64_t last_ = 0;           ///< Time of the last accepted sample
+    int64_t spikeStart_ = 0;
+    int64_t measureStart_ = 0;   ///< Frequency measurement start time and offset
+    int64_t measureOffset_ = 0;
+    double phaseRate_ = 0;       ///< Slew in the last command, ppm
+};
@@ -0,0 +1,206 @@
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "ClockDiscipline.hpp"
+
+// Local clock that gains driftPpm against true time, plus whatever
+// frequency correction the discipline commands. Records what a program
+// reading the clock would see: jumps, and how far the rate is pulled.
+class SimulatedClock
+{
+public:
+    explicit SimulatedClock(double driftPpm, int64_t initialOffset = 0)
+        : drift_(driftPpm), correction_(0), true_(0), local_(-initialOffset), steps_(0), maxJump_(0), maxRate_(0)
+    {
+    }
+
+    void advance(int64_t ns)
+    {
+        true_ += ns;
+        local_ += ns + std::llround(static_cast<double>(ns) * (drift_ + correction_) * 1e-6);
+    }
+
+    // Server minus local, as an ideal NTP measurement would give
+    int64_t offset() const { return true_ - local_; }
+    int64_t trueTime() const { return true_; }
+    void setDrift(double ppm) { drift_ = ppm; }
+    void jump(int64_t ns) { local_ += ns; }
+
+    bool step(int64_t ns)
+    {
+        local_ += ns;
+        steps_++;
+        maxJump_ = std::max(maxJump_, std::abs(ns));
+        return true;
+    }
+
+    bool setFrequency(double ppm)
+    {
+        correction_ = ppm;
+        maxRate_ = std::max(maxRate_, std::fabs(ppm));
+        return true;
+    }
+
+    bool setSynchronized(int64_t, int64_t) { return true; }
+
+    int steps() const { return steps_; }
+    int64_t maxJump() const { return maxJump_; }
+    double maxRate() const { return maxRate_; }
+
+private:
+    double drift_, correction_;
+    int64_t true_, local_;
+    int steps_;
+    int64_t maxJump_;
+    double maxRate_;
+};
+
+static bool check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        std::cerr << "Self-test failed: " << what << std::endl;
+    }
+    return ok;
+}
+
+#define SELF_CHECK(cond) ok &= check((cond), #cond)
+
+static const int64_t kSecond = 1000000000;
+static const int64_t kMinute = 60 * kSecond;
+
+struct RunSummary
+{
+    double rmsOffset;      ///< True offset over the last quarter of the run, ns
+    int64_t worstOffset;
+};
+
+// Two days of one-minute samples with 300 us of measurement noise. Along the
+// way: one wild sample (hour 10), the clock set back 3 s behind the loop's
+// back (hour 20), and the oscillator warming up by 1 ppm (hour 30).
+template <typename Correct>
+static RunSummary simulate(SimulatedClock& clock, Correct correct)
+{
+    std::mt19937_64 rng(48);
+    std::normal_distribution<double> noise(0, 300000);
+    const int minutes = 48 * 60;
+    double sum = 0;
+    int counted = 0;
+    int64_t worst = 0;
+    for (int m = 1; m <= minutes; ++m)
+    {
+        clock.advance(kMinute);
+        if (m == 20 * 60)
+        {
+            clock.jump(-3 * kSecond);
+        }
+        if (m == 30 * 60)
+        {
+            clock.setDrift(38.5);
+        }
+        int64_t measured = clock.offset() + std::llround(noise(rng));
+        if (m == 10 * 60)
+        {
+            measured += 2 * kSecond;
+        }
+        correct(measured, clock.trueTime());
+        if (m > minutes * 3 / 4)
+        {
+            double o = static_cast<double>(clock.offset());
+            sum += o * o;
+            counted++;
+            worst = std::max(worst, std::abs(clock.offset()));
+        }
+    }
+    return RunSummary{std::sqrt(sum / counted), worst};
+}
+
+static bool selfTest()
+{
+    bool ok = true;
+
+    // Noiseless: 100 ppm fast and 10 ms behind is slewed out without a step,
+    // and the frequency measurement lands on the drift
+    {
+        ClockDiscipline<SimulatedClock> d(SimulatedClock(100, 10000000));
+        for (int m = 0; m <= 12 * 60; ++m)
+        {
+            d.update(d.clock().offset(), d.clock().trueTime());
+            d.clock().advance(kMinute);
+        }
+        SELF_CHECK(d.clock().steps() == 0);
+        SELF_CHECK(std::abs(d.clock().offset()) < 1000);
+        SELF_CHECK(std::fabs(d.stats().frequency + 100) < 0.01);
+        SELF_CHECK(d.stats().state == ClockDisciplineStats::Sync);
+    }
+
+    // A first sample beyond the threshold steps at once; with the threshold
+    // at 0 a 1 s error is slewed at the 500 ppm limit instead
+    {
+        ClockDiscipline<SimulatedClock> d(SimulatedClock(0, 5 * kSecond));
+        SELF_CHECK(d.update(d.clock().offset(), 0) == ClockDiscipline<SimulatedClock>::Stepped);
+        SELF_CHECK(d.clock().offset() == 0 && d.stats().state == ClockDisciplineStats::Frequency);
+
+        ClockDisciplineOptions slewOnly;
+        slewOnly.stepThreshold = 0;
+        ClockDiscipline<SimulatedClock> s(SimulatedClock(0, kSecond), slewOnly);
+        for (int m = 0; m <= 4 * 60; ++m)
+        {
+            s.update(s.clock().offset(), s.clock().trueTime());
+            s.clock().advance(kMinute);
+        }
+        SELF_CHECK(s.clock().steps() == 0 && s.clock().maxRate() <= 500);
+        SELF_CHECK(std::abs(s.clock().offset()) < 1000000);
+    }
+
+    // The noisy two days, against ntpdate once a minute (step by the
+    // measured offset every time)
+    SimulatedClock stepped(37.5, 40000000);
+    RunSummary ntpdate = simulate(stepped, [&](int64_t offset, int64_t) { stepped.step(offset); });
+
+    ClockDiscipline<SimulatedClock> d(SimulatedClock(37.5, 40000000));
+    RunSummary loop = simulate(d.clock(), [&](int64_t offset, int64_t now) { d.update(offset, now); });
+    const ClockDisciplineStats& st = d.stats();
+    SELF_CHECK(d.clock().steps() == 1 && std::abs(d.clock().maxJump() - 3 * kSecond) < 5000000);
+    SELF_CHECK(st.spikes == 1 + 5); // the wild sample, then the 3 s error until stepout
+    SELF_CHECK(std::fabs(st.frequency + 38.5) < 0.5);
+    SELF_CHECK(d.clock().maxRate() <= 500);
+    SELF_CHECK(loop.rmsOffset < ntpdate.rmsOffset / 2);
+
+    std::cout << "Two days, 1 min samples, 300 us noise, drift 37.5 -> 38.5 ppm:" << std::endl;
+    std::cout << "  ntpdate each minute: " << stepped.steps() << " steps (largest " << stepped.maxJump() / 1000
+              << " us), offset rms " << ntpdate.rmsOffset / 1000 << " us, worst " << ntpdate.worstOffset / 1000 << " us"
+              << std::endl;
+    std::cout << "  discipline:          " << d.clock().steps() << " step (the 3 s jump), " << st.spikes
+              << " spike samples ignored, offset rms " << loop.rmsOffset / 1000 << " us, worst " << loop.worstOffset / 1000
+              << " us" << std::endl;
+    std::cout << "  frequency " << st.frequency << " ppm, jitter " << st.jitter / 1000 << " us, wander " << st.wander
+              << " ppm, largest rate change " << d.clock().maxRate() << " ppm" << std::endl;
+
+    if (ok)
+    {
+        std::cout << "Self-test passed" << std::endl;
+    }
+    return ok;
+}
+
+int main()
+{
+    if (!selfTest())
+    {
+        return 1;
+    }
+
+    // The real clock's state, read only
+    struct timex tx;
+    memset(&tx, 0, sizeof(tx));
+    if (adjtimex(&tx) >= 0)
+    {
+        std::cout << "Kernel clock: frequency " << tx.freq / 65536.0 << " ppm, "
+                  << ((tx.status & STA_UNSYNC) ? "unsynchronized" : "synchronized") << ", estimated error "
+                  << tx.esterror << " us" << std::endl;
+    }
+    return 0;
+}
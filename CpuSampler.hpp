@@ -0,0 +1,329 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <unordered_map>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include "ProcFs.hpp"
+
+// Jiffy counters from one "cpu" line of /proc/stat
+struct CpuTimes
+{
+    uint64_t user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
+
+    uint64_t idleAll() const { return idle + iowait; }
+    uint64_t total() const { return user + nice + system + idle + iowait + irq + softirq + steal; }
+};
+
+// Interval CPU sampler for the whole system, each core and a set of PIDs.
+//
+// /proc/stat and every watched /proc/<pid>/schedstat stay open; each sample()
+// re-reads them with pread() into reused buffers and parses with a hand-rolled
+// scanner, so steady-state sampling does no allocation. Loads are deltas
+// between the last two samples, not cumulative ratios since boot.
+//
+// The cost is one syscall per watched PID per sample: about 0.4 us with warm
+// caches, but 2-3 us at a real 10 Hz cadence, so 5000 PIDs at 10 Hz take
+// 10-15% of a core (CPULoad --bench). Where PIDs are grouped, reading the
+// cgroup's cpu.stat instead costs one read per group.
+class CpuSampler
+{
+public:
+    CpuSampler() : buf_(64 * 1024)
+    {
+        statFd_ = open("/proc/stat", O_RDONLY | O_CLOEXEC);
+        procFd_ = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        ticksPerSec_ = sysconf(_SC_CLK_TCK);
+    }
+
+    ~CpuSampler()
+    {
+        for (auto& p : procs_)
+        {
+            close(p.fd);
+        }
+        if (statFd_ >= 0)
+        {
+            close(statFd_);
+        }
+        if (procFd_ >= 0)
+        {
+            close(procFd_);
+        }
+    }
+
+    CpuSampler(const CpuSampler&) = delete;
+    CpuSampler& operator=(const CpuSampler&) = delete;
+
+    bool ok() const { return statFd_ >= 0 && procFd_ >= 0; }
+
+    // Start tracking a process; its load is available after two samples
+    bool watch(pid_t pid)
+    {
+        if (index_.count(pid))
+        {
+            return true;
+        }
+        char path[32];
+        snprintf(path, sizeof(path), "%d/schedstat", static_cast<int>(pid));
+        int fd = openat(procFd_, path, O_RDONLY | O_CLOEXEC);
+        bool schedstat = fd >= 0;
+        if (!schedstat)
+        {
+            // Kernels without CONFIG_SCHEDSTATS: fall back to utime+stime ticks
+            snprintf(path, sizeof(path), "%d/stat", static_cast<int>(pid));
+            fd = openat(procFd_, path, O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+            {
+                return false;
+            }
+        }
+        Proc p;
+        p.pid = pid;
+        p.fd = fd;
+        p.schedstat = schedstat;
+        index_[pid] = procs_.size();
+        procs_.push_back(p);
+        return true;
+    }
+
+    void unwatch(pid_t pid)
+    {
+        auto it = index_.find(pid);
+        if (it != index_.end())
+        {
+            removeAt(it->second);
+        }
+    }
+
+    // Watch every process currently in /proc; returns how many were added
+    size_t watchAll()
+    {
+        size_t added = 0;
+        DIR* dir = fdopendir(dup(procFd_));
+        if (dir == nullptr)
+        {
+            return 0;
+        }
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr)
+        {
+            pid_t pid = procfs::parsePid(entry->d_name);
+            if (pid > 0 && watch(pid))
+            {
+                ++added;
+            }
+        }
+        closedir(dir);
+        return added;
+    }
+
+    // Take a sample; loads then describe the interval since the previous one
+    bool sample()
+    {
+        int64_t now = procfs::monotonicNs();
+        if (!readStat())
+        {
+            return false;
+        }
+        prevWallNs_ = wallNs_;
+        wallNs_ = now;
+
+        for (size_t i = 0; i < procs_.size();)
+        {
+            Proc& p = procs_[i];
+            uint64_t ns;
+            if (!readProc(p, ns))
+            {
+                removeAt(i); // process exited
+                continue;
+            }
+            p.prevNs = p.curNs;
+            p.curNs = ns;
+            p.samples++;
+            ++i;
+        }
+        samples_++;
+        return true;
+    }
+
+    size_t coreCount() const { return cur_.empty() ? 0 : cur_.size() - 1; }
+    size_t processCount() const { return procs_.size(); }
+
+    // Busy percentage of one core over the last interval
+    double coreLoad(size_t core) const
+    {
+        return load(core + 1);
+    }
+
+    // Busy percentage of the whole machine over the last interval
+    double totalLoad() const
+    {
+        return load(0);
+    }
+
+    // Percentage of one core used by pid over the last interval, -1 if unknown
+    double processLoad(pid_t pid) const
+    {
+        auto it = index_.find(pid);
+        if (it == index_.end())
+        {
+            return -1.0;
+        }
+        return procLoad(procs_[it->second]);
+    }
+
+    // Call fn(pid, percentOfOneCore) for every watched process with a valid interval
+    template <typename Fn>
+    void forEachProcess(Fn fn) const
+    {
+        for (const auto& p : procs_)
+        {
+            double l = procLoad(p);
+            if (l >= 0)
+            {
+                fn(p.pid, l);
+            }
+        }
+    }
+
+private:
+    struct Proc
+    {
+        pid_t pid = 0;
+        int fd = -1;
+        bool schedstat = true;
+        uint64_t prevNs = 0;
+        uint64_t curNs = 0;
+        unsigned samples = 0;
+    };
+
+    void removeAt(size_t i)
+    {
+        close(procs_[i].fd);
+        index_.erase(procs_[i].pid);
+        if (i + 1 != procs_.size())
+        {
+            procs_[i] = procs_.back();
+            index_[procs_[i].pid] = i;
+        }
+        procs_.pop_back();
+    }
+
+    double load(size_t i) const
+    {
+        if (samples_ < 2 || i >= cur_.size() || i >= prev_.size())
+        {
+            return -1.0;
+        }
+        uint64_t total = cur_[i].total() - prev_[i].total();
+        uint64_t idle = cur_[i].idleAll() - prev_[i].idleAll();
+        return total == 0 ? 0.0 : 100.0 * (total - idle) / total;
+    }
+
+    double procLoad(const Proc& p) const
+    {
+        int64_t wall = wallNs_ - prevWallNs_;
+        if (p.samples < 2 || wall <= 0)
+        {
+            return -1.0;
+        }
+        return 100.0 * static_cast<double>(p.curNs - p.prevNs) / wall;
+    }
+
+    bool readStat()
+    {
+        ssize_t n = procfs::readWhole(statFd_, buf_);
+        if (n <= 0)
+        {
+            return false;
+        }
+        prev_.swap(cur_);
+        cur_.clear();
+
+        const char* p = buf_.data();
+        const char* end = p + n;
+        // "cpu" is the aggregate, "cpuN" the cores; they always come first
+        while (p + 3 < end && p[0] == 'c' && p[1] == 'p' && p[2] == 'u')
+        {
+            const char* q = p + 3;
+            while (q < end && *q != ' ')
+            {
+                ++q;
+            }
+            CpuTimes t;
+            uint64_t* fields[] = {&t.user, &t.nice, &t.system, &t.idle, &t.iowait, &t.irq, &t.softirq, &t.steal};
+            for (uint64_t* f : fields)
+            {
+                q = procfs::parseU64(procfs::skipSpaces(q, end), end, *f);
+            }
+            cur_.push_back(t);
+            p = procfs::nextLine(q, end);
+        }
+        return !cur_.empty();
+    }
+
+    bool readProc(Proc& p, uint64_t& ns)
+    {
+        char buf[512];
+        ssize_t n = pread(p.fd, buf, sizeof(buf), 0);
+        if (n <= 0)
+        {
+            return false;
+        }
+        const char* s = buf;
+        const char* end = buf + n;
+        if (p.schedstat)
+        {
+            // "<on-cpu ns> <runqueue wait ns> <timeslices>"
+            procfs::parseU64(s, end, ns);
+            return true;
+        }
+
+        // comm may contain spaces and parens, so count fields after the last ')'
+        const char* q = end;
+        while (q > s && *(q - 1) != ')')
+        {
+            --q;
+        }
+        uint64_t v = 0, utime = 0, stime = 0;
+        for (int field = 3; field <= 15 && q < end; ++field)
+        {
+            q = procfs::skipSpaces(q, end);
+            if (field == 3)
+            {
+                ++q; // state character
+                continue;
+            }
+            q = procfs::parseU64(q, end, v);
+            if (field == 14)
+            {
+                utime = v;
+            }
+            else if (field == 15)
+            {
+                stime = v;
+            }
+        }
+        ns = (utime + stime) * (1000000000ULL / static_cast<uint64_t>(ticksPerSec_));
+        return true;
+    }
+
+    int statFd_ = -1;
+    int procFd_ = -1;
+    long ticksPerSec_ = 100;
+    std::vector<char> buf_;
+    std::vector<CpuTimes> prev_, cur_;
+    std::vector<Proc> procs_;
+    std::unordered_map<pid_t, size_t> index_;
+    int64_t wallNs_ = 0;
+    int64_t prevWallNs_ = 0;
+    unsigned samples_ = 0;
+};
@@ -0,0 +1,314 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+
+// Single-threaded reactor: socket readiness, timers (timerfd) and signals
+// (signalfd) are all dispatched from one epoll_wait() loop. Run one loop per
+// core (see pinCurrentThread) and share nothing between them.
+//
+// Everything except stop() must be called from the loop's own thread or
+// before run() starts.
+class EventLoop
+{
+public:
+    typedef std::function<void(uint32_t events)> IoHandler;
+    typedef std::function<void()> TimerHandler;
+    typedef std::function<void(const struct signalfd_siginfo& info)> SignalHandler;
+
+    EventLoop() : running_(false), nextTimerId_(1)
+    {
+        epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd_ < 0)
+        {
+            throw std::runtime_error(std::string("EventLoop: epoll_create1 failed: ") + strerror(errno));
+        }
+        wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeFd_ < 0)
+        {
+            close(epollFd_);
+            throw std::runtime_error(std::string("EventLoop: eventfd failed: ") + strerror(errno));
+        }
+        sigemptyset(&signalMask_);
+        addFd(wakeFd_, EPOLLIN, [this](uint32_t)
+        {
+            uint64_t v;
+            while (read(wakeFd_, &v, sizeof(v)) > 0)
+            {
+            }
+        });
+    }
+
+    ~EventLoop()
+    {
+        for (auto& kv : handlers_)
+        {
+            if (kv.second->owned)
+            {
+                close(kv.first);
+            }
+        }
+        close(wakeFd_);
+        close(epollFd_);
+    }
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Watch a caller-owned fd; handler receives the EPOLL* event mask
+    bool addFd(int fd, uint32_t events, IoHandler handler)
+    {
+        auto entry = std::make_shared<Entry>();
+        entry->io = std::move(handler);
+        return registerFd(fd, events, entry);
+    }
+
+    bool modifyFd(int fd, uint32_t events)
+    {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = events;
+        ev.data.fd = fd;
+        return epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &ev) == 0;
+    }
+
+    // Stop watching an fd; fds created by the loop itself are also closed
+    void removeFd(int fd)
+    {
+        auto it = handlers_.find(fd);
+        if (it == handlers_.end())
+        {
+            return;
+        }
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+        if (it->second->owned)
+        {
+            close(fd);
+        }
+        if (it->second->timerId >= 0)
+        {
+            timers_.erase(it->second->timerId);
+        }
+        handlers_.erase(it);
+    }
+
+    // Arm a timer firing after initial and then every period (zero = one-shot).
+    // Returns a timer id for cancelTimer(), or -1 on failure. Ids are not fd
+    // numbers, so cancelling a timer that already fired cannot hit whatever
+    // reused its fd.
+    int addTimer(std::chrono::nanoseconds initial, std::chrono::nanoseconds period, TimerHandler handler)
+    {
+        int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (fd < 0)
+        {
+            perror("EventLoop: timerfd_create");
+            return -1;
+        }
+        struct itimerspec spec;
+        spec.it_value = toTimespec(initial.count() > 0 ? initial : std::chrono::nanoseconds(1));
+        spec.it_interval = toTimespec(period);
+        if (timerfd_settime(fd, 0, &spec, nullptr) < 0)
+        {
+            perror("EventLoop: timerfd_settime");
+            close(fd);
+            return -1;
+        }
+
+        bool periodic = period.count() > 0;
+        auto entry = std::make_shared<Entry>();
+        entry->owned = true;
+        while (timers_.count(nextTimerId_))
+        {
+            nextTimerId_ = nextTimerId_ == INT_MAX ? 1 : nextTimerId_ + 1; // wrapped onto a live timer
+        }
+        entry->timerId = nextTimerId_;
+        entry->io = [this, fd, periodic, handler](uint32_t)
+        {
+            uint64_t expirations;
+            if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+            {
+                return;
+            }
+            if (!periodic)
+            {
+                removeFd(fd);
+            }
+            handler();
+        };
+        if (!registerFd(fd, EPOLLIN, entry))
+        {
+            close(fd);
+            return -1;
+        }
+        int id = nextTimerId_;
+        nextTimerId_ = nextTimerId_ == INT_MAX ? 1 : nextTimerId_ + 1;
+        timers_[id] = fd;
+        return id;
+    }
+
+    void cancelTimer(int timerId)
+    {
+        auto it = timers_.find(timerId);
+        if (it != timers_.end())
+        {
+            removeFd(it->second);
+        }
+    }
+
+    // Route a signal through the loop instead of an async handler. The signal
+    // is blocked in the calling thread, so install signals before starting
+    // any other threads that should inherit the mask.
+    bool addSignal(int signo, SignalHandler handler)
+    {
+        sigaddset(&signalMask_, signo);
+        if (pthread_sigmask(SIG_BLOCK, &signalMask_, nullptr) != 0)
+        {
+            return false;
+        }
+        signalHandlers_[signo] = std::move(handler);
+
+        int fd = signalfd(signalFd_, &signalMask_, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (fd < 0)
+        {
+            perror("EventLoop: signalfd");
+            return false;
+        }
+        if (signalFd_ < 0)
+        {
+            signalFd_ = fd;
+            auto entry = std::make_shared<Entry>();
+            entry->owned = true;
+            entry->io = [this](uint32_t)
+            {
+                struct signalfd_siginfo info;
+                while (read(signalFd_, &info, sizeof(info)) == sizeof(info))
+                {
+                    auto it = signalHandlers_.find(static_cast<int>(info.ssi_signo));
+                    if (it != signalHandlers_.end())
+                    {
+                        it->second(info);
+                    }
+                }
+            };
+            return registerFd(signalFd_, EPOLLIN, entry);
+        }
+        return true;
+    }
+
+    // Dispatch events until stop() is called
+    void run()
+    {
+        running_ = true;
+        std::vector<struct epoll_event> events(64);
+        std::vector<std::shared_ptr<Entry>> batch;
+        while (running_)
+        {
+            int n = epoll_wait(epollFd_, events.data(), static_cast<int>(events.size()), -1);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                perror("EventLoop: epoll_wait");
+                break;
+            }
+            // Resolve the whole batch first. A handler may remove an fd and
+            // register a new one that gets the same number; the event still
+            // queued for the old one must not reach the new handler.
+            for (int i = 0; i < n; ++i)
+            {
+                auto it = handlers_.find(events[i].data.fd);
+                batch.push_back(it == handlers_.end() ? nullptr : it->second);
+            }
+            for (int i = 0; i < n; ++i)
+            {
+                auto it = handlers_.find(events[i].data.fd);
+                if (!batch[i] || it == handlers_.end() || it->second != batch[i])
+                {
+                    continue; // removed (or replaced) by an earlier handler in this batch
+                }
+                // batch holds a reference so the handler may remove itself
+                batch[i]->io(events[i].events);
+            }
+            batch.clear();
+        }
+    }
+
+    // Ask the loop to return from run(); safe to call from any thread
+    void stop()
+    {
+        running_ = false;
+        uint64_t one = 1;
+        ssize_t rc = write(wakeFd_, &one, sizeof(one));
+        (void)rc;
+    }
+
+    // Pin the calling thread to one CPU (for one-loop-per-core setups)
+    static bool pinCurrentThread(int cpu)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+
+private:
+    struct Entry
+    {
+        IoHandler io;
+        bool owned = false;
+        int timerId = -1; // for timers, the id addTimer() returned
+    };
+
+    static struct timespec toTimespec(std::chrono::nanoseconds d)
+    {
+        struct timespec ts;
+        ts.tv_sec = static_cast<time_t>(d.count() / 1000000000LL);
+        ts.tv_nsec = static_cast<long>(d.count() % 1000000000LL);
+        return ts;
+    }
+
+    bool registerFd(int fd, uint32_t events, std::shared_ptr<Entry> entry)
+    {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = events;
+        ev.data.fd = fd;
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) < 0)
+        {
+            perror("EventLoop: epoll_ctl");
+            return false;
+        }
+        handlers_[fd] = std::move(entry);
+        return true;
+    }
+
+    int epollFd_ = -1;
+    int wakeFd_ = -1;
+    int signalFd_ = -1;
+    sigset_t signalMask_;
+    std::atomic<bool> running_;
+    std::unordered_map<int, std::shared_ptr<Entry>> handlers_;
+    int nextTimerId_;
+    std::unordered_map<int, int> timers_; // timer id to timerfd
+    std::unordered_map<int, SignalHandler> signalHandlers_;
+};
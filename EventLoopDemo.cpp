@@ -0,0 +1,84 @@
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "EventLoop.hpp"
+
+// Compile: g++ -std=c++17 -O2 -o EventLoopDemo EventLoopDemo.cpp
+// Usage:   ./EventLoopDemo [udp_port] [run_seconds]
+//
+// One loop serves a UDP echo socket, a periodic job, a watchdog kick and
+// SIGINT/SIGTERM shutdown, with no extra threads and no polling.
+
+int main(int argc, char** argv)
+{
+    uint16_t port = argc > 1 ? static_cast<uint16_t>(std::stoi(argv[1])) : 9999;
+    int runSeconds = argc > 2 ? std::stoi(argv[2]) : 0;
+
+    EventLoop loop;
+
+    auto onSignal = [&loop](const struct signalfd_siginfo& info)
+    {
+        std::cout << "Received signal " << info.ssi_signo << ", stopping" << std::endl;
+        loop.stop();
+    };
+    loop.addSignal(SIGINT, onSignal);
+    loop.addSignal(SIGTERM, onSignal);
+
+    int sock = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (sock < 0 || bind(sock, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0)
+    {
+        perror("bind");
+        return 1;
+    }
+
+    uint64_t packets = 0;
+    loop.addFd(sock, EPOLLIN, [sock, &packets](uint32_t)
+    {
+        char buf[2048];
+        struct sockaddr_in src;
+        socklen_t len = sizeof(src);
+        ssize_t n;
+        while ((n = recvfrom(sock, buf, sizeof(buf), 0, reinterpret_cast<struct sockaddr*>(&src), &len)) >= 0)
+        {
+            sendto(sock, buf, n, 0, reinterpret_cast<struct sockaddr*>(&src), len);
+            ++packets;
+            len = sizeof(src);
+        }
+    });
+
+    int ticks = 0;
+    loop.addTimer(std::chrono::seconds(1), std::chrono::seconds(1), [&ticks, &packets]()
+    {
+        std::cout << "Periodic job #" << ++ticks << ", echoed " << packets << " packets" << std::endl;
+    });
+
+    loop.addTimer(std::chrono::milliseconds(2500), std::chrono::milliseconds(2500), []()
+    {
+        // A real deployment would write to /dev/watchdog here
+        std::cout << "Watchdog kick" << std::endl;
+    });
+
+    if (runSeconds > 0)
+    {
+        loop.addTimer(std::chrono::seconds(runSeconds), std::chrono::nanoseconds::zero(), [&loop]()
+        {
+            std::cout << "Run time elapsed, stopping" << std::endl;
+            loop.stop();
+        });
+    }
+
+    std::cout << "Echoing UDP on 127.0.0.1:" << port << ", Ctrl+C to stop" << std::endl;
+    loop.run();
+
+    close(sock);
+    return 0;
+}
@@ -1,73 +1,84 @@
 #include <iostream>
-#include <fstream>
 #include <string>
 #include <vector>
 #include <unistd.h>
 #include <sys/types.h>
 #include <dirent.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <thread>
+#include <cstdio>
+#include <fcntl.h>
+#include "MemoryScanner.hpp"
+#include "ProcessTable.hpp"
 
-std::vector < int > getProcessIds() 
+// Live PIDs from a process table kept current by the proc connector; the
+// /proc walk only happens on first use (or on every call if the connector
+// is unavailable)
+const std::vector < pid_t > & getProcessIds() 
 {
-  std::vector < int > pids;
-  DIR * dir = opendir("/proc");
-  if (dir == nullptr) 
-  {
-    std::cerr << "Failed to open /proc directory" << std::endl;
-    return pids;
-  }
-
-  struct dirent * entry;
-  while ((entry = readdir(dir)) != nullptr) 
-  {
-    if (entry -> d_type == DT_DIR) 
-    {
-      std::string name(entry -> d_name);
-      if (std::all_of(name.begin(), name.end(), ::isdigit)) 
-      {
-        pids.push_back(std::stoi(name));
-      }
-    }
-  }
-
-  closedir(dir);
-  return pids;
+  static ProcessTable table;
+  table.update();
+  return table.pids();
 }
 
+// Virtual size (VmSize) of a process in kB, or -1 if it cannot be read
 long getProcessMemoryUsage(int pid) 
 {
-  std::ifstream statusFile("/proc/" + std::to_string(pid) + "/status");
-  if (!statusFile) {
-    std::cerr << "Failed to open status file for process " << pid << std::endl;
+  char path[48];
+  char buf[256];
+  snprintf(path, sizeof(path), "/proc/%d/statm", pid);
+  ssize_t n = procfs::readAt(AT_FDCWD, path, buf, sizeof(buf));
+  if (n <= 0) 
+  {
+    std::cerr << "Failed to read statm for process " << pid << std::endl;
     return -1;
   }
 
-  std::string line;
-  long vmSize = 0;
-  while (std::getline(statusFile, line)) 
-  {
-    if (line.find("VmSize:") != std::string::npos
-    {
-      vmSize = std::stol(line.substr(line.find_last_of(" ") + 1));
-      break;
-    }
-  }
+  uint64_t pages = 0;
+  procfs::parseU64(buf, buf + n, pages);
+  return static_cast<long>(pages * (sysconf(_SC_PAGESIZE) / 1024));
+}
 
-  statusFile.close();
-  return vmSize;
+static double elapsedMs(std::chrono::steady_clock::time_point start) 
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
 
-int main() 
+int main(int argc, char ** argv) 
 {
-  std::vector < int > pids = getProcessIds();
+  unsigned threads = argc > 1 ? static_cast<unsigned>(atoi(argv[1])) : std::thread::hardware_concurrency();
+  MemoryScanner scanner(threads);
+
+  auto start = std::chrono::steady_clock::now();
+  MemoryScanStats stats = scanner.scan();
+  double firstMs = elapsedMs(start);
 
-  for (int pid: pids) 
+  std::cout << "     PID      VmSize         RSS        Anon         PSS        Swap  (kB)" << std::endl;
+  for (const ProcessMemory & m: scanner.processes()) 
   {
-    long memoryUsage = getProcessMemoryUsage(pid);
-    if (memoryUsage != -1) 
+    std::cout << std::setw(8) << m.pid << std::setw(12) << m.sizeKb << std::setw(12) << m.rssKb
+              << std::setw(12) << m.anonKb;
+    if (m.detailed) 
     {
-      std::cout << "Process ID: " << pid << ", Memory Usage: " << memoryUsage << " kB" << std::endl;
+      std::cout << std::setw(12) << m.pssKb << std::setw(12) << m.swapKb;
     }
+    std::cout << std::endl;
   }
 
+  start = std::chrono::steady_clock::now();
+  MemoryScanStats again = scanner.scan();
+  double rescanMs = elapsedMs(start);
+
+  start = std::chrono::steady_clock::now();
+  scanner.scan(true);
+  double fullMs = elapsedMs(start);
+
+  std::cout << "\nFirst scan: " << stats.processes << " processes, " << stats.rollupReads
+            << " smaps_rollup reads, " << firstMs << " ms (" << threads << " threads)" << std::endl;
+  std::cout << "Rescan: " << again.added << " new, " << again.removed << " exited, " << again.rollupReads
+            << " smaps_rollup reads, " << rescanMs << " ms" << std::endl;
+  std::cout << "Forced full rescan: " << fullMs << " ms" << std::endl;
   return 0;
 }
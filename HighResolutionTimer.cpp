@@ -3,60 +3,35 @@
 #include <functional>
 #include <thread>
 #include <atomic>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "HighResolutionTimer.hpp"
 
-// Generic high resolution timer
-template <typename Duration = std::chrono::milliseconds, typename Callback>
-class Timer 
+// Example usage
+void printTime() 
 {
-public:
-    Timer(Callback&& callback, Duration interval) : callback_(std::forward<Callback>(callback)), interval_(interval), running_(false) 
-    {
-      
-    }
-
-    ~Timer() 
-    {
-        stop();
-    }
+    static int count = 0;
+    std::cout << "Timer fired: " << count++ << std::endl;
+}
 
-    void start() 
+// "Threads:" line of /proc/self/status
+static int threadCount()
 {
-        running_ = true;
-        worker_ = std::thread([this]() 
-        {
-            while (running_) 
-            {
-                auto start = std::chrono::high_resolution_clock::now();
-                callback_();
-                auto end = std::chrono::high_resolution_clock::now();
-                auto elapsed = std::chrono::duration_cast<Duration>(end - start);
-                std::this_thread::sleep_for(interval_ > elapsed ? interval_ - elapsed : Duration::zero());
-            }
-        });
-    }
-
-    void stop() 
+    std::ifstream status("/proc/self/status");
+    std::string key;
+    int value = 0;
+    while (status >> key)
     {
-        running_ = false;
-        if (worker_.joinable()) 
+        if (key == "Threads:")
         {
-            worker_.join();
+            status >> value;
+            break;
         }
     }
-
-private:
-    Callback callback_;
-    Duration interval_;
-    std::atomic<bool> running_;
-    std::thread worker_;
-};
-
-// Example usage
-void printTime() 
-{
-    static int count = 0;
-    std::cout << "Timer fired: " << count++ << std::endl;
+    return value;
 }
 
 int main() 
@@ -64,8 +39,27 @@ int main()
     Timer<std::chrono::seconds> timer(printTime, std::chrono::seconds(2));
     timer.start();
 
+    // Thousands of timers share the default wheel's two threads
+    std::atomic<int> fired(0);
+    std::vector<std::unique_ptr<Timer<>>> timers;
+    for (int i = 0; i < 5000; ++i)
+    {
+        timers.emplace_back(new Timer<>([&fired]() { fired++; }, std::chrono::milliseconds(100 + i % 100)));
+        timers.back()->start();
+    }
+    std::cout << timers.size() + 1 << " timers running on " << threadCount() << " threads" << std::endl;
+
     // Keep the program running for 10 seconds
     std::this_thread::sleep_for(std::chrono::seconds(10));
 
-    return 0;
+    // No callback may run once stop() has returned
+    for (auto& t : timers)
+    {
+        t->stop();
+    }
+    int afterStop = fired;
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    std::cout << fired << " callbacks from " << timers.size() << " timers, " << fired - afterStop << " after stop()"
+              << std::endl;
+    return fired == afterStop && afterStop > 0 ? 0 : 1;
 }
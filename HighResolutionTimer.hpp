@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "TimerWheel.hpp"
+
+// Wheel shared by every Timer not given one of its own: a 1 ms tick and one
+// executor thread, however many timers exist
+inline TimerWheel& defaultTimerWheel()
+{
+    static TimerWheel wheel(std::chrono::milliseconds(1), 1);
+    wheel.start();
+    return wheel;
+}
+
+// Generic high resolution timer. Timers do not own a thread: each one is a
+// periodic entry in a TimerWheel, and its callback runs on the wheel's
+// executor. Intervals are rounded up to the wheel's tick, so pass a wheel
+// with a finer tick for sub-millisecond intervals, and one with more workers
+// if callbacks are slow enough to delay each other.
+template <typename Duration = std::chrono::milliseconds, typename Callback = std::function<void()>>
+class Timer
+{
+public:
+    Timer(Callback callback, Duration interval, TimerWheel& wheel = defaultTimerWheel())
+        : wheel_(wheel), state_(std::make_shared<State>(std::move(callback))), interval_(interval),
+          id_(TimerWheel::kInvalidTimer)
+    {
+    }
+
+    ~Timer()
+    {
+        stop();
+    }
+
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+    void start()
+    {
+        stop();
+        std::shared_ptr<State> state = state_;
+        uint64_t generation;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            generation = ++state->generation;
+        }
+        id_ = wheel_.schedule(interval_, [state, generation]() { state->fire(generation); },
+                              std::chrono::duration_cast<std::chrono::nanoseconds>(interval_));
+    }
+
+    // Once stop() returns the callback is not running and will not run again,
+    // even if the wheel had already queued it
+    void stop()
+    {
+        if (id_ == TimerWheel::kInvalidTimer)
+        {
+            return;
+        }
+        wheel_.cancel(id_);
+        id_ = TimerWheel::kInvalidTimer;
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->generation++;
+    }
+
+private:
+    // Shared with the scheduled closure, which can outlive the Timer in the
+    // executor queue; a closure from an earlier start() sees a newer generation
+    struct State
+    {
+        explicit State(Callback cb) : callback(std::move(cb)) {}
+
+        void fire(uint64_t scheduled)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (scheduled == generation)
+            {
+                callback();
+            }
+        }
+
+        Callback callback;
+        std::mutex mutex;
+        uint64_t generation = 0;
+    };
+
+    TimerWheel& wheel_;
+    std::shared_ptr<State> state_;
+    Duration interval_;
+    TimerWheel::TimerId id_;
+};
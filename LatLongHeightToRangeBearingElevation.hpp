@@ -1,3 +1,5 @@
+#pragma once
+
 #include <cmath>
 
 struct LatLonHeight 
@@ -16,7 +18,7 @@ struct RangeBearingElevation
 
 const double EARTH_RADIUS = 6371.0; // in km
 
-RangeBearingElevation latLonHeightToRangeBearingElevation(const LatLonHeight& source, const LatLonHeight& target) 
+inline RangeBearingElevation latLonHeightToRangeBearingElevation(const LatLonHeight& source, const LatLonHeight& target) 
 {
     double lat1 = source.latitude * M_PI / 180.0;
     double lon1 = source.longitude * M_PI / 180.0;
@@ -1,30 +1,59 @@
 
 #include <iostream>
-#include <fcntl.h>
-#include <unistd.h>
+#include <csignal>
+#include "Watchdog.hpp"
 
-int main() 
+// Watchdog daemon: arms /dev/watchdog (or argv[1]) with a 10 s timeout and
+// feeds it only while every process attached to the heartbeat table (see
+// WatchDogApp.cpp) keeps beating. SIGTERM/SIGINT disarm it with the magic
+// close, as does a failure to start; any other exit leaves it armed.
+int main(int argc, char* argv[]) 
 {
-    int fd = open("/dev/watchdog", O_WRONLY);
-    if (fd == -1) 
+    try
     {
-        std::cerr << "Failed to open /dev/watchdog" << std::endl;
-        return 1;
-    }
+        // Everything that can fail is set up before the device is opened:
+        // opening it arms the hardware, and a daemon that dies of a config
+        // error must not leave it armed and unfed
+        HeartbeatTable table(kHeartbeatTable, true);
+        EventLoop loop;
+        WatchdogOptions options;
+        options.timeout = std::chrono::seconds(10);
+        options.check = std::chrono::seconds(1);
+        auto shutdown = [&loop](const struct signalfd_siginfo&) { loop.stop(); };
+        if (!loop.addSignal(SIGTERM, shutdown) || !loop.addSignal(SIGINT, shutdown))
+        {
+            std::cerr << "Failed to route SIGTERM/SIGINT through the event loop" << std::endl;
+            return 1;
+        }
 
-    // Keep the watchdog timer alive by writing to it periodically
-    while (true) 
-    {
-        if (write(fd, "\0", 1) != 1) 
+        WatchdogDevice device(argc > 1 ? argv[1] : "/dev/watchdog");
+        WatchdogManager manager(loop, device, table, options);
+        manager.setListener([](const ClientHealth& c)
+        {
+            std::cout << c.name << " (pid " << c.pid << ") "
+                      << (!c.attached ? "detached" : c.healthy ? "healthy" : "missed its deadline, not feeding the watchdog")
+                      << std::endl;
+        });
+        if (!manager.start())
         {
-            std::cerr << "Failed to write to /dev/watchdog" << std::endl;
-            break;
+            std::cerr << "Failed to start the watchdog timer" << std::endl;
+            std::cerr << (device.magicClose() ? "Watchdog disarmed" : "Magic close failed; the watchdog is still armed")
+                      << std::endl;
+            return 1;
         }
+        loop.run();
 
-        // Sleep for a certain amount of time before writing again
-        sleep(10); // Example: Sleep for 10 seconds
+        if (!manager.shutdown())
+        {
+            std::cerr << "Magic close failed; the watchdog is still armed" << std::endl;
+            return 1;
+        }
+        std::cout << "Watchdog disarmed" << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
     }
-
-    close(fd);
     return 0;
 }
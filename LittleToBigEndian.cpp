@@ -1,56 +1,109 @@
-
 #include <iostream>
 #include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include "ByteSwap.hpp"
+
+// Compile: g++ -std=c++17 -O2 -o LittleToBigEndian LittleToBigEndian.cpp
 
 // Function to swap bytes for int
 uint32_t swapBytesInt(uint32_t value) 
 {
-    return ((value & 0x000000FF) << 24) |
-           ((value & 0x0000FF00) << 8) |
-           ((value & 0x00FF0000) >> 8) |
-           ((value & 0xFF000000) >> 24);
+    return bswap32(value);
 }
 
 // Function to swap bytes for short
 uint16_t swapBytesShort(uint16_t value) 
 {
-    return ((value & 0x00FF) << 8) |
-           ((value & 0xFF00) >> 8);
+    return bswap16(value);
 }
 
 // Function to swap bytes for float
 float swapBytesFloat(float value) 
 {
-    uint32_t temp = swapBytesInt(*(uint32_t*)&value);
-    return *(float*)&temp;
+    return bswapValue(value);
 }
 
 // Function to swap bytes for double
 double swapBytesDouble(double value) 
 {
-    uint64_t temp = 0;
-    uint32_t* ptr = (uint32_t*)&value;
-    uint32_t* tempPtr = (uint32_t*)&temp;
-
-    tempPtr[0] = swapBytesInt(ptr[1]);
-    tempPtr[1] = swapBytesInt(ptr[0]);
-
-    return *(double*)&temp;
+    return bswapValue(value);
 }
 
 // Function to swap for 64 bit data
 uint64_t swapBytesInt64(uint64_t value) 
 {
-    uint64_t result = 0;
-    result |= (value & 0x00000000000000FFULL) << 56;
-    result |= (value & 0x000000000000FF00ULL) << 40;
-    result |= (value & 0x0000000000FF0000ULL) << 24;
-    result |= (value & 0x00000000FF000000ULL) << 8;
-    result |= (value & 0x000000FF00000000ULL) >> 8;
-    result |= (value & 0x0000FF0000000000ULL) >> 24;
-    result |= (value & 0x00FF000000000000ULL) >> 40;
-    result |= (value & 0xFF00000000000000ULL) >> 56;
-    return result;
+    return bswap64(value);
+}
+
+// Check one kernel against the single-value swap. Every length up to 100
+// elements plus a long odd one runs each unrolled loop with every tail
+// length, from an aligned and an unaligned start, out of place and in place.
+template <typename T>
+bool checkKernel(byteswap_detail::SwapKernel kernel, T (*reference)(T))
+{
+    byteswap_detail::SwapFn fn = byteswap_detail::kernelFor<sizeof(T)>(kernel);
+    std::vector<T> src(1028), got(1028);
+    for (size_t i = 0; i < src.size(); ++i)
+    {
+        src[i] = static_cast<T>(0x0102030405060708ULL * (i + 1));
+    }
+    std::vector<size_t> lengths;
+    for (size_t n = 0; n <= 100; ++n)
+    {
+        lengths.push_back(n);
+    }
+    lengths.push_back(1027);
+    for (size_t offset = 0; offset < 2; ++offset)
+    {
+        for (size_t n : lengths)
+        {
+            fn(src.data() + offset, got.data() + offset, n);
+            for (size_t i = 0; i < n; ++i)
+            {
+                if (got[offset + i] != reference(src[offset + i]))
+                {
+                    return false;
+                }
+            }
+            fn(got.data() + offset, got.data() + offset, n);
+            if (std::memcmp(got.data() + offset, src.data() + offset, n * sizeof(T)) != 0)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Measure one bulk kernel on a buffer and print its throughput in GB/s
+template <size_t Width>
+void benchmarkKernel(const char* name, byteswap_detail::SwapKernel kernel, std::vector<unsigned char>& src, std::vector<unsigned char>& dst)
+{
+    byteswap_detail::SwapFn fn = byteswap_detail::kernelFor<Width>(kernel);
+    size_t n = src.size() / Width;
+    const int reps = 50;
+
+    fn(src.data(), dst.data(), n); // warm up caches and page tables
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r)
+    {
+        fn(src.data(), dst.data(), n);
+    }
+    double outOfPlace = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r)
+    {
+        fn(dst.data(), dst.data(), n);
+    }
+    double inPlace = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double gb = static_cast<double>(src.size()) * reps / 1e9;
+    std::cout << "  " << Width * 8 << "-bit " << name << ": "
+              << gb / outOfPlace << " GB/s out-of-place, "
+              << gb / inPlace << " GB/s in-place" << std::endl;
 }
 
 int main() 
@@ -68,18 +121,53 @@ int main()
     std::cout << "double: " << doubleValue << std::endl;
     std::cout << "longlongvalue: " << longlongvalue << std::endl;
 
-    uint32_t swappedInt = swapBytesInt(*(uint32_t*)&intValue);
-    uint16_t swappedShort = swapBytesShort(*(uint16_t*)&shortValue);
+    uint32_t swappedInt = swapBytesInt(static_cast<uint32_t>(intValue));
+    uint16_t swappedShort = swapBytesShort(static_cast<uint16_t>(shortValue));
     float swappedFloat = swapBytesFloat(floatValue);
     double swappedDouble = swapBytesDouble(doubleValue);
     uint64_t swap64Value = swapBytesInt64(longlongvalue);
 
     std::cout << "\nSwapped values:" << std::endl;
-    std::cout << "int: " << *(int*)&swappedInt << std::endl;
-    std::cout << "short: " << *(short*)&swappedShort << std::endl;
+    std::cout << "int: " << static_cast<int32_t>(swappedInt) << std::endl;
+    std::cout << "short: " << static_cast<int16_t>(swappedShort) << std::endl;
     std::cout << "float: " << swappedFloat << std::endl;
     std::cout << "double: " << swappedDouble << std::endl;
     std::cout << "longlongvalue: " << swap64Value << std::endl;
 
+    // Bulk conversion of a big-endian sensor frame in one call
+    std::vector<double> frame = {1.0, 2.5, -3.75, 1e9};
+    swapBytesArray(frame.data(), frame.size());
+    swapBytesArray(frame.data(), frame.size());
+    std::cout << "\nRound-tripped frame: " << frame[0] << " " << frame[1] << " " << frame[2] << " " << frame[3] << std::endl;
+
+    // Verify every kernel at every width against bswap16/32/64
+    using byteswap_detail::SwapKernel;
+    const SwapKernel kernels[] = {SwapKernel::Scalar, SwapKernel::SSSE3, SwapKernel::AVX2};
+    const char* names[] = {"scalar", "ssse3", "avx2"};
+    int available = 1 + (byteswap_detail::bestKernel() >= SwapKernel::SSSE3) + (byteswap_detail::bestKernel() >= SwapKernel::AVX2);
+
+    for (int k = 0; k < available; ++k)
+    {
+        if (!checkKernel<uint16_t>(kernels[k], bswap16) || !checkKernel<uint32_t>(kernels[k], bswap32) ||
+            !checkKernel<uint64_t>(kernels[k], bswap64))
+        {
+            std::cerr << "Kernel " << names[k] << " produced wrong output" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "\nBulk swap throughput (16 MiB buffer):" << std::endl;
+    std::vector<unsigned char> src(16 << 20), dst(16 << 20);
+    for (size_t i = 0; i < src.size(); ++i)
+    {
+        src[i] = static_cast<unsigned char>(i * 31);
+    }
+    for (int k = 0; k < available; ++k)
+    {
+        benchmarkKernel<2>(names[k], kernels[k], src, dst);
+        benchmarkKernel<4>(names[k], kernels[k], src, dst);
+        benchmarkKernel<8>(names[k], kernels[k], src, dst);
+    }
+
     return 0;
 }
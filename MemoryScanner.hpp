@@ -0,0 +1,301 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "ProcFs.hpp"
+
+// Memory footprint of one process, all sizes in kB
+struct ProcessMemory
+{
+    pid_t pid = 0;
+    // From statm, always available
+    uint64_t sizeKb = 0;      ///< Virtual size (VmSize)
+    uint64_t rssKb = 0;       ///< Resident set
+    uint64_t sharedKb = 0;    ///< Resident file-backed and shmem pages
+    uint64_t anonKb = 0;      ///< Resident anonymous pages (rss - shared)
+    // From smaps_rollup, only when detailed is set
+    uint64_t pssKb = 0;
+    uint64_t pssAnonKb = 0;
+    uint64_t pssFileKb = 0;
+    uint64_t pssShmemKb = 0;
+    uint64_t swapKb = 0;
+    uint64_t swapPssKb = 0;
+    bool detailed = false;    ///< smaps_rollup was readable (needs ptrace access)
+};
+
+struct MemoryScanStats
+{
+    size_t processes = 0;     ///< Processes in the table after the scan
+    size_t added = 0;         ///< PIDs seen for the first time
+    size_t removed = 0;       ///< PIDs that exited since the last scan
+    size_t rollupReads = 0;   ///< smaps_rollup files parsed (new or changed PIDs)
+};
+
+// Scans memory usage of every process in /proc.
+//
+// Files are opened with openat() relative to a cached /proc dirfd, read into
+// stack buffers and parsed in place. statm is cheap and read for every PID on
+// every scan; smaps_rollup walks all of a process's mappings in the kernel,
+// so it is only re-read for PIDs that are new or whose statm changed. The
+// work is split across threads that claim chunks of the PID table.
+class MemoryScanner
+{
+public:
+    explicit MemoryScanner(unsigned threads = std::thread::hardware_concurrency())
+        : threads_(threads ? threads : 1)
+    {
+        procFd_ = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (procFd_ < 0)
+        {
+            throw std::runtime_error("MemoryScanner: cannot open /proc");
+        }
+        dir_ = fdopendir(dup(procFd_));
+        if (dir_ == nullptr)
+        {
+            close(procFd_);
+            throw std::runtime_error("MemoryScanner: cannot list /proc");
+        }
+        pageKb_ = static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) / 1024;
+    }
+
+    ~MemoryScanner()
+    {
+        closedir(dir_);
+        close(procFd_);
+    }
+
+    MemoryScanner(const MemoryScanner&) = delete;
+    MemoryScanner& operator=(const MemoryScanner&) = delete;
+
+    // Refresh the table; full forces smaps_rollup to be re-read for every PID
+    const MemoryScanStats& scan(bool full = false)
+    {
+        listPids();
+        merge();
+
+        std::atomic<size_t> nextChunk(0);
+        std::atomic<size_t> rollups(0);
+        auto work = [&]()
+        {
+            size_t done = 0;
+            for (;;)
+            {
+                size_t begin = nextChunk.fetch_add(kChunk, std::memory_order_relaxed);
+                if (begin >= next_.size())
+                {
+                    break;
+                }
+                size_t end = std::min(begin + kChunk, next_.size());
+                for (size_t i = begin; i < end; ++i)
+                {
+                    done += refresh(next_[i], full);
+                }
+            }
+            rollups.fetch_add(done, std::memory_order_relaxed);
+        };
+
+        unsigned n = static_cast<unsigned>(std::min<size_t>(threads_, (next_.size() + kChunk - 1) / kChunk));
+        if (n <= 1)
+        {
+            work();
+        }
+        else
+        {
+            std::vector<std::thread> pool;
+            for (unsigned t = 1; t < n; ++t)
+            {
+                pool.emplace_back(work);
+            }
+            work();
+            for (auto& t : pool)
+            {
+                t.join();
+            }
+        }
+
+        // Drop processes that exited between listing and reading
+        entries_.clear();
+        for (const Slot& s : next_)
+        {
+            if (s.mem.pid != 0)
+            {
+                entries_.push_back(s.mem);
+            }
+        }
+        stats_.removed += next_.size() - entries_.size();
+        stats_.processes = entries_.size();
+        stats_.rollupReads = rollups.load();
+        return stats_;
+    }
+
+    // Processes from the last scan, sorted by PID
+    const std::vector<ProcessMemory>& processes() const { return entries_; }
+
+    const ProcessMemory* find(pid_t pid) const
+    {
+        auto it = std::lower_bound(entries_.begin(), entries_.end(), pid,
+                                   [](const ProcessMemory& m, pid_t p) { return m.pid < p; });
+        return it != entries_.end() && it->pid == pid ? &*it : nullptr;
+    }
+
+    const MemoryScanStats& stats() const { return stats_; }
+
+private:
+    static const size_t kChunk = 64;
+
+    struct Slot
+    {
+        ProcessMemory mem;
+        bool fresh = true;  ///< No previous statm to compare against
+    };
+
+    void listPids()
+    {
+        pids_.clear();
+        rewinddir(dir_);
+        struct dirent* entry;
+        while ((entry = readdir(dir_)) != nullptr)
+        {
+            pid_t pid = procfs::parsePid(entry->d_name);
+            if (pid > 0)
+            {
+                pids_.push_back(pid);
+            }
+        }
+        // procfs lists PIDs in ascending order already; this is a no-op check
+        if (!std::is_sorted(pids_.begin(), pids_.end()))
+        {
+            std::sort(pids_.begin(), pids_.end());
+        }
+    }
+
+    // Build the work table from the new listing and the previous results
+    void merge()
+    {
+        stats_ = MemoryScanStats();
+        next_.clear();
+        size_t j = 0;
+        for (pid_t pid : pids_)
+        {
+            while (j < entries_.size() && entries_[j].pid < pid)
+            {
+                ++j;
+                stats_.removed++;
+            }
+            Slot s;
+            if (j < entries_.size() && entries_[j].pid == pid)
+            {
+                s.mem = entries_[j++];
+                s.fresh = false;
+            }
+            else
+            {
+                s.mem.pid = pid;
+                stats_.added++;
+            }
+            next_.push_back(s);
+        }
+        stats_.removed += entries_.size() - j;
+    }
+
+    // Re-read one process; returns 1 if smaps_rollup was parsed
+    size_t refresh(Slot& s, bool full)
+    {
+        char path[48];
+        char buf[256];
+        snprintf(path, sizeof(path), "%d/statm", static_cast<int>(s.mem.pid));
+        ssize_t n = procfs::readAt(procFd_, path, buf, sizeof(buf));
+        if (n <= 0)
+        {
+            s.mem.pid = 0;  // gone
+            return 0;
+        }
+
+        // size resident shared text lib data dt, in pages
+        uint64_t size, resident, shared;
+        const char* p = buf;
+        const char* end = buf + n;
+        p = procfs::parseU64(p, end, size);
+        p = procfs::parseU64(procfs::skipSpaces(p, end), end, resident);
+        procfs::parseU64(procfs::skipSpaces(p, end), end, shared);
+
+        bool changed = s.fresh || size * pageKb_ != s.mem.sizeKb || resident * pageKb_ != s.mem.rssKb ||
+                       shared * pageKb_ != s.mem.sharedKb;
+        s.mem.sizeKb = size * pageKb_;
+        s.mem.rssKb = resident * pageKb_;
+        s.mem.sharedKb = shared * pageKb_;
+        s.mem.anonKb = resident > shared ? (resident - shared) * pageKb_ : 0;
+
+        if (!changed && !full)
+        {
+            return 0;
+        }
+        readRollup(s.mem);
+        return 1;
+    }
+
+    void readRollup(ProcessMemory& m) const
+    {
+        struct Key
+        {
+            const char* name;
+            size_t len;
+            uint64_t ProcessMemory::*field;
+        };
+        static const Key keys[] = {
+            {"Pss:", 4, &ProcessMemory::pssKb},
+            {"Pss_Anon:", 9, &ProcessMemory::pssAnonKb},
+            {"Pss_File:", 9, &ProcessMemory::pssFileKb},
+            {"Pss_Shmem:", 10, &ProcessMemory::pssShmemKb},
+            {"Swap:", 5, &ProcessMemory::swapKb},
+            {"SwapPss:", 8, &ProcessMemory::swapPssKb},
+        };
+
+        char path[48];
+        char buf[2048];
+        snprintf(path, sizeof(path), "%d/smaps_rollup", static_cast<int>(m.pid));
+        ssize_t n = procfs::readAt(procFd_, path, buf, sizeof(buf));
+        m.detailed = n > 0;
+        if (n <= 0)
+        {
+            return;
+        }
+
+        // First line is the address range header; then "Key:   value kB"
+        const char* end = buf + n;
+        for (const char* p = procfs::nextLine(buf, end); p < end; p = procfs::nextLine(p, end))
+        {
+            if (*p != 'P' && *p != 'S')
+            {
+                continue;
+            }
+            for (const Key& k : keys)
+            {
+                if (static_cast<size_t>(end - p) > k.len && memcmp(p, k.name, k.len) == 0)
+                {
+                    procfs::parseU64(procfs::skipSpaces(p + k.len, end), end, m.*k.field);
+                    break;
+                }
+            }
+        }
+    }
+
+    unsigned threads_;
+    int procFd_ = -1;
+    DIR* dir_ = nullptr;
+    uint64_t pageKb_ = 4;
+    std::vector<pid_t> pids_;
+    std::vector<Slot> next_;
+    std::vector<ProcessMemory> entries_;
+    MemoryScanStats stats_;
+};
@@ -5,27 +5,51 @@
 #include <iomanip>
 #include <thread>
 #include <cstdlib>
+#include "SntpClient.hpp"
+#include "ClockDiscipline.hpp"
+#include "UtcClock.hpp"
 
 using namespace std;
 
 int main() 
 {
+    // Several servers, so one bad reply cannot move the clock
+    SntpClient client({"0.pool.ntp.org", "1.pool.ntp.org", "2.pool.ntp.org", "3.pool.ntp.org"});
+
+    // Slew rather than step, so timers and latency measurements never see
+    // the time jump; only an error over 128 ms that lasts 5 minutes steps
+    KernelClock kernel;
+    ClockDiscipline<KernelClock> discipline(kernel, ClockDisciplineOptions(), kernel.initialFrequency());
+
     while (true) 
     {
-        // Get current time
-        auto now = chrono::system_clock::now();
-        time_t now_c = chrono::system_clock::to_time_t(now);
+        // Sync with NTP servers
+        SntpResult result = client.query();
+        if (!result.ok)
+        {
+            cerr << "No agreement between NTP servers:" << endl;
+            for (const auto& s : result.servers)
+            {
+                cerr << "  " << s.server << ": " << (s.error.empty() ? "disagrees" : s.error) << endl;
+            }
+        }
+        else if (discipline.update(result.offset, discipline.monotonicNanos()) == ClockDiscipline<KernelClock>::Failed)
+        {
+            perror("Cannot adjust clock");
+        }
 
         // Format time
-        char timeStr[26];
-        ctime_r(&now_c, timeStr);
-        timeStr[24] = '\0'; // Remove newline character
-
-        // Sync with NTP server
-        system("ntpdate -u pool.ntp.org");
+        char timeStr[32];
+        UtcClock::format(UtcClock::global().nowNanos(), timeStr, 3);
 
         // Print synced time
-        cout << "Time synced: " << timeStr << endl;
+        if (result.ok)
+        {
+            const ClockDisciplineStats& st = discipline.stats();
+            cout << "Time synced: " << timeStr << " UTC (offset " << fixed << setprecision(6) << result.offset / 1e9
+                 << " s, delay " << result.delay / 1e9 << " s, frequency " << setprecision(3) << st.frequency
+                 << " ppm, jitter " << setprecision(6) << st.jitter / 1e9 << " s)" << endl;
+        }
 
         // Wait for 1 minute before syncing again
         this_thread::sleep_for(chrono::minutes(1));
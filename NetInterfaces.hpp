@@ -0,0 +1,496 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <errno.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_arp.h>
+#include "EventLoop.hpp"
+
+// Network interface inventory over RTNETLINK. One dump request returns
+// every link and one more every address, however many interfaces there
+// are, instead of an ioctl (and a socket) per interface. The result is
+// cached by ifindex; watch() keeps it current from the kernel's link and
+// address notifications.
+//
+// Not thread-safe: use it from the thread running the EventLoop it watches.
+
+struct InterfaceAddress
+{
+    int family;              ///< AF_INET or AF_INET6
+    uint8_t prefixLength;
+    uint8_t bytes[16];       ///< Network order; 4 bytes used for AF_INET
+
+    std::string toString() const
+    {
+        char text[INET6_ADDRSTRLEN];
+        inet_ntop(family, bytes, text, sizeof(text));
+        return std::string(text) + "/" + std::to_string(prefixLength);
+    }
+
+    bool operator==(const InterfaceAddress& other) const
+    {
+        return family == other.family && prefixLength == other.prefixLength &&
+               memcmp(bytes, other.bytes, family == AF_INET ? 4 : 16) == 0;
+    }
+};
+
+struct NetInterface
+{
+    int index = 0;
+    std::string name;
+    unsigned flags = 0;              ///< IFF_* flags
+    uint16_t type = 0;               ///< ARPHRD_* link type
+    uint32_t mtu = 0;
+    std::vector<uint8_t> hwAddress;  ///< Six bytes for Ethernet; empty if the link has none
+    std::vector<InterfaceAddress> addresses;
+
+    bool isUp() const { return (flags & IFF_UP) != 0; }
+    bool isLoopback() const { return (flags & IFF_LOOPBACK) != 0; }
+
+    // Colon-separated upper-case hex, as getMacAddress() has always printed it
+    std::string macString() const
+    {
+        std::string text;
+        char hex[4];
+        for (size_t i = 0; i < hwAddress.size(); ++i)
+        {
+            snprintf(hex, sizeof(hex), i ? ":%02X" : "%02X", hwAddress[i]);
+            text += hex;
+        }
+        return text;
+    }
+};
+
+class InterfaceInventory
+{
+public:
+    enum ChangeKind
+    {
+        Added,
+        Removed,
+        Changed,         ///< Name, flags, MTU or hardware address
+        AddressAdded,
+        AddressRemoved,
+        Resynced         ///< Notifications were lost; the whole cache was re-read
+    };
+
+    typedef std::function<void(ChangeKind kind, const NetInterface& iface)> Handler;
+
+    // Opens the netlink socket and reads the current inventory; throws
+    // std::runtime_error if either fails
+    InterfaceInventory() : fd_(openSocket(0)), monitorFd_(-1), seq_(0), loop_(nullptr), dumps_(0), events_(0)
+    {
+        if (!refresh())
+        {
+            close(fd_);
+            throw std::runtime_error(std::string("RTNETLINK dump failed: ") + strerror(errno));
+        }
+    }
+
+    ~InterfaceInventory()
+    {
+        if (monitorFd_ >= 0)
+        {
+            if (loop_)
+            {
+                loop_->removeFd(monitorFd_);
+            }
+            close(monitorFd_);
+        }
+        close(fd_);
+    }
+
+    InterfaceInventory(const InterfaceInventory&) = delete;
+    InterfaceInventory& operator=(const InterfaceInventory&) = delete;
+
+    // Replace the cache with a fresh link and address dump
+    bool refresh()
+    {
+        std::map<int, NetInterface> fresh;
+        bool ok = dump(RTM_GETLINK, [&](const nlmsghdr* h) { applyLink(fresh, h, nullptr); }) &&
+                  dump(RTM_GETADDR, [&](const nlmsghdr* h) { applyAddress(fresh, h, nullptr); });
+        if (ok)
+        {
+            interfaces_.swap(fresh);
+            dumps_++;
+        }
+        return ok;
+    }
+
+    // Follow link and address changes on the loop. The notification socket is
+    // opened before the re-dump, so no change can fall between the two.
+    bool watch(EventLoop& loop, Handler handler)
+    {
+        if (monitorFd_ >= 0)
+        {
+            return false;
+        }
+        monitorFd_ = openSocket(RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR);
+        if (monitorFd_ < 0)
+        {
+            return false;
+        }
+        int size = 1 << 20;
+        setsockopt(monitorFd_, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+        handler_ = std::move(handler);
+        if (!refresh() || !loop.addFd(monitorFd_, EPOLLIN, [this](uint32_t) { drain(); }))
+        {
+            close(monitorFd_);
+            monitorFd_ = -1;
+            return false;
+        }
+        loop_ = &loop;
+        return true;
+    }
+
+    // Cached interfaces in ifindex order
+    std::vector<NetInterface> interfaces() const
+    {
+        std::vector<NetInterface> all;
+        all.reserve(interfaces_.size());
+        for (const auto& kv : interfaces_)
+        {
+            all.push_back(kv.second);
+        }
+        return all;
+    }
+
+    const NetInterface* find(int index) const
+    {
+        auto it = interfaces_.find(index);
+        return it == interfaces_.end() ? nullptr : &it->second;
+    }
+
+    const NetInterface* find(const std::string& name) const
+    {
+        for (const auto& kv : interfaces_)
+        {
+            if (kv.second.name == name)
+            {
+                return &kv.second;
+            }
+        }
+        return nullptr;
+    }
+
+    // The first non-loopback interface with a 6-byte hardware address
+    const NetInterface* firstEthernet() const
+    {
+        for (const auto& kv : interfaces_)
+        {
+            if (!kv.second.isLoopback() && kv.second.hwAddress.size() == 6)
+            {
+                return &kv.second;
+            }
+        }
+        return nullptr;
+    }
+
+    size_t size() const { return interfaces_.size(); }
+    uint64_t dumps() const { return dumps_; }    ///< Full dumps, including resyncs
+    uint64_t events() const { return events_; }  ///< Notifications applied
+
+private:
+    static int openSocket(unsigned groups)
+    {
+        int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | (groups ? SOCK_NONBLOCK : 0), NETLINK_ROUTE);
+        if (fd < 0)
+        {
+            if (groups == 0)
+            {
+                throw std::runtime_error(std::string("netlink socket: ") + strerror(errno));
+            }
+            return -1;
+        }
+        sockaddr_nl local;
+        memset(&local, 0, sizeof(local));
+        local.nl_family = AF_NETLINK;
+        local.nl_groups = groups;
+        if (bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) < 0)
+        {
+            close(fd);
+            if (groups == 0)
+            {
+                throw std::runtime_error(std::string("netlink bind: ") + strerror(errno));
+            }
+            return -1;
+        }
+        return fd;
+    }
+
+    // Send one dump request and feed every reply message to fn
+    template <typename Fn>
+    bool dump(uint16_t type, Fn fn)
+    {
+        struct
+        {
+            nlmsghdr header;
+            union
+            {
+                ifinfomsg link;
+                ifaddrmsg address;
+            };
+            rtattr extMask;
+            uint32_t mask;
+        } request;
+        memset(&request, 0, sizeof(request));
+        request.header.nlmsg_type = type;
+        request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+        request.header.nlmsg_seq = ++seq_;
+        if (type == RTM_GETLINK)
+        {
+            // Counters make up most of each link message and are never used here
+            request.header.nlmsg_len = NLMSG_LENGTH(sizeof(ifinfomsg)) + RTA_LENGTH(sizeof(uint32_t));
+            request.link.ifi_family = AF_UNSPEC;
+            request.extMask.rta_type = IFLA_EXT_MASK;
+            request.extMask.rta_len = RTA_LENGTH(sizeof(uint32_t));
+            request.mask = RTEXT_FILTER_SKIP_STATS;
+        }
+        else
+        {
+            request.header.nlmsg_len = NLMSG_LENGTH(sizeof(ifaddrmsg));
+            request.address.ifa_family = AF_UNSPEC;
+        }
+        if (send(fd_, &request, request.header.nlmsg_len, 0) < 0)
+        {
+            return false;
+        }
+
+        buffer_.resize(64 << 10);
+        for (;;)
+        {
+            ssize_t n = recv(fd_, buffer_.data(), buffer_.size(), MSG_TRUNC);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            if (static_cast<size_t>(n) > buffer_.size())
+            {
+                errno = EMSGSIZE;
+                return false;
+            }
+            size_t len = static_cast<size_t>(n);
+            for (const nlmsghdr* h = reinterpret_cast<const nlmsghdr*>(buffer_.data()); NLMSG_OK(h, len);
+                 h = NLMSG_NEXT(h, len))
+            {
+                if (h->nlmsg_seq != seq_)
+                {
+                    continue;
+                }
+                if (h->nlmsg_type == NLMSG_DONE)
+                {
+                    return true;
+                }
+                if (h->nlmsg_type == NLMSG_ERROR)
+                {
+                    const nlmsgerr* err = static_cast<const nlmsgerr*>(NLMSG_DATA(h));
+                    errno = err->error ? -err->error : EIO;
+                    return false;
+                }
+                fn(h);
+            }
+        }
+    }
+
+    // Read every queued notification and apply it to the cache
+    void drain()
+    {
+        buffer_.resize(64 << 10);
+        for (;;)
+        {
+            ssize_t n = recv(monitorFd_, buffer_.data(), buffer_.size(), 0);
+            if (n < 0)
+            {
+                if (errno == ENOBUFS)
+                {
+                    // The socket overflowed and changes were dropped: start over
+                    if (refresh() && handler_)
+                    {
+                        handler_(Resynced, NetInterface());
+                    }
+                    continue;
+                }
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return;
+            }
+            size_t len = static_cast<size_t>(n);
+            for (const nlmsghdr* h = reinterpret_cast<const nlmsghdr*>(buffer_.data()); NLMSG_OK(h, len);
+                 h = NLMSG_NEXT(h, len))
+            {
+                events_++;
+                if (h->nlmsg_type == RTM_NEWLINK || h->nlmsg_type == RTM_DELLINK)
+                {
+                    applyLink(interfaces_, h, &handler_);
+                }
+                else if (h->nlmsg_type == RTM_NEWADDR || h->nlmsg_type == RTM_DELADDR)
+                {
+                    applyAddress(interfaces_, h, &handler_);
+                }
+            }
+        }
+    }
+
+    static void applyLink(std::map<int, NetInterface>& cache, const nlmsghdr* h, const Handler* notify)
+    {
+        const ifinfomsg* info = static_cast<const ifinfomsg*>(NLMSG_DATA(h));
+        // Only the generic link messages describe the interface itself. The
+        // bridge sends AF_BRIDGE ones about its ports, including an
+        // RTM_DELLINK when a port is released while the link lives on.
+        if (h->nlmsg_len < NLMSG_LENGTH(sizeof(*info)) || info->ifi_family != AF_UNSPEC)
+        {
+            return;
+        }
+        if (h->nlmsg_type == RTM_DELLINK)
+        {
+            auto it = cache.find(info->ifi_index);
+            if (it != cache.end())
+            {
+                NetInterface gone = std::move(it->second);
+                cache.erase(it);
+                if (notify && *notify)
+                {
+                    (*notify)(Removed, gone);
+                }
+            }
+            return;
+        }
+
+        NetInterface link;
+        link.index = info->ifi_index;
+        link.flags = info->ifi_flags;
+        link.type = info->ifi_type;
+        int len = static_cast<int>(IFLA_PAYLOAD(h));
+        for (const rtattr* a = IFLA_RTA(info); RTA_OK(a, len); a = RTA_NEXT(a, len))
+        {
+            const uint8_t* data = static_cast<const uint8_t*>(RTA_DATA(a));
+            size_t size = RTA_PAYLOAD(a);
+            switch (a->rta_type)
+            {
+            case IFLA_IFNAME:
+                link.name.assign(reinterpret_cast<const char*>(data), strnlen(reinterpret_cast<const char*>(data), size));
+                break;
+            case IFLA_ADDRESS:
+                link.hwAddress.assign(data, data + size);
+                break;
+            case IFLA_MTU:
+                if (size >= sizeof(uint32_t))
+                {
+                    memcpy(&link.mtu, data, sizeof(uint32_t));
+                }
+                break;
+            }
+        }
+        // All-zero addresses (loopback, tunnels) are reported as none
+        if (std::all_of(link.hwAddress.begin(), link.hwAddress.end(), [](uint8_t b) { return b == 0; }))
+        {
+            link.hwAddress.clear();
+        }
+
+        auto it = cache.find(link.index);
+        if (it == cache.end())
+        {
+            NetInterface& added = cache[link.index] = std::move(link);
+            if (notify && *notify)
+            {
+                (*notify)(Added, added);
+            }
+            return;
+        }
+        NetInterface& existing = it->second;
+        bool changed = existing.name != link.name || existing.flags != link.flags || existing.mtu != link.mtu ||
+                       existing.hwAddress != link.hwAddress || existing.type != link.type;
+        link.addresses.swap(existing.addresses);
+        existing = std::move(link);
+        if (changed && notify && *notify)
+        {
+            (*notify)(Changed, existing);
+        }
+    }
+
+    static void applyAddress(std::map<int, NetInterface>& cache, const nlmsghdr* h, const Handler* notify)
+    {
+        const ifaddrmsg* info = static_cast<const ifaddrmsg*>(NLMSG_DATA(h));
+        if (h->nlmsg_len < NLMSG_LENGTH(sizeof(*info)) || (info->ifa_family != AF_INET && info->ifa_family != AF_INET6))
+        {
+            return;
+        }
+        auto it = cache.find(static_cast<int>(info->ifa_index));
+        if (it == cache.end())
+        {
+            return;
+        }
+        InterfaceAddress addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.family = info->ifa_family;
+        addr.prefixLength = info->ifa_prefixlen;
+        size_t want = info->ifa_family == AF_INET ? 4 : 16;
+        bool found = false;
+        int len = static_cast<int>(IFA_PAYLOAD(h));
+        for (const rtattr* a = IFA_RTA(info); RTA_OK(a, len); a = RTA_NEXT(a, len))
+        {
+            // IFA_LOCAL is the interface's own address on point-to-point
+            // links, where IFA_ADDRESS is the peer; prefer it when present
+            if ((a->rta_type == IFA_LOCAL || (a->rta_type == IFA_ADDRESS && !found)) && RTA_PAYLOAD(a) >= want)
+            {
+                memcpy(addr.bytes, RTA_DATA(a), want);
+                found = true;
+            }
+        }
+        if (!found)
+        {
+            return;
+        }
+
+        std::vector<InterfaceAddress>& list = it->second.addresses;
+        auto existing = std::find(list.begin(), list.end(), addr);
+        if (h->nlmsg_type == RTM_DELADDR)
+        {
+            if (existing != list.end())
+            {
+                list.erase(existing);
+                if (notify && *notify)
+                {
+                    (*notify)(AddressRemoved, it->second);
+                }
+            }
+        }
+        else if (existing == list.end())
+        {
+            list.push_back(addr);
+            if (notify && *notify)
+            {
+                (*notify)(AddressAdded, it->second);
+            }
+        }
+    }
+
+    int fd_;
+    int monitorFd_;
+    uint32_t seq_;
+    EventLoop* loop_;
+    Handler handler_;
+    std::map<int, NetInterface> interfaces_;
+    std::vector<char> buffer_;
+    uint64_t dumps_;
+    uint64_t events_;
+};
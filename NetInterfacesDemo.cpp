@@ -0,0 +1,402 @@
+#include <iostream>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <sched.h>
+#include <ifaddrs.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+#include <linux/veth.h>
+#include "NetInterfaces.hpp"
+
+// What getMacAddress() did, for every interface: getifaddrs, then a socket
+// and SIOCGIFHWADDR/SIOCGIFMTU ioctls per interface
+struct LegacyInterface
+{
+    std::string name;
+    std::string mac;
+    uint32_t mtu;
+};
+
+static std::vector<LegacyInterface> legacyInventory()
+{
+    std::vector<LegacyInterface> all;
+    struct ifaddrs* ifaddr;
+    if (getifaddrs(&ifaddr) == -1)
+    {
+        perror("getifaddrs");
+        return all;
+    }
+    for (struct ifaddrs* ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next)
+    {
+        if (ifa->ifa_addr && ifa->ifa_addr->sa_family == AF_PACKET)
+        {
+            int fd = socket(AF_INET, SOCK_DGRAM, 0);
+            struct ifreq ifr;
+            strncpy(ifr.ifr_name, ifa->ifa_name, IFNAMSIZ - 1);
+            ifr.ifr_name[IFNAMSIZ - 1] = '\0';
+            LegacyInterface entry{ifa->ifa_name, "", 0};
+            if (ioctl(fd, SIOCGIFHWADDR, &ifr) != -1)
+            {
+                unsigned char* mac = reinterpret_cast<unsigned char*>(ifr.ifr_hwaddr.sa_data);
+                char macStr[18];
+                snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+                entry.mac = macStr == std::string("00:00:00:00:00:00") ? "" : macStr;
+            }
+            if (ioctl(fd, SIOCGIFMTU, &ifr) != -1)
+            {
+                entry.mtu = static_cast<uint32_t>(ifr.ifr_mtu);
+            }
+            close(fd);
+            all.push_back(entry);
+        }
+    }
+    freeifaddrs(ifaddr);
+    return all;
+}
+
+// Minimal RTNETLINK requests to create and delete test links
+class LinkControl
+{
+public:
+    LinkControl() : fd_(socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE)), seq_(0) {}
+    ~LinkControl() { close(fd_); }
+
+    bool createBridge(const std::string& name)
+    {
+        Request r(RTM_NEWLINK, NLM_F_CREATE | NLM_F_EXCL, ++seq_);
+        r.attr(IFLA_IFNAME, name.c_str(), name.size() + 1);
+        rtattr* info = r.begin(IFLA_LINKINFO);
+        r.attr(IFLA_INFO_KIND, "bridge", 7);
+        r.end(info);
+        return transact(r);
+    }
+
+    bool createVeth(const std::string& name, const std::string& peer)
+    {
+        Request r(RTM_NEWLINK, NLM_F_CREATE | NLM_F_EXCL, ++seq_);
+        r.attr(IFLA_IFNAME, name.c_str(), name.size() + 1);
+        rtattr* info = r.begin(IFLA_LINKINFO);
+        r.attr(IFLA_INFO_KIND, "veth", 5);
+        rtattr* data = r.begin(IFLA_INFO_DATA);
+        rtattr* peerInfo = r.begin(VETH_INFO_PEER);
+        ifinfomsg peerLink;
+        memset(&peerLink, 0, sizeof(peerLink));
+        r.raw(&peerLink, sizeof(peerLink));
+        r.attr(IFLA_IFNAME, peer.c_str(), peer.size() + 1);
+        r.end(peerInfo);
+        r.end(data);
+        r.end(info);
+        return transact(r);
+    }
+
+    // ip link set <name> master <master>, or nomaster with an empty master
+    bool setMaster(const std::string& name, const std::string& master)
+    {
+        Request r(RTM_NEWLINK, 0, ++seq_);
+        r.attr(IFLA_IFNAME, name.c_str(), name.size() + 1);
+        uint32_t index = master.empty() ? 0 : if_nametoindex(master.c_str());
+        r.attr(IFLA_MASTER, &index, sizeof(index));
+        return transact(r);
+    }
+
+    bool deleteLink(const std::string& name)
+    {
+        Request r(RTM_DELLINK, 0, ++seq_);
+        r.attr(IFLA_IFNAME, name.c_str(), name.size() + 1);
+        return transact(r);
+    }
+
+    bool setMtu(const std::string& name, int mtu)
+    {
+        struct ifreq ifr;
+        memset(&ifr, 0, sizeof(ifr));
+        strncpy(ifr.ifr_name, name.c_str(), IFNAMSIZ - 1);
+        ifr.ifr_mtu = mtu;
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        bool ok = ioctl(fd, SIOCSIFMTU, &ifr) == 0;
+        close(fd);
+        return ok;
+    }
+
+    bool addIPv4(const std::string& name, const char* address)
+    {
+        struct ifreq ifr;
+        memset(&ifr, 0, sizeof(ifr));
+        strncpy(ifr.ifr_name, name.c_str(), IFNAMSIZ - 1);
+        sockaddr_in* sin = reinterpret_cast<sockaddr_in*>(&ifr.ifr_addr);
+        sin->sin_family = AF_INET;
+        inet_pton(AF_INET, address, &sin->sin_addr);
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        bool ok = ioctl(fd, SIOCSIFADDR, &ifr) == 0;
+        close(fd);
+        return ok;
+    }
+
+private:
+    struct Request
+    {
+        nlmsghdr header;
+        ifinfomsg info;
+        char attrs[256];
+
+        Request(uint16_t type, uint16_t flags, uint32_t seq)
+        {
+            memset(this, 0, sizeof(*this));
+            header.nlmsg_len = NLMSG_LENGTH(sizeof(ifinfomsg));
+            header.nlmsg_type = type;
+            header.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | flags;
+            header.nlmsg_seq = seq;
+            info.ifi_family = AF_UNSPEC;
+        }
+
+        rtattr* attr(uint16_t type, const void* data, size_t size)
+        {
+            rtattr* a = reinterpret_cast<rtattr*>(reinterpret_cast<char*>(this) + NLMSG_ALIGN(header.nlmsg_len));
+            a->rta_type = type;
+            a->rta_len = static_cast<uint16_t>(RTA_LENGTH(size));
+            memcpy(RTA_DATA(a), data, size);
+            header.nlmsg_len = NLMSG_ALIGN(header.nlmsg_len) + RTA_ALIGN(a->rta_len);
+            return a;
+        }
+
+        rtattr* begin(uint16_t type) { return attr(type, nullptr, 0); }
+
+        // Unframed bytes, such as the ifinfomsg heading a nested link
+        void raw(const void* data, size_t size)
+        {
+            memcpy(reinterpret_cast<char*>(this) + NLMSG_ALIGN(header.nlmsg_len), data, size);
+            header.nlmsg_len = NLMSG_ALIGN(header.nlmsg_len) + NLMSG_ALIGN(size);
+        }
+
+        void end(rtattr* nest)
+        {
+            nest->rta_len = static_cast<uint16_t>(reinterpret_cast<char*>(this) + header.nlmsg_len -
+                                                  reinterpret_cast<char*>(nest));
+        }
+    };
+
+    bool transact(const Request& r)
+    {
+        if (send(fd_, &r, r.header.nlmsg_len, 0) < 0)
+        {
+            return false;
+        }
+        char reply[1024];
+        ssize_t n = recv(fd_, reply, sizeof(reply), 0);
+        const nlmsghdr* h = reinterpret_cast<const nlmsghdr*>(reply);
+        return n > 0 && h->nlmsg_type == NLMSG_ERROR && static_cast<const nlmsgerr*>(NLMSG_DATA(h))->error == 0;
+    }
+
+    int fd_;
+    uint32_t seq_;
+};
+
+static bool check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        std::cerr << "Self-test failed: " << what << std::endl;
+    }
+    return ok;
+}
+
+#define SELF_CHECK(cond) ok &= check((cond), #cond)
+
+// The netlink view must agree with getifaddrs + ioctl on every interface
+static bool sameAsLegacy(const InterfaceInventory& inventory)
+{
+    std::vector<LegacyInterface> legacy = legacyInventory();
+    size_t differ = legacy.size() != inventory.size();
+    for (const auto& l : legacy)
+    {
+        const NetInterface* iface = inventory.find(l.name);
+        differ += !iface || iface->macString() != l.mac || iface->mtu != l.mtu;
+    }
+    return differ == 0;
+}
+
+static bool selfTest(LinkControl& links)
+{
+    bool ok = true;
+    for (int i = 0; i < 8; ++i)
+    {
+        SELF_CHECK(links.createBridge("test" + std::to_string(i)));
+    }
+    InterfaceInventory inventory;
+    SELF_CHECK(inventory.size() == 9); // lo plus the bridges
+    SELF_CHECK(sameAsLegacy(inventory));
+    SELF_CHECK(inventory.find("test3") && inventory.find("test3")->hwAddress.size() == 6);
+    SELF_CHECK(inventory.find("lo") && inventory.find("lo")->isLoopback() && inventory.find("lo")->hwAddress.empty());
+
+    EventLoop loop;
+    std::vector<std::pair<InterfaceInventory::ChangeKind, std::string>> seen;
+    SELF_CHECK(inventory.watch(loop, [&](InterfaceInventory::ChangeKind kind, const NetInterface& iface)
+    {
+        seen.push_back({kind, iface.name});
+    }));
+    auto saw = [&](InterfaceInventory::ChangeKind kind, const std::string& name)
+    {
+        return std::find(seen.begin(), seen.end(), std::make_pair(kind, name)) != seen.end();
+    };
+
+    // Each step waits for the notification the previous change should cause,
+    // checks the cache followed it, then makes the next change. Removal in
+    // particular is announced some time after the request is acknowledged.
+    std::vector<std::function<bool()>> steps;
+    steps.push_back([&]() { return links.createBridge("watch0"); });
+    steps.push_back([&]()
+    {
+        if (!saw(InterfaceInventory::Added, "watch0"))
+        {
+            return false;
+        }
+        SELF_CHECK(inventory.find("watch0") != nullptr);
+        return links.setMtu("watch0", 1400);
+    });
+    steps.push_back([&]()
+    {
+        if (!saw(InterfaceInventory::Changed, "watch0"))
+        {
+            return false;
+        }
+        SELF_CHECK(inventory.find("watch0") && inventory.find("watch0")->mtu == 1400);
+        return links.addIPv4("watch0", "192.0.2.7");
+    });
+    steps.push_back([&]()
+    {
+        if (!saw(InterfaceInventory::AddressAdded, "watch0"))
+        {
+            return false;
+        }
+        const NetInterface* w = inventory.find("watch0");
+        SELF_CHECK(w && w->addresses.size() == 1 && w->addresses[0].toString() == "192.0.2.7/24");
+        return links.createVeth("d0", "d1") && links.addIPv4("d0", "198.51.100.1");
+    });
+    // A port joining and leaving a bridge is not a link going away: the
+    // bridge's own AF_BRIDGE RTM_DELLINK on release must be ignored. The MTU
+    // change afterwards marks when the watcher has read that far.
+    steps.push_back([&]()
+    {
+        if (!saw(InterfaceInventory::AddressAdded, "d0"))
+        {
+            return false;
+        }
+        return links.setMaster("d0", "watch0") && links.setMaster("d0", "") && links.setMtu("d0", 1300);
+    });
+    steps.push_back([&]()
+    {
+        if (!saw(InterfaceInventory::Changed, "d0") || !inventory.find("d0") || inventory.find("d0")->mtu != 1300)
+        {
+            return false;
+        }
+        SELF_CHECK(!saw(InterfaceInventory::Removed, "d0"));
+        SELF_CHECK(std::count(seen.begin(), seen.end(), std::make_pair(InterfaceInventory::Added, std::string("d0"))) == 1);
+        const NetInterface* d = inventory.find("d0");
+        SELF_CHECK(d && d->addresses.size() == 1 && d->addresses[0].toString() == "198.51.100.1/24");
+        return links.deleteLink("test0") && links.deleteLink("watch0") && links.deleteLink("d0");
+    });
+    steps.push_back([&]()
+    {
+        if (!saw(InterfaceInventory::Removed, "test0") || !saw(InterfaceInventory::Removed, "watch0") ||
+            !saw(InterfaceInventory::Removed, "d0") || !saw(InterfaceInventory::Removed, "d1"))
+        {
+            return false;
+        }
+        SELF_CHECK(!inventory.find("watch0") && inventory.size() == 8);
+        SELF_CHECK(sameAsLegacy(inventory));
+        loop.stop();
+        return true;
+    });
+    size_t next = 0, ticks = 0;
+    loop.addTimer(std::chrono::milliseconds(10), std::chrono::milliseconds(10), [&]()
+    {
+        if (steps[next]())
+        {
+            next++;
+        }
+        else if (++ticks == 500)
+        {
+            SELF_CHECK(!"timed out waiting for a link notification");
+            loop.stop();
+        }
+    });
+    loop.run();
+
+    SELF_CHECK(inventory.dumps() == 2 && inventory.events() > 0);
+    for (int i = 1; i < 8; ++i)
+    {
+        links.deleteLink("test" + std::to_string(i));
+    }
+    if (ok)
+    {
+        std::cout << "Self-test passed (" << seen.size() << " changes followed, " << inventory.events()
+                  << " notifications)" << std::endl;
+    }
+    return ok;
+}
+
+template <typename Fn>
+static double milliseconds(Fn fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void printInventory(const InterfaceInventory& inventory)
+{
+    for (const auto& iface : inventory.interfaces())
+    {
+        std::cout << "  " << iface.index << ": " << iface.name << " mtu " << iface.mtu << (iface.isUp() ? " up" : " down");
+        if (!iface.hwAddress.empty())
+        {
+            std::cout << " " << iface.macString();
+        }
+        for (const auto& a : iface.addresses)
+        {
+            std::cout << " " << a.toString();
+        }
+        std::cout << std::endl;
+    }
+}
+
+int main()
+{
+    InterfaceInventory host;
+    std::cout << "Host interfaces:" << std::endl;
+    printInventory(host);
+
+    // The rest runs in a private network namespace so the host is untouched
+    if (unshare(CLONE_NEWNET) != 0)
+    {
+        perror("unshare(CLONE_NEWNET) (self-test and benchmark need CAP_SYS_ADMIN)");
+        return 0;
+    }
+    LinkControl links;
+    if (!selfTest(links))
+    {
+        return 1;
+    }
+
+    const int count = 2000;
+    for (int i = 0; i < count; ++i)
+    {
+        links.createBridge("br" + std::to_string(i));
+    }
+    InterfaceInventory inventory;
+    double legacy = 1e9, netlink = 1e9;
+    size_t legacyCount = 0;
+    for (int run = 0; run < 3; ++run)
+    {
+        legacy = std::min(legacy, milliseconds([&]() { legacyCount = legacyInventory().size(); }));
+        netlink = std::min(netlink, milliseconds([&]() { inventory.refresh(); }));
+    }
+    std::cout << inventory.size() << " interfaces (" << legacyCount << " via getifaddrs)" << std::endl;
+    std::cout << "getifaddrs + socket/ioctl per interface: " << legacy << " ms" << std::endl;
+    std::cout << "RTNETLINK link + address dump:           " << netlink << " ms" << std::endl;
+    return sameAsLegacy(inventory) ? 0 : 1;
+}
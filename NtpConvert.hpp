@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include "NtpTime.hpp"
+
+// Whole-second conversions kept for existing callers; NtpTime.hpp has the
+// sub-second, era-aware API these are built on.
+
+// Convert a 64-bit NTP timestamp (32.32 fixed point, 1900 epoch) to UTC seconds
+inline std::time_t ntpToUtc(uint64_t ntpTime)
+{
+    return NtpTimestamp(ntpTime).toTimeT();
+}
+
+// Convert a 64-bit NTP timestamp to GMT seconds (GMT and UTC seconds are the same count)
+inline std::time_t ntpToGmtTime(uint64_t ntpTime)
+{
+    return ntpToUtc(ntpTime);
+}
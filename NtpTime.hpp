@@ -0,0 +1,232 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include "ByteSwap.hpp"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// NTP timestamps as 32.32 fixed point (seconds since 1900 in the high word,
+// 2^-32 s units in the low word) with exact conversions to and from Unix
+// time. One fraction unit is about 233 ps, so converting nanoseconds to NTP
+// and back always returns the same nanosecond; the other way round rounds
+// to the nearest nanosecond.
+//
+// The 32-bit seconds field wraps every 2^32 s (136 years; era 1 began on
+// 2036-02-07). A bare timestamp does not say which era it is in, so
+// conversions to Unix time place it in the 136-year window starting
+// 1968-01-20 (RFC 4330 section 3: high bit clear means era 1), or in the
+// window centred on a caller-supplied pivot time.
+
+namespace ntp_detail
+{
+
+constexpr int64_t kNanosPerSecond = 1000000000;
+constexpr int64_t kUnixEpoch = 2208988800LL;   ///< Seconds from 1900-01-01 to 1970-01-01
+constexpr int64_t kEraSeconds = int64_t(1) << 32;
+
+// Fraction of a second in 2^-32 units to nanoseconds, rounded to nearest
+inline uint32_t fractionToNanos(uint32_t fraction)
+{
+    return static_cast<uint32_t>((static_cast<uint64_t>(fraction) * kNanosPerSecond + 0x80000000u) >> 32);
+}
+
+// Nanoseconds (below one second) to 2^-32 units, rounded to nearest.
+// Rounded this way, fractionToNanos() recovers the input exactly.
+inline uint32_t nanosToFraction(uint32_t nanos)
+{
+    return static_cast<uint32_t>(((static_cast<uint64_t>(nanos) << 32) + kNanosPerSecond / 2) / kNanosPerSecond);
+}
+
+// Floor division and modulo by one second for signed nanosecond counts
+inline int64_t floorSeconds(int64_t nanos)
+{
+    int64_t s = nanos / kNanosPerSecond;
+    return s - (nanos % kNanosPerSecond < 0);
+}
+
+} // namespace ntp_detail
+
+class NtpTimestamp
+{
+public:
+    constexpr NtpTimestamp() : raw_(0) {}
+    constexpr explicit NtpTimestamp(uint64_t raw) : raw_(raw) {}
+    constexpr NtpTimestamp(uint32_t seconds, uint32_t fraction)
+        : raw_(static_cast<uint64_t>(seconds) << 32 | fraction) {}
+
+    constexpr uint64_t raw() const { return raw_; }
+    constexpr uint32_t seconds() const { return static_cast<uint32_t>(raw_ >> 32); }
+    constexpr uint32_t fraction() const { return static_cast<uint32_t>(raw_); }
+
+    // 8 bytes big-endian, as in the NTP packet's timestamp fields
+    static NtpTimestamp fromWire(const void* p) { return NtpTimestamp(loadBE<uint64_t>(p)); }
+    void toWire(void* p) const { storeBE<uint64_t>(p, raw_); }
+
+    // Unix time in nanoseconds; the era comes from the RFC 4330 window
+    int64_t toUnixNanos() const
+    {
+        int64_t era = (seconds() & 0x80000000u) ? 0 : ntp_detail::kEraSeconds;
+        return (static_cast<int64_t>(seconds()) + era - ntp_detail::kUnixEpoch) * ntp_detail::kNanosPerSecond +
+               ntp_detail::fractionToNanos(fraction());
+    }
+
+    // Unix time in nanoseconds, in whichever era puts it within 68 years of
+    // pivot (a Unix time in seconds, e.g. the local clock or a build date)
+    int64_t toUnixNanos(int64_t pivot) const
+    {
+        // Seconds since 1900 of this timestamp in the pivot's era, then
+        // moved by one era if that is nearer
+        int64_t pivotNtp = pivot + ntp_detail::kUnixEpoch;
+        int64_t base = pivotNtp - (pivotNtp & (ntp_detail::kEraSeconds - 1));
+        int64_t s = base + seconds();
+        if (s - pivotNtp > ntp_detail::kEraSeconds / 2)
+        {
+            s -= ntp_detail::kEraSeconds;
+        }
+        else if (pivotNtp - s > ntp_detail::kEraSeconds / 2)
+        {
+            s += ntp_detail::kEraSeconds;
+        }
+        return (s - ntp_detail::kUnixEpoch) * ntp_detail::kNanosPerSecond + ntp_detail::fractionToNanos(fraction());
+    }
+
+    // Any Unix time; the era is dropped, as on the wire
+    static NtpTimestamp fromUnixNanos(int64_t nanos)
+    {
+        int64_t s = ntp_detail::floorSeconds(nanos);
+        uint32_t ns = static_cast<uint32_t>(nanos - s * ntp_detail::kNanosPerSecond);
+        uint32_t fraction = ntp_detail::nanosToFraction(ns);
+        return NtpTimestamp(static_cast<uint32_t>(s + ntp_detail::kUnixEpoch), fraction);
+    }
+
+    struct timespec toTimespec() const
+    {
+        int64_t nanos = toUnixNanos();
+        struct timespec ts;
+        ts.tv_sec = static_cast<time_t>(ntp_detail::floorSeconds(nanos));
+        ts.tv_nsec = static_cast<long>(nanos - static_cast<int64_t>(ts.tv_sec) * ntp_detail::kNanosPerSecond);
+        return ts;
+    }
+
+    static NtpTimestamp fromTimespec(const struct timespec& ts)
+    {
+        return NtpTimestamp(static_cast<uint32_t>(static_cast<int64_t>(ts.tv_sec) + ntp_detail::kUnixEpoch),
+                            ntp_detail::nanosToFraction(static_cast<uint32_t>(ts.tv_nsec)));
+    }
+
+    std::chrono::system_clock::time_point toSystemClock() const
+    {
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(toUnixNanos())));
+    }
+
+    static NtpTimestamp fromSystemClock(std::chrono::system_clock::time_point t)
+    {
+        return fromUnixNanos(std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count());
+    }
+
+    // Whole Unix seconds, rounding down (the fraction is never negative)
+    std::time_t toTimeT() const
+    {
+        int64_t era = (seconds() & 0x80000000u) ? 0 : ntp_detail::kEraSeconds;
+        return static_cast<std::time_t>(static_cast<int64_t>(seconds()) + era - ntp_detail::kUnixEpoch);
+    }
+
+    static NtpTimestamp now()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return fromTimespec(ts);
+    }
+
+    constexpr bool operator==(NtpTimestamp other) const { return raw_ == other.raw_; }
+    constexpr bool operator!=(NtpTimestamp other) const { return raw_ != other.raw_; }
+
+private:
+    uint64_t raw_;
+};
+
+// Signed difference a - b in nanoseconds. Wraps like the wire format, so it
+// is correct across an era boundary as long as |a - b| < 68 years.
+inline int64_t ntpDiffNanos(NtpTimestamp a, NtpTimestamp b)
+{
+    int64_t d = static_cast<int64_t>(a.raw() - b.raw()); // 32.32 signed
+    int64_t s = d >> 32;                                 // floor
+    uint32_t f = static_cast<uint32_t>(d);
+    return s * ntp_detail::kNanosPerSecond + ntp_detail::fractionToNanos(f);
+}
+
+// 16.16 "short format" used for root delay and root dispersion
+inline int64_t ntpShortToNanos(uint32_t value)
+{
+    return (static_cast<int64_t>(value) * ntp_detail::kNanosPerSecond + 0x8000) >> 16;
+}
+
+inline uint32_t nanosToNtpShort(int64_t nanos)
+{
+    return static_cast<uint32_t>(((nanos << 16) + ntp_detail::kNanosPerSecond / 2) / ntp_detail::kNanosPerSecond);
+}
+
+// Batch conversion of raw timestamps to Unix nanoseconds (RFC 4330 era
+// window); results match toUnixNanos() exactly. Both multiplies are 32x32
+// -> 64 bit, which SSE2 does two at a time (pmuludq); the compiler will not
+// vectorize 64-bit lanes on its own, so the kernel is written out.
+inline void ntpToUnixNanos(const uint64_t* in, int64_t* out, size_t n)
+{
+    const uint64_t kOffset = static_cast<uint64_t>(ntp_detail::kUnixEpoch) * ntp_detail::kNanosPerSecond;
+    const uint64_t kEra = static_cast<uint64_t>(ntp_detail::kEraSeconds) * ntp_detail::kNanosPerSecond;
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128i billion = _mm_set1_epi64x(ntp_detail::kNanosPerSecond);
+    const __m128i half = _mm_set1_epi64x(0x80000000);
+    const __m128i one = _mm_set1_epi64x(1);
+    const __m128i era = _mm_set1_epi64x(static_cast<int64_t>(kEra));
+    const __m128i offset = _mm_set1_epi64x(static_cast<int64_t>(kOffset));
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i whole = _mm_mul_epu32(_mm_srli_epi64(v, 32), billion);
+        __m128i frac = _mm_srli_epi64(_mm_add_epi64(_mm_mul_epu32(v, billion), half), 32);
+        // All ones where the seconds' high bit is clear (era 1)
+        __m128i eraMask = _mm_sub_epi64(_mm_srli_epi64(v, 63), one);
+        __m128i nanos = _mm_add_epi64(_mm_add_epi64(whole, frac), _mm_and_si128(eraMask, era));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_sub_epi64(nanos, offset));
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        uint64_t seconds = in[i] >> 32;
+        uint64_t fraction = in[i] & 0xFFFFFFFFu;
+        uint64_t nanos = seconds * ntp_detail::kNanosPerSecond + ((fraction * ntp_detail::kNanosPerSecond + 0x80000000u) >> 32);
+        out[i] = static_cast<int64_t>(nanos + ((seconds & 0x80000000u) ? 0 : kEra) - kOffset);
+    }
+}
+
+// Batch conversion of big-endian wire timestamps (8 bytes each, e.g. copied
+// out of a packet capture) to Unix nanoseconds: byte-swapped in blocks with
+// the bulk swap kernels, then converted as above
+inline void ntpWireToUnixNanos(const void* wire, int64_t* out, size_t n)
+{
+    const uint64_t* p = static_cast<const uint64_t*>(wire);
+    uint64_t block[256];
+    for (size_t done = 0; done < n;)
+    {
+        size_t m = n - done < 256 ? n - done : 256;
+        bigEndianToHostArray(p + done, block, m);
+        ntpToUnixNanos(block, out + done, m);
+        done += m;
+    }
+}
+
+// Batch conversion of Unix nanoseconds to raw timestamps
+inline void unixNanosToNtp(const int64_t* in, uint64_t* out, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        out[i] = NtpTimestamp::fromUnixNanos(in[i]).raw();
+    }
+}
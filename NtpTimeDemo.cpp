@@ -0,0 +1,212 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include "NtpConvert.hpp"
+
+// The conversions as they were before NtpTime.hpp: whole seconds, no era
+static std::time_t legacyNtpToUtc(uint64_t ntpTime)
+{
+    const uint64_t ntpFracPerSec = 0x100000000;
+    const uint64_t ntpEpochOffset = 0x83AA7E80;
+    uint64_t ntpSecs = ntpTime / ntpFracPerSec;
+    return static_cast<std::time_t>(ntpSecs - ntpEpochOffset);
+}
+
+// ntpdate-sync.cpp's conversion, through a double
+static double legacyNtpToDouble(uint64_t ntpTime)
+{
+    uint32_t seconds = static_cast<uint32_t>(ntpTime >> 32);
+    uint32_t fraction = static_cast<uint32_t>(ntpTime);
+    double timestamp = seconds + fraction / 4294967296.0;
+    return timestamp - 2208988800U;
+}
+
+static bool check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        std::cerr << "Self-test failed: " << what << std::endl;
+    }
+    return ok;
+}
+
+#define SELF_CHECK(cond) ok &= check((cond), #cond)
+
+static bool selfTest()
+{
+    bool ok = true;
+    const int64_t kNs = 1000000000;
+    std::mt19937_64 rng(9);
+
+    // Nanoseconds -> NTP -> nanoseconds is exact anywhere in the era window
+    // (1968-01-20 to 2104-02-26); NTP -> ns -> NTP is within rounding
+    size_t inexact = 0, drift = 0;
+    for (int i = 0; i < 1000000; ++i)
+    {
+        int64_t ns = static_cast<int64_t>(rng() % (4294967296ull * kNs)) - 61505152LL * kNs;
+        inexact += NtpTimestamp::fromUnixNanos(ns).toUnixNanos() != ns;
+        NtpTimestamp t(rng());
+        int64_t back = static_cast<int64_t>(NtpTimestamp::fromUnixNanos(t.toUnixNanos()).raw() - t.raw());
+        drift += std::llabs(back) > 3;
+    }
+    SELF_CHECK(inexact == 0);
+    SELF_CHECK(drift == 0);
+
+    // Era boundaries
+    SELF_CHECK(NtpTimestamp(0, 0).toUnixNanos() == 2085978496LL * kNs);           // 2036-02-07T06:28:16Z
+    SELF_CHECK(NtpTimestamp(0x80000000u, 0).toUnixNanos() == -61505152LL * kNs);   // 1968-01-20T03:14:08Z
+    SELF_CHECK(NtpTimestamp(0, 0).toUnixNanos(-2208988800LL) == -2208988800LL * kNs); // pivot 1900: 1900-01-01
+    SELF_CHECK(NtpTimestamp(0, 0).toUnixNanos(0) == 2085978496LL * kNs);           // pivot 1970: 2036 is nearer
+    SELF_CHECK(NtpTimestamp(0, 0).toUnixNanos(2000000000) == 2085978496LL * kNs); // pivot 2033: 2036
+    SELF_CHECK(NtpTimestamp(5, 0).toUnixNanos(4000000000LL) == (2085978496LL + 5) * kNs);
+    SELF_CHECK(ntpDiffNanos(NtpTimestamp(2, 0), NtpTimestamp(0xFFFFFFFFu, 0x80000000u)) == 2500000000LL);
+    SELF_CHECK(ntpDiffNanos(NtpTimestamp(0xFFFFFFFFu, 0x80000000u), NtpTimestamp(2, 0)) == -2500000000LL);
+
+    // timespec and system_clock agree with the nanosecond form
+    NtpTimestamp t = NtpTimestamp::fromUnixNanos(1700000000123456789LL);
+    struct timespec ts = t.toTimespec();
+    SELF_CHECK(ts.tv_sec == 1700000000 && ts.tv_nsec == 123456789);
+    SELF_CHECK(NtpTimestamp::fromTimespec(ts) == t);
+    SELF_CHECK(NtpTimestamp::fromSystemClock(t.toSystemClock()) == t);
+    struct timespec before = {-1, 999999999};
+    SELF_CHECK(NtpTimestamp::fromTimespec(before).toUnixNanos() == -1);
+    SELF_CHECK(NtpTimestamp::fromUnixNanos(-1).toTimespec().tv_sec == -1);
+
+    unsigned char wire[8];
+    t.toWire(wire);
+    SELF_CHECK(NtpTimestamp::fromWire(wire) == t && wire[0] == t.seconds() >> 24);
+    SELF_CHECK(ntpShortToNanos(0x00010000) == kNs && ntpShortToNanos(nanosToNtpShort(1500000)) - 1500000 < 8000);
+
+    // The old whole-second functions give the same answers in era 0
+    size_t legacyDiffer = 0;
+    for (int i = 0; i < 100000; ++i)
+    {
+        uint64_t raw = rng() | 0x8000000000000000ull;
+        legacyDiffer += ntpToUtc(raw) != legacyNtpToUtc(raw) || ntpToGmtTime(raw) != legacyNtpToUtc(raw);
+    }
+    SELF_CHECK(legacyDiffer == 0);
+
+    // Batch kernels match the scalar conversion, odd lengths included
+    std::vector<uint64_t> raw(1001);
+    for (auto& r : raw)
+    {
+        r = rng();
+    }
+    std::vector<int64_t> batch(raw.size()), fromWire(raw.size());
+    std::vector<unsigned char> packets(raw.size() * 8);
+    for (size_t i = 0; i < raw.size(); ++i)
+    {
+        NtpTimestamp(raw[i]).toWire(&packets[i * 8]);
+    }
+    ntpToUnixNanos(raw.data(), batch.data(), raw.size());
+    ntpWireToUnixNanos(packets.data(), fromWire.data(), raw.size());
+    size_t batchDiffer = 0;
+    for (size_t i = 0; i < raw.size(); ++i)
+    {
+        int64_t expected = NtpTimestamp(raw[i]).toUnixNanos();
+        batchDiffer += batch[i] != expected || fromWire[i] != expected;
+    }
+    SELF_CHECK(batchDiffer == 0);
+    std::vector<uint64_t> again(raw.size());
+    unixNanosToNtp(batch.data(), again.data(), raw.size());
+    SELF_CHECK(NtpTimestamp(again[7]) == NtpTimestamp::fromUnixNanos(batch[7]));
+
+    if (ok)
+    {
+        std::cout << "Self-test passed (1M round trips exact, eras, batch == scalar)" << std::endl;
+    }
+    return ok;
+}
+
+template <typename Fn>
+static double nanosPer(size_t count, Fn fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+}
+
+int main()
+{
+    if (!selfTest())
+    {
+        return 1;
+    }
+
+    NtpTimestamp now = NtpTimestamp::now();
+    struct timespec ts = now.toTimespec();
+    std::cout << "Now: NTP " << std::hex << now.seconds() << "." << now.fraction() << std::dec << " = Unix " << ts.tv_sec << "."
+              << ts.tv_nsec << std::endl;
+
+    // Packet timestamps a few microseconds apart, in a block that stays in
+    // cache so the conversion rather than memory bandwidth is measured
+    const size_t count = 8192, reps = 1024;
+    std::vector<uint64_t> raw(count);
+    uint64_t base = now.raw();
+    for (size_t i = 0; i < count; ++i)
+    {
+        raw[i] = base + i * 12345;
+    }
+    std::vector<int64_t> nanos(count);
+    std::vector<std::time_t> seconds(count);
+    std::vector<double> doubles(count);
+
+    double legacy = 1e9, scalar = 1e9, batch = 1e9, viaDouble = 1e9;
+    for (int run = 0; run < 3; ++run)
+    {
+        legacy = std::min(legacy, nanosPer(count * reps, [&]()
+        {
+            for (size_t r = 0; r < reps; ++r)
+            {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    seconds[i] = legacyNtpToUtc(raw[i] + r);
+                }
+            }
+        }));
+        viaDouble = std::min(viaDouble, nanosPer(count * reps, [&]()
+        {
+            for (size_t r = 0; r < reps; ++r)
+            {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    doubles[i] = legacyNtpToDouble(raw[i] + r);
+                }
+            }
+        }));
+        scalar = std::min(scalar, nanosPer(count * reps, [&]()
+        {
+            for (size_t r = 0; r < reps; ++r)
+            {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    nanos[i] = NtpTimestamp(raw[i] + r).toUnixNanos();
+                }
+            }
+        }));
+        batch = std::min(batch, nanosPer(count * reps, [&]()
+        {
+            for (size_t r = 0; r < reps; ++r)
+            {
+                raw[r % count] += 1;
+                ntpToUnixNanos(raw.data(), nanos.data(), count);
+            }
+        }));
+    }
+
+    double worst = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        double exact = static_cast<double>(NtpTimestamp(raw[i]).toUnixNanos());
+        worst = std::max(worst, std::fabs(legacyNtpToDouble(raw[i]) * 1e9 - exact));
+    }
+    std::cout << "ns per timestamp:" << std::endl;
+    std::cout << "  ntpToUtc before (whole seconds)    " << legacy << std::endl;
+    std::cout << "  via double (ntpdate-sync)          " << viaDouble << ", off by up to " << worst << " ns" << std::endl;
+    std::cout << "  NtpTimestamp::toUnixNanos          " << scalar << std::endl;
+    std::cout << "  ntpToUnixNanos batch               " << batch << std::endl;
+    return 0;
+}
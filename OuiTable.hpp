@@ -0,0 +1,358 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Vendor lookup by 24-bit OUI (the first three octets of a MAC address)
+// through a hash-and-displace perfect hash built at load time. A lookup is
+// a few multiplies and two table reads with no probing; classify() runs a
+// batch with the table reads prefetched ahead of use. MACs are 48-bit
+// integers, most significant octet first, so nothing is formatted or
+// allocated per address.
+
+namespace oui_detail
+{
+
+inline uint32_t bucketOf(uint32_t key, unsigned bits)
+{
+    return static_cast<uint32_t>((static_cast<uint64_t>(key) * 0xC2B2AE3D27D4EB4Full) >> (64 - bits));
+}
+
+// Mixed rather than a single multiply: with a linear hash, two keys that
+// collide for one displacement would collide for all of them
+inline uint32_t slotOf(uint32_t key, uint32_t displacement, unsigned bits)
+{
+    uint64_t x = key * 0x9E3779B97F4A7C15ull + displacement;
+    x ^= x >> 29;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 32;
+    return static_cast<uint32_t>(x >> (64 - bits));
+}
+
+inline int hexDigit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    c = static_cast<char>(c | 0x20);
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// Six hex digits, optionally split by '-' or ':' after each pair
+inline bool parsePrefix(std::string_view s, uint32_t* prefix, size_t* used)
+{
+    uint32_t value = 0;
+    size_t i = 0;
+    for (int digits = 0; digits < 6; ++digits)
+    {
+        if (digits > 0 && digits % 2 == 0 && i < s.size() && (s[i] == '-' || s[i] == ':'))
+        {
+            ++i;
+        }
+        int d = i < s.size() ? hexDigit(s[i]) : -1;
+        if (d < 0)
+        {
+            return false;
+        }
+        value = value << 4 | static_cast<uint32_t>(d);
+        ++i;
+    }
+    *prefix = value;
+    *used = i;
+    return true;
+}
+
+inline std::string_view trim(std::string_view s)
+{
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+    {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r'))
+    {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+} // namespace oui_detail
+
+// 48-bit MAC from its six octets
+inline uint64_t macToInt(const uint8_t bytes[6])
+{
+    return static_cast<uint64_t>(bytes[0]) << 40 | static_cast<uint64_t>(bytes[1]) << 32 |
+           static_cast<uint64_t>(bytes[2]) << 24 | static_cast<uint64_t>(bytes[3]) << 16 |
+           static_cast<uint64_t>(bytes[4]) << 8 | bytes[5];
+}
+
+inline uint32_t macOui(uint64_t mac)
+{
+    return static_cast<uint32_t>(mac >> 24) & 0xFFFFFF;
+}
+
+// Locally administered addresses (including randomized ones) carry no OUI
+inline bool isLocallyAdministered(uint64_t mac)
+{
+    return (mac >> 40 & 0x02) != 0;
+}
+
+class OuiTable
+{
+public:
+    static constexpr uint32_t kUnknown = 0xFFFFFFFF;
+
+    OuiTable() { build(); }
+
+    // IEEE registry in either published form: oui.txt ("00-50-56   (hex)
+    // VMware, Inc.") or oui.csv ("MA-L,005056,VMware, Inc.,address").
+    // Throws std::runtime_error if the file cannot be read or has no entries.
+    static OuiTable load(const std::string& path)
+    {
+        std::ifstream in(path);
+        if (!in)
+        {
+            throw std::runtime_error("Cannot open OUI registry " + path);
+        }
+        OuiTable table;
+        std::string line;
+        while (std::getline(in, line))
+        {
+            table.parseLine(line);
+        }
+        if (table.keys_.empty())
+        {
+            throw std::runtime_error("No OUI entries in " + path);
+        }
+        table.build();
+        return table;
+    }
+
+    // Add one prefix; call build() once all entries are in. A repeated
+    // prefix keeps its first vendor, as the registry lists each only once.
+    void add(uint32_t prefix, std::string_view vendor)
+    {
+        keys_.push_back(prefix & 0xFFFFFF);
+        vendorOffset_.push_back(static_cast<uint32_t>(names_.size()));
+        vendorLength_.push_back(static_cast<uint32_t>(vendor.size()));
+        names_.append(vendor.data(), vendor.size());
+    }
+
+    // Lay out the perfect hash: buckets of about four keys each, largest
+    // first, each given the first displacement that puts all its keys into
+    // free slots. The slot array is the next power of two at or above
+    // n / 0.8, so the search stays short.
+    void build()
+    {
+        dedupe();
+        size_t n = keys_.size();
+        slotBits_ = 4;
+        while ((size_t(1) << slotBits_) * 4 < n * 5)
+        {
+            ++slotBits_;
+        }
+        bucketBits_ = 2;
+        while ((size_t(1) << bucketBits_) * 4 < n)
+        {
+            ++bucketBits_;
+        }
+        size_t slots = size_t(1) << slotBits_;
+        size_t buckets = size_t(1) << bucketBits_;
+
+        std::vector<std::vector<uint32_t>> members(buckets);
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            members[oui_detail::bucketOf(keys_[i], bucketBits_)].push_back(i);
+        }
+        std::vector<uint32_t> order(buckets);
+        for (uint32_t b = 0; b < buckets; ++b)
+        {
+            order[b] = b;
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [&](uint32_t a, uint32_t b) { return members[a].size() > members[b].size(); });
+
+        displacement_.assign(buckets, 0);
+        slots_.assign(slots, Slot{kEmpty, kUnknown});
+        std::vector<uint32_t> placed;
+        for (uint32_t b : order)
+        {
+            if (members[b].empty())
+            {
+                break;
+            }
+            for (uint32_t d = 1;; ++d)
+            {
+                if (d > (1u << 24))
+                {
+                    throw std::runtime_error("OUI perfect hash did not converge");
+                }
+                placed.clear();
+                for (uint32_t i : members[b])
+                {
+                    uint32_t s = oui_detail::slotOf(keys_[i], d, slotBits_);
+                    if (slots_[s].key != kEmpty || std::find(placed.begin(), placed.end(), s) != placed.end())
+                    {
+                        break;
+                    }
+                    placed.push_back(s);
+                }
+                if (placed.size() == members[b].size())
+                {
+                    for (size_t k = 0; k < placed.size(); ++k)
+                    {
+                        slots_[placed[k]] = Slot{keys_[members[b][k]], members[b][k]};
+                    }
+                    displacement_[b] = d;
+                    break;
+                }
+            }
+        }
+    }
+
+    size_t size() const { return keys_.size(); }
+    size_t memoryBytes() const { return slots_.size() * sizeof(Slot) + displacement_.size() * sizeof(uint32_t); }
+
+    // Vendor index for a 24-bit prefix, or kUnknown
+    uint32_t find(uint32_t prefix) const
+    {
+        uint32_t d = displacement_[oui_detail::bucketOf(prefix, bucketBits_)];
+        const Slot& s = slots_[oui_detail::slotOf(prefix, d, slotBits_)];
+        return s.key == prefix ? s.vendor : kUnknown;
+    }
+
+    uint32_t classify(uint64_t mac) const
+    {
+        return isLocallyAdministered(mac) ? kUnknown : find(macOui(mac));
+    }
+
+    // Vendor index per MAC. Each group's displacement and slot reads are
+    // issued before any is used, so cache misses overlap instead of queueing.
+    void classify(const uint64_t* macs, size_t count, uint32_t* out) const
+    {
+        constexpr size_t kGroup = 16;
+        uint32_t keys[kGroup], buckets[kGroup], slots[kGroup];
+        for (size_t base = 0; base < count; base += kGroup)
+        {
+            size_t m = std::min(kGroup, count - base);
+            for (size_t i = 0; i < m; ++i)
+            {
+                keys[i] = macOui(macs[base + i]);
+                buckets[i] = oui_detail::bucketOf(keys[i], bucketBits_);
+                __builtin_prefetch(&displacement_[buckets[i]]);
+            }
+            for (size_t i = 0; i < m; ++i)
+            {
+                slots[i] = oui_detail::slotOf(keys[i], displacement_[buckets[i]], slotBits_);
+                __builtin_prefetch(&slots_[slots[i]]);
+            }
+            for (size_t i = 0; i < m; ++i)
+            {
+                const Slot& s = slots_[slots[i]];
+                bool hit = s.key == keys[i] && !isLocallyAdministered(macs[base + i]);
+                out[base + i] = hit ? s.vendor : kUnknown;
+            }
+        }
+    }
+
+    std::string_view vendor(uint32_t index) const
+    {
+        if (index >= vendorOffset_.size())
+        {
+            return std::string_view();
+        }
+        return std::string_view(names_.data() + vendorOffset_[index], vendorLength_[index]);
+    }
+
+    uint32_t prefix(uint32_t index) const { return keys_[index]; }
+
+private:
+    static constexpr uint32_t kEmpty = 0xFFFFFFFF; ///< Not a valid 24-bit key
+
+    struct Slot
+    {
+        uint32_t key;
+        uint32_t vendor;
+    };
+
+    void parseLine(std::string_view line)
+    {
+        uint32_t prefix;
+        size_t used;
+        size_t hex = line.find("(hex)");
+        if (hex != std::string_view::npos)
+        {
+            if (oui_detail::parsePrefix(oui_detail::trim(line.substr(0, hex)), &prefix, &used))
+            {
+                add(prefix, oui_detail::trim(line.substr(hex + 5)));
+            }
+            return;
+        }
+        // CSV: registry, assignment, organization (possibly quoted), address
+        if (line.compare(0, 5, "MA-L,") != 0 || !oui_detail::parsePrefix(line.substr(5), &prefix, &used) ||
+            line.size() <= 5 + used || line[5 + used] != ',')
+        {
+            return;
+        }
+        std::string_view rest = line.substr(6 + used);
+        if (rest.empty() || rest[0] != '"')
+        {
+            add(prefix, oui_detail::trim(rest.substr(0, rest.find(','))));
+            return;
+        }
+        // Quoted: runs to the next lone quote, and "" inside stands for "
+        unquoted_.clear();
+        for (size_t i = 1; i < rest.size(); ++i)
+        {
+            if (rest[i] == '"')
+            {
+                if (i + 1 == rest.size() || rest[i + 1] != '"')
+                {
+                    break;
+                }
+                ++i;
+            }
+            unquoted_ += rest[i];
+        }
+        add(prefix, oui_detail::trim(unquoted_));
+    }
+
+    void dedupe()
+    {
+        std::vector<uint32_t> order(keys_.size());
+        for (uint32_t i = 0; i < order.size(); ++i)
+        {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys_[a] < keys_[b]; });
+        std::vector<uint32_t> keys, offsets, lengths;
+        for (size_t k = 0; k < order.size(); ++k)
+        {
+            uint32_t i = order[k];
+            if (k > 0 && keys_[i] == keys.back())
+            {
+                continue;
+            }
+            keys.push_back(keys_[i]);
+            offsets.push_back(vendorOffset_[i]);
+            lengths.push_back(vendorLength_[i]);
+        }
+        keys_.swap(keys);
+        vendorOffset_.swap(offsets);
+        vendorLength_.swap(lengths);
+    }
+
+    std::vector<uint32_t> keys_;          ///< Sorted prefixes; vendor index is the position
+    std::vector<uint32_t> vendorOffset_;
+    std::vector<uint32_t> vendorLength_;
+    std::string names_;
+    std::vector<uint32_t> displacement_;  ///< Per bucket
+    std::vector<Slot> slots_;
+    unsigned bucketBits_ = 2;
+    unsigned slotBits_ = 4;
+    std::string unquoted_;                ///< Scratch for one quoted CSV field
+};
@@ -0,0 +1,234 @@
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdio>
+#include <array>
+#include "OuiTable.hpp"
+#include "AddressValidators.hpp"
+
+static const char* kSyntheticPath = "/tmp/oui_table_demo.txt";
+static const char* kCsvPath = "/tmp/oui_table_demo.csv";
+
+// A registry the size of the IEEE MA-L list, in its oui.txt layout
+static std::vector<uint32_t> writeSyntheticRegistry(const std::string& path, size_t entries)
+{
+    std::mt19937 rng(11);
+    std::unordered_map<uint32_t, bool> seen;
+    std::vector<uint32_t> prefixes;
+    std::ofstream out(path);
+    out << "OUI/MA-L                                                    Organization\n"
+           "company_id                                                  Organization\n"
+           "                                                            Address\n\n";
+    while (prefixes.size() < entries)
+    {
+        uint32_t p = rng() & 0xFCFFFF; // universally administered, unicast
+        if (!seen.emplace(p, true).second)
+        {
+            continue;
+        }
+        prefixes.push_back(p);
+        char line[128];
+        snprintf(line, sizeof(line), "%02X-%02X-%02X   (hex)\t\tVendor %u, Inc.\r\n", p >> 16, p >> 8 & 0xFF, p & 0xFF,
+                 static_cast<unsigned>(prefixes.size()));
+        out << line;
+        snprintf(line, sizeof(line), "%06X     (base 16)\t\tVendor %u, Inc.\r\n", p, static_cast<unsigned>(prefixes.size()));
+        out << line << "\t\t\t\t1 Example Road\r\n\t\t\t\tSomewhere  00000\r\n\t\t\t\tUS\r\n\r\n";
+    }
+    return prefixes;
+}
+
+static bool check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        std::cerr << "Self-test failed: " << what << std::endl;
+    }
+    return ok;
+}
+
+#define SELF_CHECK(cond) ok &= check((cond), #cond)
+
+static bool selfTest(const OuiTable& table, const std::vector<uint32_t>& prefixes)
+{
+    bool ok = true;
+    size_t wrong = 0;
+    for (size_t i = 0; i < prefixes.size(); ++i)
+    {
+        uint32_t v = table.find(prefixes[i]);
+        wrong += v == OuiTable::kUnknown || table.vendor(v) != "Vendor " + std::to_string(i + 1) + ", Inc.";
+    }
+    SELF_CHECK(wrong == 0);
+    SELF_CHECK(table.size() == prefixes.size());
+
+    // Every other 24-bit value must miss, checked against a hash map
+    std::unordered_map<uint32_t, bool> known;
+    for (uint32_t p : prefixes)
+    {
+        known[p] = true;
+    }
+    size_t disagree = 0;
+    for (uint32_t p = 0; p < (1u << 24); p += 7)
+    {
+        disagree += (table.find(p) != OuiTable::kUnknown) != (known.count(p) != 0);
+    }
+    SELF_CHECK(disagree == 0);
+
+    // Batch and single lookups agree, and locally administered MACs never match
+    std::mt19937_64 rng(3);
+    std::vector<uint64_t> macs(10000);
+    for (auto& m : macs)
+    {
+        m = rng() % 2 ? static_cast<uint64_t>(prefixes[rng() % prefixes.size()]) << 24 | (rng() & 0xFFFFFF)
+                      : rng() & 0xFFFFFFFFFFFFull;
+    }
+    macs[0] = static_cast<uint64_t>(prefixes[0] | 0x020000) << 24;
+    std::vector<uint32_t> batch(macs.size());
+    table.classify(macs.data(), macs.size(), batch.data());
+    size_t differ = 0;
+    for (size_t i = 0; i < macs.size(); ++i)
+    {
+        differ += batch[i] != table.classify(macs[i]);
+    }
+    SELF_CHECK(differ == 0);
+    SELF_CHECK(batch[0] == OuiTable::kUnknown);
+
+    // The CSV form, including a quoted organization name
+    {
+        std::ofstream csv(kCsvPath);
+        csv << "Registry,Assignment,Organization Name,Organization Address\n"
+               "MA-L,005056,\"VMware, Inc.\",3401 Hillview Avenue PALO ALTO CA US 94304\n"
+               "MA-L,080027,PCS Systemtechnik GmbH,Frankfurter Ring 193a Muenchen DE 80807\n"
+               "MA-L,FCFBFB,\"Cisco \"\"Meraki\"\", Inc.\",500 Terry A Francois Blvd San Francisco CA US 94158\n";
+    }
+    OuiTable csvTable = OuiTable::load(kCsvPath);
+    const uint8_t vmware[6] = {0x00, 0x50, 0x56, 0xAB, 0xCD, 0xEF};
+    SELF_CHECK(csvTable.size() == 3);
+    SELF_CHECK(csvTable.vendor(csvTable.classify(macToInt(vmware))) == "VMware, Inc.");
+    SELF_CHECK(csvTable.vendor(csvTable.find(0x080027)) == "PCS Systemtechnik GmbH");
+    SELF_CHECK(csvTable.vendor(csvTable.find(0xFCFBFB)) == "Cisco \"Meraki\", Inc.");
+    std::remove(kCsvPath);
+
+    if (ok)
+    {
+        std::cout << "Self-test passed (" << prefixes.size() << " entries, every 7th of 2^24 prefixes checked)" << std::endl;
+    }
+    return ok;
+}
+
+template <typename Fn>
+static double millionsPerSecond(size_t count, Fn fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return count / seconds / 1e6;
+}
+
+// The way isMacAddressTampered() matched before: format, then compare substrings
+static bool legacyMatch(const std::string& mac, const std::array<std::string, 8>& prefixes)
+{
+    for (const auto& prefix : prefixes)
+    {
+        if (mac.substr(0, 8) == prefix)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<uint32_t> prefixes = writeSyntheticRegistry(kSyntheticPath, 40000);
+    auto loadStart = std::chrono::steady_clock::now();
+    OuiTable table = OuiTable::load(kSyntheticPath);
+    double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+    std::remove(kSyntheticPath);
+    std::cout << "Loaded " << table.size() << " OUIs in " << loadMs << " ms; perfect hash uses " << table.memoryBytes() / 1024
+              << " KiB" << std::endl;
+    if (!selfTest(table, prefixes))
+    {
+        return 1;
+    }
+
+    // A flow log's worth of source MACs: most from registered vendors
+    const size_t count = 16 << 20;
+    std::mt19937_64 rng(5);
+    std::vector<uint64_t> macs(count);
+    for (auto& m : macs)
+    {
+        m = rng() % 10 < 8 ? static_cast<uint64_t>(prefixes[rng() % prefixes.size()]) << 24 | (rng() & 0xFFFFFF)
+                           : rng() & 0xFFFFFFFFFFFFull;
+    }
+    std::vector<uint32_t> vendors(count);
+    std::unordered_map<uint32_t, uint32_t> map;
+    for (uint32_t i = 0; i < prefixes.size(); ++i)
+    {
+        map[prefixes[i]] = table.find(prefixes[i]);
+    }
+
+    size_t found = 0;
+    double batch = millionsPerSecond(count, [&]() { table.classify(macs.data(), count, vendors.data()); });
+    double single = millionsPerSecond(count, [&]()
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            vendors[i] = table.classify(macs[i]);
+        }
+    });
+    double hashMap = millionsPerSecond(count, [&]()
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto it = map.find(macOui(macs[i]));
+            vendors[i] = it == map.end() ? OuiTable::kUnknown : it->second;
+        }
+    });
+    for (uint32_t v : vendors)
+    {
+        found += v != OuiTable::kUnknown;
+    }
+
+    std::array<std::string, 8> legacyPrefixes = {"00:50:56", "00:0C:29", "00:05:69", "00:1C:14",
+                                                 "00:15:5D", "00:03:FF", "00:1C:42", "00:0F:4B"};
+    const size_t legacyCount = 1 << 20;
+    size_t legacyHits = 0;
+    double legacy = millionsPerSecond(legacyCount, [&]()
+    {
+        char text[18];
+        for (size_t i = 0; i < legacyCount; ++i)
+        {
+            uint64_t m = macs[i];
+            snprintf(text, sizeof(text), "%02X:%02X:%02X:%02X:%02X:%02X", unsigned(m >> 40 & 0xFF), unsigned(m >> 32 & 0xFF),
+                     unsigned(m >> 24 & 0xFF), unsigned(m >> 16 & 0xFF), unsigned(m >> 8 & 0xFF), unsigned(m & 0xFF));
+            legacyHits += legacyMatch(text, legacyPrefixes);
+        }
+    });
+
+    std::cout << "Million lookups per second over " << count / (1 << 20) << "M MACs (" << found << " matched):" << std::endl;
+    std::cout << "  OuiTable::classify batch      " << batch << std::endl;
+    std::cout << "  OuiTable::classify one by one " << single << std::endl;
+    std::cout << "  std::unordered_map            " << hashMap << std::endl;
+    std::cout << "  format + 8 substr compares    " << legacy << " (8 prefixes only, " << legacyHits << " matched)" << std::endl;
+
+    if (argc > 1)
+    {
+        OuiTable registry = OuiTable::load(argv[1]);
+        for (int i = 2; i < argc; ++i)
+        {
+            MacAddressParts parts;
+            if (!parseMacAddress(argv[i], &parts))
+            {
+                std::cout << argv[i] << ": not a MAC address" << std::endl;
+                continue;
+            }
+            uint32_t v = registry.classify(macToInt(parts.bytes.data()));
+            std::cout << argv[i] << ": " << (v == OuiTable::kUnknown ? "unknown" : std::string(registry.vendor(v))) << std::endl;
+        }
+    }
+    return 0;
+}
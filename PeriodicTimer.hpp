@@ -0,0 +1,255 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <thread>
+#include <time.h>
+
+// Lock-free lateness histogram. Buckets are log-linear (16 sub-buckets per
+// power of two), so percentiles are accurate to ~6% over the whole nanosecond range.
+// record() is called by the timer thread; the queries can run on any thread.
+class JitterHistogram
+{
+public:
+    static const unsigned kSubBits = 4;
+    static const unsigned kBuckets = (64 - kSubBits + 1) << kSubBits;
+
+    JitterHistogram()
+    {
+        reset();
+    }
+
+    void record(int64_t latenessNs)
+    {
+        uint64_t v = latenessNs < 0 ? 0 : static_cast<uint64_t>(latenessNs);
+        counts_[bucketOf(v)].fetch_add(1, std::memory_order_relaxed);
+        total_.fetch_add(1, std::memory_order_relaxed);
+        uint64_t prev = max_.load(std::memory_order_relaxed);
+        while (v > prev && !max_.compare_exchange_weak(prev, v, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void reset()
+    {
+        for (auto& c : counts_)
+        {
+            c.store(0, std::memory_order_relaxed);
+        }
+        total_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const { return total_.load(std::memory_order_relaxed); }
+    uint64_t maxNs() const { return max_.load(std::memory_order_relaxed); }
+
+    // Upper bound of the bucket holding the p-th quantile (p in [0, 1])
+    uint64_t percentileNs(double p) const
+    {
+        uint64_t total = count();
+        if (total == 0)
+        {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(p * (total - 1)) + 1;
+        uint64_t seen = 0;
+        for (unsigned b = 0; b < kBuckets; ++b)
+        {
+            seen += counts_[b].load(std::memory_order_relaxed);
+            if (seen >= rank)
+            {
+                uint64_t upper = bucketUpper(b);
+                uint64_t m = maxNs();
+                return upper < m ? upper : m;
+            }
+        }
+        return maxNs();
+    }
+
+private:
+    static unsigned bucketOf(uint64_t v)
+    {
+        if (v < (1ULL << kSubBits))
+        {
+            return static_cast<unsigned>(v);
+        }
+        unsigned msb = 63 - __builtin_clzll(v);
+        unsigned shift = msb - kSubBits;
+        return ((shift + 1) << kSubBits) + static_cast<unsigned>((v >> shift) & ((1u << kSubBits) - 1));
+    }
+
+    static uint64_t bucketUpper(unsigned b)
+    {
+        if (b < (1u << kSubBits))
+        {
+            return b;
+        }
+        unsigned shift = (b >> kSubBits) - 1;
+        uint64_t sub = b & ((1u << kSubBits) - 1);
+        return (((1ULL << kSubBits) + sub + 1) << shift) - 1;
+    }
+
+    std::atomic<uint64_t> counts_[kBuckets];
+    std::atomic<uint64_t> total_;
+    std::atomic<uint64_t> max_;
+};
+
+// What to do when a callback overruns one or more periods
+enum class OverrunPolicy
+{
+    Skip,    // drop the missed ticks and realign to the next future deadline
+    CatchUp  // fire back-to-back until the schedule is caught up
+};
+
+// Periodic timer that sleeps to absolute CLOCK_MONOTONIC deadlines, so the
+// schedule never accumulates drift from callback time or wake-up latency.
+//
+// With a non-zero spin it sleeps to (deadline - window) and busy-waits the
+// rest. The window only helps if it covers the clock_nanosleep wake-up
+// latency, which is tens of us on bare metal and can exceed 100 us under a
+// hypervisor, so it is the larger of spin and the p99 of the observed
+// oversleep, re-derived every kAdaptEvery sleeps and capped at half the
+// period. Ticks are then only late when the thread is preempted while
+// spinning; the price is about window/period of a core.
+class PeriodicTimer
+{
+public:
+    template <typename Callback, typename Duration>
+    PeriodicTimer(Callback&& callback, Duration period, OverrunPolicy policy = OverrunPolicy::Skip,
+                  std::chrono::nanoseconds spin = std::chrono::nanoseconds::zero())
+        : callback_(std::forward<Callback>(callback)),
+          period_(std::chrono::duration_cast<std::chrono::nanoseconds>(period).count()),
+          spin_(spin.count()), window_(spin.count()), policy_(policy), running_(false), overruns_(0)
+    {
+    }
+
+    ~PeriodicTimer()
+    {
+        stop();
+    }
+
+    void start()
+    {
+        if (running_.exchange(true))
+        {
+            return;
+        }
+        worker_ = std::thread([this]() { run(); });
+    }
+
+    void stop()
+    {
+        running_ = false;
+        if (worker_.joinable())
+        {
+            worker_.join();
+        }
+    }
+
+    const JitterHistogram& jitter() const { return jitter_; }
+    JitterHistogram& jitter() { return jitter_; }
+
+    // How far past its target clock_nanosleep returned, for sleeps ahead of a spin
+    const JitterHistogram& oversleep() const { return oversleep_; }
+
+    // Current spin window; 0 when spinning is off
+    int64_t spinWindowNs() const { return window_.load(std::memory_order_relaxed); }
+
+    // Number of periods that were skipped or fired late back-to-back
+    uint64_t overruns() const { return overruns_.load(std::memory_order_relaxed); }
+
+private:
+    static int64_t nowNs()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+
+    static void sleepUntil(int64_t ns)
+    {
+        struct timespec ts;
+        ts.tv_sec = ns / 1000000000LL;
+        ts.tv_nsec = ns % 1000000000LL;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+        {
+        }
+    }
+
+    void waitFor(int64_t deadline)
+    {
+        if (spin_ > 0)
+        {
+            int64_t wake = deadline - window_.load(std::memory_order_relaxed);
+            if (wake > nowNs())
+            {
+                sleepUntil(wake);
+                oversleep_.record(nowNs() - wake);
+                if (oversleep_.count() % kAdaptEvery == 0)
+                {
+                    int64_t p99 = static_cast<int64_t>(oversleep_.percentileNs(0.99));
+                    window_.store(std::min(std::max(spin_, p99), period_ / 2), std::memory_order_relaxed);
+                }
+            }
+            while (nowNs() < deadline)
+            {
+#if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#endif
+            }
+        }
+        else
+        {
+            sleepUntil(deadline);
+        }
+    }
+
+    void run()
+    {
+        int64_t deadline = nowNs() + period_;
+        while (running_)
+        {
+            waitFor(deadline);
+            if (!running_)
+            {
+                break;
+            }
+            jitter_.record(nowNs() - deadline);
+            callback_();
+
+            deadline += period_;
+            int64_t now = nowNs();
+            if (deadline <= now)
+            {
+                if (policy_ == OverrunPolicy::Skip)
+                {
+                    int64_t missed = (now - deadline) / period_ + 1;
+                    overruns_.fetch_add(static_cast<uint64_t>(missed), std::memory_order_relaxed);
+                    deadline += missed * period_;
+                }
+                else
+                {
+                    overruns_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    static const uint64_t kAdaptEvery = 64;
+
+    std::function<void()> callback_;
+    const int64_t period_;
+    const int64_t spin_;
+    std::atomic<int64_t> window_;
+    const OverrunPolicy policy_;
+    std::atomic<bool> running_;
+    std::atomic<uint64_t> overruns_;
+    JitterHistogram jitter_;
+    JitterHistogram oversleep_;
+    std::thread worker_;
+};
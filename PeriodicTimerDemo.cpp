@@ -0,0 +1,72 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include "PeriodicTimer.hpp"
+
+// Compile: g++ -std=c++17 -O2 -pthread -o PeriodicTimerDemo PeriodicTimerDemo.cpp
+
+// The sleep+spin mode aims to fire within 10 us of each deadline
+static const uint64_t kTargetNs = 10000;
+
+static void printJitter(const char* name, const PeriodicTimer& timer)
+{
+    const JitterHistogram& h = timer.jitter();
+    std::cout << name << ": " << h.count() << " ticks, lateness p50 " << h.percentileNs(0.50) / 1000.0
+              << " us, p99 " << h.percentileNs(0.99) / 1000.0
+              << " us, max " << h.maxNs() / 1000.0
+              << " us, overruns " << timer.overruns() << std::endl;
+}
+
+static void printTarget(const PeriodicTimer& timer)
+{
+    const JitterHistogram& o = timer.oversleep();
+    uint64_t p50 = timer.jitter().percentileNs(0.50);
+    uint64_t p99 = timer.jitter().percentileNs(0.99);
+    std::cout << "  oversleep p50 " << o.percentileNs(0.50) / 1000.0 << " us, p99 " << o.percentileNs(0.99) / 1000.0
+              << " us; spin window " << timer.spinWindowNs() / 1000.0 << " us" << std::endl;
+    std::cout << "  10 us target: p50 " << (p50 <= kTargetNs ? "met" : "MISSED") << ", p99 "
+              << (p99 <= kTargetNs ? "met" : "MISSED") << std::endl;
+}
+
+int main()
+{
+    // 1 kHz control loop, sleeping to absolute deadlines
+    std::atomic<int> ticks(0);
+    PeriodicTimer sleeper([&ticks]() { ticks++; }, std::chrono::milliseconds(1));
+    sleeper.start();
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    sleeper.stop();
+    printJitter("clock_nanosleep", sleeper);
+
+    // Same loop spinning before each deadline; the window starts at 50 us and
+    // grows to cover the observed wake-up latency
+    PeriodicTimer spinner([&ticks]() { ticks++; }, std::chrono::milliseconds(1), OverrunPolicy::Skip, std::chrono::microseconds(50));
+    spinner.start();
+    // The histogram can be queried while the timer is running
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    printJitter("sleep+spin (running)", spinner);
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    spinner.stop();
+    printJitter("sleep+spin", spinner);
+    printTarget(spinner);
+
+    // A callback that overruns every other period under each policy
+    for (OverrunPolicy policy : {OverrunPolicy::Skip, OverrunPolicy::CatchUp})
+    {
+        int n = 0;
+        PeriodicTimer slow([&n]()
+        {
+            if (n++ % 2 == 0)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(2500));
+            }
+        }, std::chrono::milliseconds(1), policy);
+        slow.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        slow.stop();
+        printJitter(policy == OverrunPolicy::Skip ? "overrun/skip" : "overrun/catch-up", slow);
+    }
+
+    return 0;
+}
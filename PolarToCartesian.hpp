@@ -1,7 +1,9 @@
+#pragma once
+
 #include <cmath>
 
 // Function to convert polar coordinates to Cartesian coordinates
-void polarToCartesian(double radius, double angle, double& x, double& y) 
+inline void polarToCartesian(double radius, double angle, double& x, double& y) 
 {
     x = radius * cos(angle);
     y = radius * sin(angle);
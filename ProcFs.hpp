@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <vector>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+// Allocation-free scanners for procfs text
+namespace procfs
+{
+
+inline const char* skipSpaces(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t'))
+    {
+        ++p;
+    }
+    return p;
+}
+
+// Parse an unsigned decimal; returns the position after it (== p if none)
+inline const char* parseU64(const char* p, const char* end, uint64_t& value)
+{
+    uint64_t v = 0;
+    const char* start = p;
+    while (p < end && static_cast<unsigned>(*p - '0') < 10)
+    {
+        v = v * 10 + static_cast<unsigned>(*p - '0');
+        ++p;
+    }
+    value = p == start ? 0 : v;
+    return p;
+}
+
+inline const char* nextLine(const char* p, const char* end)
+{
+    const void* nl = memchr(p, '\n', end - p);
+    return nl ? static_cast<const char*>(nl) + 1 : end;
+}
+
+// pread a whole procfs file into buf, growing it once if it was too small
+inline ssize_t readWhole(int fd, std::vector<char>& buf)
+{
+    for (;;)
+    {
+        ssize_t n = pread(fd, buf.data(), buf.size(), 0);
+        if (n < 0 || static_cast<size_t>(n) < buf.size())
+        {
+            return n;
+        }
+        buf.resize(buf.size() * 2);
+    }
+}
+
+inline int64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// PID named by a /proc directory entry, or 0 for non-process entries
+inline pid_t parsePid(const char* name)
+{
+    uint64_t pid;
+    const char* end = name + strlen(name);
+    return end != name && parseU64(name, end, pid) == end ? static_cast<pid_t>(pid) : 0;
+}
+
+// One-shot openat()+read() of a small procfs file into a caller buffer
+inline ssize_t readAt(int dirFd, const char* path, char* buf, size_t size)
+{
+    int fd = openat(dirFd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    ssize_t n = read(fd, buf, size);
+    close(fd);
+    return n;
+}
+
+} // namespace procfs
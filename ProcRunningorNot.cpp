@@ -4,51 +4,170 @@
 #include <signal.h>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <sys/resource.h>
+#include "ProcessTable.hpp"
+#include "Supervisor.hpp"
 
 std::string processName = "your_process_name"; // Replace with the actual process name
 
+// True if any process has the given command name. Uses the proc-connector
+// table instead of spawning pgrep for every check.
 bool isProcessRunning(const std::string& name) 
 {
-    std::string command = "pgrep -x " + name;
-    FILE* pipe = popen(command.c_str(), "r");
-    if (!pipe) 
+    static ProcessTable table;
+    table.update();
+    for (pid_t pid : table.pids())
     {
-        return false;
-    }
-
-    char buffer[128];
-    std::string result;
-    while (fgets(buffer, sizeof(buffer), pipe) != nullptr) 
-    {
-        result += buffer;
+        if (name == table.name(pid))
+        {
+            return true;
+        }
     }
-
-    pclose(pipe);
-    return !result.empty();
+    return false;
 }
 
-void restartProcess() 
+static double cpuMs()
 {
-    std::string command = "./" + processName; // Assuming the process is in the current directory
-    system(command.c_str());
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1e3 + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e3;
 }
 
-int main() 
+// Supervise three sample services for a few seconds and report restart latency
+static int runDemo()
 {
-    while (true) 
+    EventLoop loop;
+    Supervisor supervisor(loop);
+
+    ServiceSpec bounce;
+    bounce.name = "bounce";               // exits at once, restarted immediately every time
+    bounce.argv = {"true"};
+    bounce.stableAfter = std::chrono::milliseconds(0);
+    supervisor.add(bounce);
+
+    ServiceSpec flaky;
+    flaky.name = "flaky";                 // fails quickly, so restarts back off
+    flaky.argv = {"sh", "-c", "exit 3"};
+    flaky.minBackoff = std::chrono::milliseconds(50);
+    flaky.maxBackoff = std::chrono::milliseconds(800);
+    supervisor.add(flaky);
+
+    ServiceSpec steady;
+    steady.name = "steady";
+    steady.argv = {"sleep", "1000"};
+    supervisor.add(steady);
+
+    ServiceSpec stolen;
+    stolen.name = "stolen";               // reaped behind the supervisor's back below
+    stolen.argv = {"sleep", "1000"};
+    supervisor.add(stolen);
+
+    std::vector<double> latencyUs;
+    Supervisor::Clock::time_point bounceExit;
+    pid_t stolenPid = -1;
+    bool stolenUnknown = false;
+    supervisor.setListener([&](const ServiceSpec& spec, Supervisor::Event event, pid_t pid, int status)
     {
-        if (!isProcessRunning(processName)) 
+        auto now = Supervisor::Clock::now();
+        if (spec.name == "bounce")
         {
-            std::cout << "Process " << processName << " is not running. Restarting..." << std::endl;
-            restartProcess();
-        } 
-        else 
+            if (event == Supervisor::Event::Exited)
+            {
+                bounceExit = now;
+            }
+            else if (event == Supervisor::Event::Started && bounceExit.time_since_epoch().count() != 0)
+            {
+                latencyUs.push_back(std::chrono::duration<double, std::micro>(now - bounceExit).count());
+            }
+        }
+        else if (spec.name == "stolen" && event == Supervisor::Event::Started)
+        {
+            stolenPid = pid;
+        }
+        else if (event == Supervisor::Event::Exited && status == -1)
         {
-            std::cout << "Process " << processName << " is running." << std::endl;
+            std::cout << spec.name << " (pid " << pid << ") exited, status unknown (reaped elsewhere)" << std::endl;
+            stolenUnknown = stolenUnknown || spec.name == "stolen";
         }
+        else if (event == Supervisor::Event::Exited)
+        {
+            std::cout << spec.name << " (pid " << pid << ") "
+                      << (WIFSIGNALED(status) ? "killed by signal " : "exited with status ")
+                      << (WIFSIGNALED(status) ? WTERMSIG(status) : WEXITSTATUS(status)) << std::endl;
+        }
+    });
+
+    // Another part of the program runs waitpid() on the child first, as a
+    // stray waitpid(-1) would; the supervisor's then fails with ECHILD
+    loop.addTimer(std::chrono::milliseconds(500), std::chrono::nanoseconds(0), [&]()
+    {
+        kill(stolenPid, SIGKILL);
+        waitpid(stolenPid, nullptr, 0);
+    });
 
-        sleep(5); // Check every 5 seconds
+    supervisor.start();
+    loop.addTimer(std::chrono::seconds(2), std::chrono::nanoseconds(0), [&]() { supervisor.shutdown(); });
+    loop.run();
+
+    std::sort(latencyUs.begin(), latencyUs.end());
+    std::cout << "bounce restarts: " << supervisor.restarts("bounce") << ", exit-to-respawn median "
+              << (latencyUs.empty() ? 0.0 : latencyUs[latencyUs.size() / 2]) << " us" << std::endl;
+    std::cout << "flaky restarts with backoff: " << supervisor.restarts("flaky") << std::endl;
+    std::cout << "stolen restarts after ECHILD: " << supervisor.restarts("stolen") << std::endl;
+    if (!stolenUnknown || supervisor.restarts("stolen") != 1)
+    {
+        std::cerr << "Self-test failed: a child reaped elsewhere was not restarted" << std::endl;
+        return 1;
+    }
+
+    // Idle cost: a healthy service only costs an fd in epoll
+    EventLoop idleLoop;
+    Supervisor idle(idleLoop);
+    idle.add(steady);
+    idle.start();
+    double before = cpuMs();
+    idleLoop.addTimer(std::chrono::seconds(1), std::chrono::nanoseconds(0), [&]() { idle.shutdown(); });
+    idleLoop.run();
+    std::cout << "Supervisor CPU while idle for 1 s: " << cpuMs() - before << " ms" << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv) 
+{
+    if (argc < 2)
+    {
+        std::cout << "Process " << processName << (isProcessRunning(processName) ? " is running." : " is not running.")
+                  << std::endl;
+        return runDemo();
     }
 
+    // ProcRunningorNot services.conf: supervise every "name: command args" line
+    EventLoop loop;
+    Supervisor supervisor(loop);
+    if (!supervisor.loadConfig(argv[1]))
+    {
+        return 1;
+    }
+    supervisor.setListener([](const ServiceSpec& spec, Supervisor::Event event, pid_t pid, int status)
+    {
+        if (event == Supervisor::Event::Started)
+        {
+            std::cout << "Started " << spec.name << " (pid " << pid << ")" << std::endl;
+        }
+        else if (event == Supervisor::Event::Exited)
+        {
+            std::cout << "Process " << spec.name << " exited (status " << status << "). Restarting..." << std::endl;
+        }
+        else
+        {
+            std::cout << "Failed to start " << spec.name << ": " << strerror(status) << std::endl;
+        }
+    });
+    auto onSignal = [&](const struct signalfd_siginfo&) { supervisor.shutdown(); };
+    loop.addSignal(SIGINT, onSignal);
+    loop.addSignal(SIGTERM, onSignal);
+    supervisor.start();
+    loop.run();
     return 0;
 }
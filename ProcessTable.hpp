@@ -0,0 +1,443 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include "ProcFs.hpp"
+
+// In-process table of live processes kept current by the kernel proc
+// connector: fork/exec/exit/comm events arrive over netlink and are applied
+// incrementally, so /proc is only walked on startup and after the socket
+// overruns (ENOBUFS). Lookups are O(1) and pids() returns the same vector
+// until something changes; compare version() to detect changes cheaply.
+//
+// The connector needs root in the initial PID namespace. When it cannot be
+// subscribed, live() is false and update() falls back to a /proc walk.
+class ProcessTable
+{
+public:
+    ProcessTable()
+    {
+        procFd_ = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (procFd_ < 0)
+        {
+            throw std::runtime_error(std::string("ProcessTable: cannot open /proc: ") + strerror(errno));
+        }
+        // Subscribe before walking so nothing that happens during the walk is missed
+        subscribe();
+        rescan();
+        update();
+    }
+
+    ~ProcessTable()
+    {
+        if (sock_ >= 0)
+        {
+            close(sock_);
+        }
+        close(procFd_);
+    }
+
+    ProcessTable(const ProcessTable&) = delete;
+    ProcessTable& operator=(const ProcessTable&) = delete;
+
+    // True when updates come from the proc connector rather than polling
+    bool live() const { return sock_ >= 0; }
+
+    // Netlink socket to watch for EPOLLIN (e.g. with EventLoop), -1 if not live
+    int fd() const { return sock_; }
+
+    // Apply pending events without blocking; returns true if the table changed
+    bool update()
+    {
+        uint64_t before = version_;
+        changed_.clear();
+        if (sock_ < 0)
+        {
+            rescan();
+            return version_ != before;
+        }
+
+        alignas(struct nlmsghdr) char buf[16384];
+        for (;;)
+        {
+            ssize_t n = recv(sock_, buf, sizeof(buf), 0);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                if (errno == ENOBUFS)
+                {
+                    rescan(); // kernel dropped events, resynchronize
+                    continue;
+                }
+                break; // EAGAIN: drained
+            }
+            int len = static_cast<int>(n);
+            for (struct nlmsghdr* nh = reinterpret_cast<struct nlmsghdr*>(buf); NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len))
+            {
+                if (nh->nlmsg_type == NLMSG_ERROR || nh->nlmsg_type == NLMSG_OVERRUN)
+                {
+                    rescan();
+                    continue;
+                }
+                const struct cn_msg* cn = static_cast<const struct cn_msg*>(NLMSG_DATA(nh));
+                if (cn->id.idx == CN_IDX_PROC && cn->id.val == CN_VAL_PROC)
+                {
+                    apply(*reinterpret_cast<const struct proc_event*>(cn->data));
+                }
+            }
+        }
+        recheckExits();
+        return version_ != before;
+    }
+
+    // Every known process; the reference stays valid until the next update()
+    const std::vector<pid_t>& pids() const { return pids_; }
+
+    size_t size() const { return pids_.size(); }
+    bool contains(pid_t pid) const { return index_.count(pid) != 0; }
+
+    // Incremented on every add, remove or rename
+    uint64_t version() const { return version_; }
+
+    // Processes added, removed, renamed or exec'd by the last update(), in
+    // event order and possibly repeated; a rescan contributes what it found
+    const std::vector<pid_t>& changed() const { return changed_; }
+
+    // Number of full /proc walks so far (startup, overruns, or polling)
+    uint64_t rescans() const { return rescans_; }
+
+    // Parent PID, read from /proc on first use; -1 if unknown
+    pid_t parent(pid_t pid)
+    {
+        Entry* e = find(pid);
+        if (e == nullptr)
+        {
+            return -1;
+        }
+        if (e->ppid < 0)
+        {
+            loadStat(*e);
+        }
+        return e->ppid;
+    }
+
+    // Command name (comm), read from /proc on first use after exec; "" if unknown
+    const char* name(pid_t pid)
+    {
+        Entry* e = find(pid);
+        if (e == nullptr)
+        {
+            return "";
+        }
+        if (!e->commKnown)
+        {
+            loadComm(*e);
+        }
+        return e->comm;
+    }
+
+private:
+    struct Entry
+    {
+        pid_t ppid = -1;
+        bool commKnown = false;
+        bool leaderExited = false;   ///< Main thread gone, other threads still running
+        char comm[16] = {};
+    };
+
+    void subscribe()
+    {
+        sock_ = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+        if (sock_ < 0)
+        {
+            return;
+        }
+        int rcvbuf = 4 << 20;
+        setsockopt(sock_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+        struct sockaddr_nl sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.nl_family = AF_NETLINK;
+        sa.nl_groups = CN_IDX_PROC;
+        sa.nl_pid = 0; // let the kernel pick a unique port id
+
+        alignas(struct nlmsghdr) char msg[NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op))];
+        memset(msg, 0, sizeof(msg));
+        struct nlmsghdr* nh = reinterpret_cast<struct nlmsghdr*>(msg);
+        nh->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op));
+        nh->nlmsg_type = NLMSG_DONE;
+        struct cn_msg* cn = static_cast<struct cn_msg*>(NLMSG_DATA(nh));
+        cn->id.idx = CN_IDX_PROC;
+        cn->id.val = CN_VAL_PROC;
+        cn->len = sizeof(enum proc_cn_mcast_op);
+        enum proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+        memcpy(cn->data, &op, sizeof(op));
+
+        if (bind(sock_, reinterpret_cast<struct sockaddr*>(&sa), sizeof(sa)) < 0 ||
+            send(sock_, msg, nh->nlmsg_len, 0) < 0)
+        {
+            close(sock_);
+            sock_ = -1;
+        }
+    }
+
+    void apply(const struct proc_event& ev)
+    {
+        switch (ev.what)
+        {
+        case proc_event::PROC_EVENT_FORK:
+            // Thread creation also reports as fork; only new thread groups are processes
+            if (ev.event_data.fork.child_pid == ev.event_data.fork.child_tgid)
+            {
+                Entry& e = add(ev.event_data.fork.child_tgid);
+                e.ppid = ev.event_data.fork.parent_tgid;
+            }
+            break;
+        case proc_event::PROC_EVENT_EXEC:
+            if (Entry* e = find(ev.event_data.exec.process_tgid))
+            {
+                e->commKnown = false;
+                changed_.push_back(ev.event_data.exec.process_tgid);
+                version_++;
+            }
+            else
+            {
+                add(ev.event_data.exec.process_tgid);
+            }
+            break;
+        case proc_event::PROC_EVENT_COMM:
+            if (ev.event_data.comm.process_pid == ev.event_data.comm.process_tgid)
+            {
+                Entry& e = add(ev.event_data.comm.process_tgid);
+                memcpy(e.comm, ev.event_data.comm.comm, sizeof(e.comm));
+                e.comm[sizeof(e.comm) - 1] = '\0';
+                e.commKnown = true;
+                changed_.push_back(ev.event_data.comm.process_tgid);
+                version_++;
+            }
+            break;
+        case proc_event::PROC_EVENT_EXIT:
+        {
+            // The main thread exiting ends the process only if it was the
+            // last thread (pthread_exit() in main leaves the rest running);
+            // after that, each thread exit checks whether it was the last
+            pid_t tgid = ev.event_data.exit.process_tgid;
+            pid_t pid = ev.event_data.exit.process_pid;
+            Entry* e = find(tgid);
+            if (e == nullptr || (pid != tgid && !e->leaderExited))
+            {
+                break;
+            }
+            if (!otherThreads(tgid, &pid, 1))
+            {
+                remove(tgid);
+            }
+            else
+            {
+                e->leaderExited = true;
+                exits_.push_back(std::make_pair(tgid, pid));
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    Entry* find(pid_t pid)
+    {
+        auto it = index_.find(pid);
+        return it == index_.end() ? nullptr : &entries_[it->second];
+    }
+
+    Entry& add(pid_t pid)
+    {
+        auto ins = index_.emplace(pid, static_cast<uint32_t>(pids_.size()));
+        if (ins.second)
+        {
+            pids_.push_back(pid);
+            entries_.emplace_back();
+            changed_.push_back(pid);
+            version_++;
+        }
+        return entries_[ins.first->second];
+    }
+
+    // Swap-remove so both vectors stay dense
+    void remove(pid_t pid)
+    {
+        auto it = index_.find(pid);
+        if (it == index_.end())
+        {
+            return;
+        }
+        uint32_t slot = it->second;
+        index_.erase(it);
+        if (slot + 1 != pids_.size())
+        {
+            pids_[slot] = pids_.back();
+            entries_[slot] = entries_.back();
+            index_[pids_[slot]] = slot;
+        }
+        pids_.pop_back();
+        entries_.pop_back();
+        changed_.push_back(pid);
+        version_++;
+    }
+
+    // True if /proc/<tgid>/task lists a thread other than the main one and
+    // the exiting ones. A thread reports its exit before it leaves that list.
+    bool otherThreads(pid_t tgid, const pid_t* exiting, size_t count)
+    {
+        char path[32];
+        snprintf(path, sizeof(path), "%d/task", static_cast<int>(tgid));
+        int fd = openat(procFd_, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        DIR* dir = fd < 0 ? nullptr : fdopendir(fd);
+        if (dir == nullptr)
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            return false;
+        }
+        bool others = false;
+        struct dirent* entry;
+        while (!others && (entry = readdir(dir)) != nullptr)
+        {
+            pid_t tid = procfs::parsePid(entry->d_name);
+            others = tid > 0 && tid != tgid && std::find(exiting, exiting + count, tid) == exiting + count;
+        }
+        closedir(dir);
+        return others;
+    }
+
+    // Two threads exiting together can each still see the other listed, so
+    // a process whose threads exited in this batch is probed again with all
+    // of them excluded. Processes with no exits in the batch are not probed.
+    void recheckExits()
+    {
+        std::sort(exits_.begin(), exits_.end());
+        for (size_t i = 0; i < exits_.size();)
+        {
+            pid_t tgid = exits_[i].first;
+            exitingTids_.clear();
+            for (; i < exits_.size() && exits_[i].first == tgid; ++i)
+            {
+                exitingTids_.push_back(exits_[i].second);
+            }
+            Entry* e = find(tgid);
+            if (e != nullptr && e->leaderExited && !otherThreads(tgid, exitingTids_.data(), exitingTids_.size()))
+            {
+                remove(tgid);
+            }
+        }
+        exits_.clear();
+    }
+
+    // Reconcile the table with a full /proc listing
+    void rescan()
+    {
+        rescans_++;
+        DIR* dir = fdopendir(dup(procFd_));
+        if (dir == nullptr)
+        {
+            return;
+        }
+        seen_.clear();
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr)
+        {
+            pid_t pid = procfs::parsePid(entry->d_name);
+            if (pid > 0)
+            {
+                seen_.push_back(pid);
+                add(pid);
+            }
+        }
+        closedir(dir);
+
+        if (seen_.size() != pids_.size())
+        {
+            std::unordered_map<pid_t, bool> present;
+            for (pid_t pid : seen_)
+            {
+                present[pid] = true;
+            }
+            for (size_t i = pids_.size(); i-- > 0;)
+            {
+                if (!present.count(pids_[i]))
+                {
+                    remove(pids_[i]);
+                }
+            }
+        }
+    }
+
+    void loadComm(Entry& e)
+    {
+        pid_t pid = pids_[&e - entries_.data()];
+        char path[32];
+        snprintf(path, sizeof(path), "%d/comm", static_cast<int>(pid));
+        ssize_t n = procfs::readAt(procFd_, path, e.comm, sizeof(e.comm) - 1);
+        n = n > 0 && e.comm[n - 1] == '\n' ? n - 1 : (n < 0 ? 0 : n);
+        e.comm[n] = '\0';
+        e.commKnown = true;
+    }
+
+    void loadStat(Entry& e)
+    {
+        pid_t pid = pids_[&e - entries_.data()];
+        char path[32];
+        char buf[512];
+        snprintf(path, sizeof(path), "%d/stat", static_cast<int>(pid));
+        ssize_t n = procfs::readAt(procFd_, path, buf, sizeof(buf));
+        if (n <= 0)
+        {
+            return;
+        }
+        // "pid (comm) state ppid ..." where comm may contain ')'
+        const char* end = buf + n;
+        const char* p = end;
+        while (p > buf && *(p - 1) != ')')
+        {
+            --p;
+        }
+        p = procfs::skipSpaces(p, end);
+        p = procfs::skipSpaces(p + 1, end);
+        uint64_t ppid;
+        if (procfs::parseU64(p, end, ppid) != p)
+        {
+            e.ppid = static_cast<pid_t>(ppid);
+        }
+    }
+
+    int procFd_ = -1;
+    int sock_ = -1;
+    std::vector<pid_t> pids_;
+    std::vector<Entry> entries_;
+    std::unordered_map<pid_t, uint32_t> index_;
+    std::vector<pid_t> seen_;
+    std::vector<std::pair<pid_t, pid_t>> exits_;   ///< (tgid, tid) exits of this batch in leaderless processes
+    std::vector<pid_t> exitingTids_;
+    std::vector<pid_t> changed_;
+    uint64_t version_ = 0;
+    uint64_t rescans_ = 0;
+};
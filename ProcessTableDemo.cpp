@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include "ProcessTable.hpp"
+
+static double nsPerCall(std::chrono::steady_clock::time_point start, int calls)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+}
+
+int main()
+{
+    ProcessTable table;
+    std::cout << "Proc connector: " << (table.live() ? "subscribed" : "unavailable, polling /proc") << std::endl;
+    std::cout << "Processes at startup: " << table.size() << " (" << table.rescans() << " /proc walk)" << std::endl;
+
+    // Fork children that block until killed and check the table follows them
+    std::vector<pid_t> children;
+    for (int i = 0; i < 50; ++i)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            pause();
+            _exit(0);
+        }
+        children.push_back(pid);
+    }
+    table.update();
+    size_t found = 0;
+    for (pid_t pid : children)
+    {
+        found += table.contains(pid) && table.parent(pid) == getpid();
+    }
+    std::cout << "After fork: " << found << "/" << children.size() << " children tracked with correct parent" << std::endl;
+
+    for (pid_t pid : children)
+    {
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+    }
+    table.update();
+    size_t left = 0, reported = 0;
+    for (pid_t pid : children)
+    {
+        left += table.contains(pid);
+        reported += std::count(table.changed().begin(), table.changed().end(), pid) != 0;
+    }
+    std::cout << "After exit: " << left << " children still listed, " << reported << "/" << children.size()
+              << " reported as changed" << std::endl;
+    std::cout << "Own name: " << table.name(getpid()) << std::endl;
+
+    // A process whose main thread calls pthread_exit() lives on in its other
+    // threads; it must stay listed until the last of them exits
+    pid_t threaded = fork();
+    if (threaded == 0)
+    {
+        std::thread([]() { pause(); }).detach();
+        std::thread([]() { pause(); }).detach();
+        pthread_exit(nullptr);
+    }
+    char path[64], stat[256] = {};
+    snprintf(path, sizeof(path), "/proc/%d/stat", static_cast<int>(threaded));
+    for (int i = 0; i < 200 && !strstr(stat, ") Z "); ++i) // the main thread shows as a zombie
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        FILE* f = fopen(path, "r");
+        size_t n = f ? fread(stat, 1, sizeof(stat) - 1, f) : 0;
+        stat[n] = '\0';
+        if (f)
+        {
+            fclose(f);
+        }
+    }
+    table.update();
+    bool keptWhileThreaded = table.contains(threaded);
+
+    // Steady state: nothing changed, so update() and pids() should be nearly
+    // free, even with the leaderless process above still running
+    const int calls = 10000;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t version = table.version();
+    for (int i = 0; i < calls; ++i)
+    {
+        table.update();
+    }
+    double updateNs = nsPerCall(start, calls);
+
+    start = std::chrono::steady_clock::now();
+    size_t total = 0;
+    for (int i = 0; i < calls; ++i)
+    {
+        total += table.pids().size();
+    }
+    double listNs = nsPerCall(start, calls);
+
+    std::cout << "Idle update(): " << updateNs << " ns, pids() of " << total / calls << ": " << listNs
+              << " ns, version " << (table.version() == version ? "unchanged" : "changed") << ", "
+              << table.rescans() << " walks total" << std::endl;
+
+    // Both remaining threads exit at once, so each can still see the other
+    kill(threaded, SIGKILL);
+    waitpid(threaded, nullptr, 0);
+    table.update();
+    bool goneAfterLast = !table.contains(threaded);
+    std::cout << "Main thread exited, others still running: " << (keptWhileThreaded ? "listed" : "dropped")
+              << "; after the last thread: " << (goneAfterLast ? "removed" : "still listed") << std::endl;
+    return found == children.size() && left == 0 && reported == children.size() && keptWhileThreaded && goneAfterLast ? 0 : 1;
+}
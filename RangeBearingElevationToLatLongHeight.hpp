@@ -1,8 +1,9 @@
+#pragma once
 
 #include <cmath>
 
 // Function to convert range, bearing, and elevation to latitude, longitude, and height
-void RangeBearingElevationToLatLongHeight(double range, double bearing, double elevation,double refLat, double refLon, double refHeight,double& lat, double& lon, double& height) 
+inline void RangeBearingElevationToLatLongHeight(double range, double bearing, double elevation,double refLat, double refLon, double refHeight,double& lat, double& lon, double& height) 
 {
     const double earthRadius = 6378137.0; // Earth's radius in meters
 
@@ -1,26 +1,168 @@
-
+#include <algorithm>
 #include <iostream>
 #include <regex>
 #include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include "RegexRegistry.hpp"
 
-bool check_regex(const std::string& pattern) 
+bool check_regex(const std::string& pattern)
 {
-    try 
+    return RegexRegistry::validate(pattern);
+}
+
+// Synthetic syslog-style lines
+static std::string makeLog(size_t targetBytes)
+{
+    static const char* users[] = {"alice", "bob", "carol", "dave", "erin"};
+    static const char* actions[] = {"login", "logout", "read", "write", "delete"};
+    static const char* levels[] = {"INFO", "INFO", "INFO", "WARN", "ERROR"};
+    std::mt19937 rng(7);
+    std::string log;
+    while (log.size() < targetBytes)
     {
-        std::regex regex(pattern);
-        return true;
-    } 
-    catch (const std::regex_error& e) 
+        unsigned r = rng();
+        log += "2024-05-" + std::to_string(10 + r % 20) + "T12:00:" + std::to_string(10 + r % 50) + "Z host-" +
+               std::to_string(r % 100) + " svc-" + std::to_string(r % 40) + "[" + std::to_string(r % 30000) + "]: " +
+               levels[r % 5] + " user=" + users[(r >> 8) % 5] + " action=" + actions[(r >> 12) % 5] +
+               " code=E" + std::to_string((r >> 4) % 400) + " latency=" + std::to_string((r >> 16) % 3000) + "ms" +
+               ((r >> 20) % 50 == 0 ? " connection reset by peer" : "") + "\n";
+    }
+    return log;
+}
+
+// A filter set shaped like real ones: mostly literals, some regexes with a
+// literal anchor, a few case-insensitive, a few with no usable literal
+static std::vector<std::pair<std::string, bool>> makePatterns()
+{
+    std::vector<std::pair<std::string, bool>> patterns;
+    for (int i = 0; i < 150; ++i)
     {
-        return false;
+        patterns.push_back({"code=E" + std::to_string(i * 7 % 400) + " ", false});
     }
+    for (int i = 0; i < 30; ++i)
+    {
+        patterns.push_back({"svc-" + std::to_string(i) + "\\[\\d+\\]: (WARN|ERROR)", false});
+    }
+    patterns.push_back({"connection reset", false});
+    patterns.push_back({"latency=\\d{4,}ms", false});
+    patterns.push_back({"user=(alice|bob) action=delete", false});
+    patterns.push_back({"error user=", true});
+    patterns.push_back({"WARN USER=CAROL", true});
+    patterns.push_back({"^2024-05-1\\dT", false});
+    patterns.push_back({"host-(7|8)\\d ", false});
+    patterns.push_back({"[A-Z]{5} user=erin action=write", false});
+    patterns.push_back({"\\[\\d{5}\\]", false});
+    return patterns;
 }
 
-int main() 
+int main()
 {
     std::string regex_pattern = "^[a-zA-Z0-9_.+-]+@[a-zA-Z0-9-]+\\.[a-zA-Z0-9-.]+$";
     bool is_valid = check_regex(regex_pattern);
     std::cout << "The regex pattern '" << regex_pattern << "' is valid: " << std::boolalpha << is_valid << std::endl;
+    std::string error;
+    std::cout << "The regex pattern 'a(b' is valid: " << RegexRegistry::validate("a(b", &error) << " (" << error << ")" << std::endl;
+
+    RegexRegistry registry;
+    std::vector<int> ids;
+    auto compileStart = std::chrono::steady_clock::now();
+    for (const auto& p : makePatterns())
+    {
+        ids.push_back(registry.add(p.first, p.second));
+    }
+    double compileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - compileStart).count();
+    bool dedup = registry.add("connection reset") == ids[180] && registry.size() == ids.size();
+
+    std::vector<std::shared_ptr<const CompiledPattern>> compiled;
+    for (int id : ids)
+    {
+        compiled.push_back(registry.get(id));
+    }
+    PatternSet set(compiled);
+    std::cout << registry.size() << " patterns compiled in " << compileMs << " ms; automaton has " << set.states()
+              << " states, " << set.alwaysRun() << " patterns run on every line" << std::endl;
+
+    // The one-pass scan must report exactly what running every regex on every line reports
+    std::string sample = makeLog(256 << 10);
+    std::vector<std::vector<uint32_t>> expected;
+    auto naiveStart = std::chrono::steady_clock::now();
+    for (size_t pos = 0; pos < sample.size();)
+    {
+        size_t end = sample.find('\n', pos);
+        std::string_view line(sample.data() + pos, end - pos);
+        std::vector<uint32_t> m;
+        for (const auto& p : compiled)
+        {
+            if (p->matches(line))
+            {
+                m.push_back(p->id);
+            }
+        }
+        expected.push_back(m);
+        pos = end + 1;
+    }
+    double naiveSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - naiveStart).count();
+
+    size_t mismatches = 0, matchedLines = 0;
+    std::vector<size_t> perPattern(ids.size(), 0);
+    set.scan(sample, [&](size_t index, std::string_view, const std::vector<uint32_t>& m)
+    {
+        mismatches += m != expected[index];
+        expected[index].clear();
+        matchedLines++;
+    });
+    for (const auto& e : expected)
+    {
+        mismatches += !e.empty();
+    }
+    // The literal prefilter must agree with the regex on patterns where the
+    // literal is easy to get wrong: escapes with operands contribute the
+    // character they stand for (or nothing), stacked quantifiers are all
+    // consumed, and an empty line is still a line
+    RegexRegistry tricky;
+    std::vector<std::pair<std::string, std::string>> cases = {
+        {"\\x41BCD", "xABCD"}, {"\\u0041BC", "zABC"}, {"a\\cIb", "a\tb"},
+        {"(ab)\\1cd", "ababcd"}, {"b\\0c", std::string("ab\0c", 4)}, {"\\x7A9", "xz9"},
+        {"[ab]?{0,2}\\.?", "1"}, {"xyz?{0,2}", "xy"}, {".*{1}abc", "abc"}, {"x+{1,}?yz", "xxyz"},
+        {"^$", ""}, {"a*", ""}};
+    std::vector<std::shared_ptr<const CompiledPattern>> trickyCompiled;
+    for (const auto& c : cases)
+    {
+        trickyCompiled.push_back(tricky.get(tricky.add(c.first)));
+    }
+    PatternSet trickySet(trickyCompiled);
+    for (size_t i = 0; i < cases.size(); ++i)
+    {
+        std::vector<uint32_t> m = trickySet.matchLine(cases[i].second);
+        bool expected = trickyCompiled[i]->matches(cases[i].second);
+        mismatches += (std::count(m.begin(), m.end(), trickyCompiled[i]->id) == 1) != expected;
+    }
+    mismatches += trickyCompiled[0]->literal != "ABCD" || trickyCompiled[2]->literal != "a";
+
+    if (mismatches || !dedup)
+    {
+        std::cerr << "Self-test failed: " << mismatches << " lines differ from per-pattern regex_search" << std::endl;
+        return 1;
+    }
+    std::cout << "Self-test passed (" << expected.size() << " lines, " << matchedLines << " with matches)" << std::endl;
+
+    std::string log = makeLog(32 << 20);
+    auto start = std::chrono::steady_clock::now();
+    size_t hits = set.scan(log, [&](size_t, std::string_view, const std::vector<uint32_t>& m)
+    {
+        for (uint32_t id : m)
+        {
+            perPattern[id]++;
+        }
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Every regex on every line: " << sample.size() / naiveSeconds / 1e6 << " MB/s" << std::endl;
+    std::cout << "PatternSet one-pass scan:  " << log.size() / seconds / 1e6 << " MB/s (" << hits << " matching lines of "
+              << log.size() / (1 << 20) << " MiB)" << std::endl;
+    std::cout << "Top matches: 'connection reset' " << perPattern[static_cast<size_t>(ids[180])] << ", 'error user=' (icase) "
+              << perPattern[static_cast<size_t>(ids[183])] << std::endl;
     return 0;
 }
-
@@ -0,0 +1,607 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// A validated, compiled pattern. Immutable once built, so one instance can
+// be shared by any number of threads (std::regex matching is const).
+struct CompiledPattern
+{
+    uint32_t id;
+    std::string source;
+    bool icase;
+    std::regex regex;
+    std::string literal;   ///< Substring every match must contain (ASCII-folded if icase); may be empty
+    bool literalOnly;      ///< The pattern is exactly literal, so finding it is a match
+    bool literalPrefix;    ///< Every match starts with literal
+
+    bool matches(std::string_view text) const
+    {
+        return std::regex_search(text.begin(), text.end(), regex);
+    }
+
+    // Match starting exactly at text[at]; earlier characters are only context
+    bool matchesAt(std::string_view text, size_t at) const
+    {
+        auto flags = std::regex_constants::match_continuous;
+        if (at > 0)
+        {
+            flags |= std::regex_constants::match_prev_avail;
+        }
+        return std::regex_search(text.begin() + static_cast<std::ptrdiff_t>(at), text.end(), regex, flags);
+    }
+};
+
+namespace regex_detail
+{
+
+// Index one past the group or class starting at i, or npos if unterminated
+inline size_t skipBracket(const std::string& p, size_t i)
+{
+    char open = p[i];
+    if (open == '[')
+    {
+        ++i;
+        if (i < p.size() && p[i] == '^')
+        {
+            ++i;
+        }
+        for (; i < p.size(); ++i)
+        {
+            if (p[i] == '\\')
+            {
+                ++i;
+            }
+            else if (p[i] == ']')
+            {
+                return i + 1;
+            }
+        }
+        return std::string::npos;
+    }
+    int depth = 0;
+    for (; i < p.size(); ++i)
+    {
+        if (p[i] == '\\')
+        {
+            ++i;
+        }
+        else if (p[i] == '[')
+        {
+            i = skipBracket(p, i);
+            if (i == std::string::npos)
+            {
+                return i;
+            }
+            --i;
+        }
+        else if (p[i] == '(')
+        {
+            ++depth;
+        }
+        else if (p[i] == ')' && --depth == 0)
+        {
+            return i + 1;
+        }
+    }
+    return std::string::npos;
+}
+
+// Value of the digits hex digits at p[i], or -1 if they are not all there
+inline int hexValue(const std::string& p, size_t i, size_t digits)
+{
+    if (i + digits > p.size())
+    {
+        return -1;
+    }
+    int value = 0;
+    for (size_t d = 0; d < digits; ++d)
+    {
+        char h = p[i + d];
+        int v = h >= '0' && h <= '9' ? h - '0' : h >= 'a' && h <= 'f' ? h - 'a' + 10 : h >= 'A' && h <= 'F' ? h - 'A' + 10 : -1;
+        if (v < 0)
+        {
+            return -1;
+        }
+        value = value * 16 + v;
+    }
+    return value;
+}
+
+// Longest run of literal characters that every match of an ECMAScript
+// pattern must contain. Groups, classes, escapes like \d, back-references,
+// \cX and anything under a ?, * or {0,...} quantifier end a run (\xHH and
+// \uHHHH are decoded to the character); a top-level '|' means there is no
+// single required literal. literalOnly is set when the whole pattern is one
+// plain literal, prefix when every match begins with the returned literal.
+inline std::string requiredLiteral(const std::string& p, bool& literalOnly, bool& prefix)
+{
+    std::string best, run;
+    bool runAtStart = true;
+    literalOnly = !p.empty();
+    prefix = false;
+    auto flush = [&]()
+    {
+        if (run.size() > best.size())
+        {
+            best = run;
+            prefix = runAtStart;
+        }
+        run.clear();
+        runAtStart = false;
+    };
+
+    for (size_t i = 0; i < p.size();)
+    {
+        char c = p[i];
+        int literal = -1;
+        size_t next = i + 1;
+        switch (c)
+        {
+        case '|':
+            literalOnly = prefix = false;
+            return std::string();
+        case '(':
+        case '[':
+            next = skipBracket(p, i);
+            if (next == std::string::npos)
+            {
+                literalOnly = prefix = false;
+                return std::string();
+            }
+            break;
+        case '.':
+        case '^':
+        case '$':
+            break;
+        case '\\':
+            if (i + 1 < p.size())
+            {
+                char e = p[i + 1];
+                next = i + 2;
+                if (e == 't') literal = '\t';
+                else if (e == 'n') literal = '\n';
+                else if (e == 'r') literal = '\r';
+                else if (e == 'x' || e == 'u')
+                {
+                    // \xHH and \uHHHH stand for one character; only ASCII is kept
+                    size_t digits = e == 'x' ? 2 : 4;
+                    int value = hexValue(p, i + 2, digits);
+                    if (value >= 0)
+                    {
+                        next = i + 2 + digits;
+                        literal = value < 0x80 ? value : -1;
+                    }
+                }
+                else if (e == 'c')
+                {
+                    // \cX: what it matches varies between libraries, so it only ends the run
+                    next = i + 2 < p.size() ? i + 3 : i + 2;
+                }
+                else if (isdigit(static_cast<unsigned char>(e)))
+                {
+                    // \0 or a back-reference: skip all of it, ending the run
+                    while (next < p.size() && isdigit(static_cast<unsigned char>(p[next])))
+                    {
+                        ++next;
+                    }
+                }
+                else if (!isalnum(static_cast<unsigned char>(e))) literal = static_cast<unsigned char>(e);
+            }
+            break;
+        default:
+            literal = static_cast<unsigned char>(c);
+            break;
+        }
+
+        // Following quantifiers decide whether the atom must be present.
+        // libstdc++ accepts them stacked (a?{0,2}, x+{1,}?), so all of them
+        // are consumed; the atom is optional if any one of them allows zero.
+        bool optional = false;
+        bool quantified = false;
+        while (next < p.size())
+        {
+            char q = p[next];
+            if (q == '?' || q == '*')
+            {
+                optional = true;
+                ++next;
+            }
+            else if (q == '+')
+            {
+                ++next;
+            }
+            else if (q == '{' && p.find('}', next) != std::string::npos)
+            {
+                size_t close = p.find('}', next);
+                optional = optional || p.compare(next, 3, "{0,") == 0 || p.compare(next, 3, "{0}") == 0;
+                next = close + 1;
+            }
+            else
+            {
+                break;
+            }
+            quantified = true;
+            if (next < p.size() && p[next] == '?')
+            {
+                ++next; // lazy
+            }
+        }
+
+        if (literal < 0 || quantified)
+        {
+            literalOnly = false;
+        }
+        if (literal < 0 || optional)
+        {
+            flush();
+        }
+        else
+        {
+            run += static_cast<char>(literal);
+            if (quantified)
+            {
+                flush(); // x{2,} or x+: the next atom need not follow a single x
+            }
+        }
+        i = next;
+    }
+    flush();
+    return best;
+}
+
+inline char fold(char c)
+{
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c | 0x20) : c;
+}
+
+} // namespace regex_detail
+
+// Validates and compiles patterns once. add() returns the same id for a
+// pattern added twice; get() hands out shared, immutable matchers. Safe to
+// use from several threads.
+class RegexRegistry
+{
+public:
+    // True if pattern compiles as an ECMAScript regex
+    static bool validate(const std::string& pattern, std::string* error = nullptr)
+    {
+        try
+        {
+            std::regex regex(pattern);
+            return true;
+        }
+        catch (const std::regex_error& e)
+        {
+            if (error)
+            {
+                *error = e.what();
+            }
+            return false;
+        }
+    }
+
+    // Compile pattern (or find it compiled); -1 if it is not a valid regex
+    int add(const std::string& pattern, bool icase = false, std::string* error = nullptr)
+    {
+        std::string key = (icase ? "i:" : "s:") + pattern;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = byKey_.find(key);
+            if (it != byKey_.end())
+            {
+                return static_cast<int>(it->second);
+            }
+        }
+
+        // Compile outside the lock; a racing add of the same pattern keeps the first
+        std::shared_ptr<CompiledPattern> compiled = std::make_shared<CompiledPattern>();
+        try
+        {
+            auto flags = std::regex::ECMAScript | std::regex::optimize | (icase ? std::regex::icase : std::regex::flag_type());
+            compiled->regex = std::regex(pattern, flags);
+        }
+        catch (const std::regex_error& e)
+        {
+            if (error)
+            {
+                *error = e.what();
+            }
+            return -1;
+        }
+        compiled->source = pattern;
+        compiled->icase = icase;
+        compiled->literal = regex_detail::requiredLiteral(pattern, compiled->literalOnly, compiled->literalPrefix);
+        if (icase)
+        {
+            std::transform(compiled->literal.begin(), compiled->literal.end(), compiled->literal.begin(), regex_detail::fold);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto ins = byKey_.emplace(key, static_cast<uint32_t>(patterns_.size()));
+        if (ins.second)
+        {
+            compiled->id = ins.first->second;
+            patterns_.push_back(compiled);
+        }
+        return static_cast<int>(ins.first->second);
+    }
+
+    std::shared_ptr<const CompiledPattern> get(int id) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return id >= 0 && static_cast<size_t>(id) < patterns_.size() ? patterns_[static_cast<size_t>(id)] : nullptr;
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return patterns_.size();
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, uint32_t> byKey_;
+    std::vector<std::shared_ptr<const CompiledPattern>> patterns_;
+};
+
+// Matches many patterns against a buffer of lines in one pass.
+//
+// The required literals of all patterns are merged into one case-folding
+// Aho-Corasick automaton, compiled to a dense DFA over byte classes. The
+// buffer is walked once through that DFA; a pattern that is a plain literal
+// matches as soon as its literal is seen, and any other pattern runs its
+// regex only on lines where its literal occurred. Patterns without a usable
+// literal (alternations, leading classes, ...) run on every line.
+//
+// Immutable after construction: scan() may be called from several threads.
+class PatternSet
+{
+public:
+    // Called for each line with at least one match; ids are registry ids, ascending
+    typedef std::function<void(size_t lineIndex, std::string_view line, const std::vector<uint32_t>& ids)> Handler;
+
+    static const size_t kMinLiteral = 3;   ///< Shorter literals would pass almost every line
+
+    explicit PatternSet(std::vector<std::shared_ptr<const CompiledPattern>> patterns) : patterns_(std::move(patterns))
+    {
+        build();
+    }
+
+    size_t size() const { return patterns_.size(); }
+    size_t states() const { return outStart_.size() - 1; }
+    size_t alwaysRun() const { return always_.size(); }
+
+    // Scan newline-separated text; returns the number of lines with a match
+    size_t scan(std::string_view buffer, const Handler& handler) const
+    {
+        std::vector<uint32_t> stamp(patterns_.size(), 0);
+        std::vector<uint32_t> candidates, matched;
+        std::vector<std::pair<uint32_t, uint32_t>> anchored; // pattern, literal offset in line
+        size_t lines = 0, hits = 0;
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(buffer.data());
+        size_t lineStart = 0;
+        uint32_t state = 0;
+        for (size_t i = 0; i <= buffer.size(); ++i)
+        {
+            if (i == buffer.size() || data[i] == '\n')
+            {
+                if (i > lineStart || i < buffer.size())
+                {
+                    std::string_view line(buffer.data() + lineStart, i - lineStart);
+                    uint32_t tag = static_cast<uint32_t>(lines + 1);
+                    if (finishLine(line, candidates, anchored, stamp, tag, matched))
+                    {
+                        handler(lines, line, matched);
+                        hits++;
+                    }
+                    lines++;
+                }
+                candidates.clear();
+                anchored.clear();
+                matched.clear();
+                lineStart = i + 1;
+                state = 0;
+                continue;
+            }
+            state = delta_[state * classCount_ + classOf_[data[i]]];
+            uint32_t o = outStart_[state], oe = outStart_[state + 1];
+            for (; o < oe; ++o)
+            {
+                uint32_t p = outputs_[o];
+                if (stamp[p] == lines + 1)
+                {
+                    continue;
+                }
+                const CompiledPattern& cp = *patterns_[p];
+                if (cp.literalOnly && !cp.icase &&
+                    memcmp(buffer.data() + i + 1 - cp.literal.size(), cp.literal.data(), cp.literal.size()) != 0)
+                {
+                    continue; // folded hit, but the case differs
+                }
+                if (cp.literalPrefix && !cp.literalOnly)
+                {
+                    // Verified later at this occurrence instead of across the whole line
+                    anchored.push_back({p, static_cast<uint32_t>(i + 1 - cp.literal.size() - lineStart)});
+                    continue;
+                }
+                stamp[p] = static_cast<uint32_t>(lines + 1);
+                (cp.literalOnly ? matched : candidates).push_back(p);
+            }
+        }
+        return hits;
+    }
+
+    // Registry ids of the patterns matching one line
+    std::vector<uint32_t> matchLine(std::string_view line) const
+    {
+        std::vector<uint32_t> ids;
+        line = line.substr(0, line.find('\n'));
+        if (line.empty())
+        {
+            // scan() counts no lines in an empty buffer; here it is one empty line
+            std::vector<uint32_t> stamp(patterns_.size(), 0), candidates;
+            std::vector<std::pair<uint32_t, uint32_t>> anchored;
+            finishLine(line, candidates, anchored, stamp, 1, ids);
+            return ids;
+        }
+        scan(line, [&](size_t, std::string_view, const std::vector<uint32_t>& m) { ids = m; });
+        return ids;
+    }
+
+private:
+    // Confirm the line's candidates and always-run patterns, then turn the
+    // matches into registry ids
+    bool finishLine(std::string_view line, const std::vector<uint32_t>& candidates,
+                    const std::vector<std::pair<uint32_t, uint32_t>>& anchored, std::vector<uint32_t>& stamp,
+                    uint32_t tag, std::vector<uint32_t>& matched) const
+    {
+        for (const auto& a : anchored)
+        {
+            if (stamp[a.first] != tag && patterns_[a.first]->matchesAt(line, a.second))
+            {
+                stamp[a.first] = tag;
+                matched.push_back(a.first);
+            }
+        }
+        for (uint32_t p : candidates)
+        {
+            if (patterns_[p]->matches(line))
+            {
+                matched.push_back(p);
+            }
+        }
+        for (uint32_t p : always_)
+        {
+            if (patterns_[p]->matches(line))
+            {
+                matched.push_back(p);
+            }
+        }
+        if (matched.empty())
+        {
+            return false;
+        }
+        for (uint32_t& p : matched)
+        {
+            p = patterns_[p]->id;
+        }
+        std::sort(matched.begin(), matched.end());
+        return true;
+    }
+
+    void build()
+    {
+        // Byte classes: every folded byte used by a literal gets its own class
+        memset(classOf_, 0, sizeof(classOf_));
+        classCount_ = 1;
+        for (const auto& p : patterns_)
+        {
+            if (p->literal.size() < kMinLiteral && !p->literalOnly)
+            {
+                continue;
+            }
+            for (char ch : p->literal)
+            {
+                unsigned char f = static_cast<unsigned char>(regex_detail::fold(ch));
+                if (classOf_[f] == 0)
+                {
+                    classOf_[f] = static_cast<uint16_t>(classCount_++);
+                }
+            }
+        }
+        for (int c = 'A'; c <= 'Z'; ++c)
+        {
+            classOf_[c] = classOf_[c | 0x20];
+        }
+        classOf_[static_cast<unsigned char>('\n')] = 0;
+
+        // Trie of folded literals
+        std::vector<std::vector<uint32_t>> out(1);
+        std::vector<uint32_t> trie(classCount_, 0);
+        const uint32_t kAbsent = 0;
+        for (uint32_t i = 0; i < patterns_.size(); ++i)
+        {
+            const CompiledPattern& p = *patterns_[i];
+            if (p.literal.empty() || p.literal.find('\n') != std::string::npos ||
+                (p.literal.size() < kMinLiteral && !p.literalOnly))
+            {
+                always_.push_back(i);
+                continue;
+            }
+            uint32_t s = 0;
+            for (char ch : p.literal)
+            {
+                uint16_t cls = classOf_[static_cast<unsigned char>(regex_detail::fold(ch))];
+                uint32_t& t = trie[s * classCount_ + cls];
+                if (t == kAbsent)
+                {
+                    t = static_cast<uint32_t>(out.size());
+                    out.emplace_back();
+                    trie.resize(trie.size() + classCount_, kAbsent);
+                }
+                s = trie[s * classCount_ + cls];
+            }
+            out[s].push_back(i);
+        }
+
+        // Breadth-first: fill missing edges from the failure state, which is
+        // always shallower and therefore already complete
+        size_t n = out.size();
+        std::vector<uint32_t> fail(n, 0), queue;
+        delta_.assign(n * classCount_, 0);
+        for (size_t c = 0; c < classCount_; ++c)
+        {
+            uint32_t t = c == 0 ? 0 : trie[c];
+            delta_[c] = t;
+            if (t != 0)
+            {
+                queue.push_back(t);
+            }
+        }
+        for (size_t q = 0; q < queue.size(); ++q)
+        {
+            uint32_t s = queue[q];
+            const std::vector<uint32_t>& inherited = out[fail[s]];
+            out[s].insert(out[s].end(), inherited.begin(), inherited.end());
+            for (size_t c = 0; c < classCount_; ++c)
+            {
+                uint32_t t = c == 0 ? 0 : trie[s * classCount_ + c];
+                if (t != 0)
+                {
+                    fail[t] = delta_[fail[s] * classCount_ + c];
+                    delta_[s * classCount_ + c] = t;
+                    queue.push_back(t);
+                }
+                else
+                {
+                    delta_[s * classCount_ + c] = delta_[fail[s] * classCount_ + c];
+                }
+            }
+        }
+
+        outStart_.assign(n + 1, 0);
+        for (size_t s = 0; s < n; ++s)
+        {
+            outStart_[s + 1] = outStart_[s] + static_cast<uint32_t>(out[s].size());
+            outputs_.insert(outputs_.end(), out[s].begin(), out[s].end());
+        }
+    }
+
+    std::vector<std::shared_ptr<const CompiledPattern>> patterns_;
+    uint16_t classOf_[256];
+    size_t classCount_ = 1;
+    std::vector<uint32_t> delta_;      ///< states x classes
+    std::vector<uint32_t> outStart_;   ///< Per state, range of outputs_
+    std::vector<uint32_t> outputs_;    ///< Indices into patterns_ whose literal ends here
+    std::vector<uint32_t> always_;     ///< Patterns checked on every line
+};
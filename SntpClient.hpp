@@ -0,0 +1,465 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <errno.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include "NtpTime.hpp"
+#include "AddressValidators.hpp"
+
+// SNTP (RFC 4330) client that measures clock offset and round-trip delay
+// against several servers at once, without shelling out to ntpdate.
+//
+// Each round sends one request to every server and waits for the replies
+// together. Replies are stamped on arrival by the kernel (SO_TIMESTAMPNS),
+// so scheduling delay between the packet landing and recvmsg() returning
+// does not count as network delay. From the four timestamps
+//   t1 client send, t2 server receive, t3 server send, t4 client receive
+// offset = ((t2 - t1) + (t3 - t4)) / 2 and delay = (t4 - t1) - (t3 - t2).
+//
+// Filtering follows NTP in miniature: per server, the minimum-delay sample
+// of the burst (queueing only ever adds delay, and asymmetric queueing is
+// what skews offset); across servers, an interval intersection that keeps
+// only servers whose offset +/- error bound agrees with a majority; the
+// result is the median of those.
+
+struct SntpSample
+{
+    int64_t offset;          ///< Server clock minus local clock, ns
+    int64_t delay;           ///< Round trip minus server processing, ns
+    int64_t t1, t2, t3, t4;  ///< Unix ns
+    int stratum;
+    int64_t rootDelay;       ///< Server's delay to its reference, ns
+    int64_t rootDispersion;  ///< Server's error bound to its reference, ns
+};
+
+struct SntpServerResult
+{
+    std::string server;
+    std::string error;                ///< Last problem seen; may be set even if samples arrived
+    std::vector<SntpSample> samples;
+    int best = -1;                    ///< Minimum-delay sample, or -1
+    bool selected = false;            ///< Agreed with the majority
+
+    const SntpSample* bestSample() const { return best < 0 ? nullptr : &samples[static_cast<size_t>(best)]; }
+};
+
+struct SntpResult
+{
+    bool ok = false;
+    int64_t offset = 0;   ///< Median offset of the selected servers, ns
+    int64_t delay = 0;    ///< Smallest delay among the selected servers, ns
+    int64_t jitter = 0;   ///< RMS of the selected offsets around offset, ns
+    std::vector<SntpServerResult> servers;
+};
+
+struct SntpOptions
+{
+    int samples = 4;                                       ///< Rounds, i.e. requests per server
+    std::chrono::milliseconds timeout{500};                ///< Per round
+    int64_t tolerance = 1000000;                           ///< Added to each server's error bound, ns
+};
+
+namespace sntp_detail
+{
+
+constexpr size_t kPacketSize = 48;
+
+inline int64_t unixNanos(const struct timespec& ts)
+{
+    return static_cast<int64_t>(ts.tv_sec) * ntp_detail::kNanosPerSecond + ts.tv_nsec;
+}
+
+inline int64_t realtimeNanos()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return unixNanos(ts);
+}
+
+// "host", "host:port", "a.b.c.d:port" or "[v6]:port"; port defaults to 123
+inline void splitServer(const std::string& server, std::string& host, std::string& port)
+{
+    HostPortParts parts;
+    if (parseHostPort(server, &parts))
+    {
+        host = std::string(parts.host);
+        port = std::string(parts.port);
+    }
+    else
+    {
+        host = server;
+        port = "123";
+    }
+}
+
+} // namespace sntp_detail
+
+class SntpClient
+{
+public:
+    explicit SntpClient(std::vector<std::string> servers, SntpOptions options = SntpOptions())
+        : servers_(std::move(servers)), options_(options), rng_(std::random_device()())
+    {
+    }
+
+    // One measurement: options.samples rounds against every server. Blocks
+    // for at most samples * timeout.
+    SntpResult query()
+    {
+        SntpResult result;
+        std::vector<Peer> peers(servers_.size());
+        result.servers.resize(servers_.size());
+        for (size_t i = 0; i < servers_.size(); ++i)
+        {
+            result.servers[i].server = servers_[i];
+            peers[i].fd = openSocket(servers_[i], result.servers[i].error);
+        }
+
+        for (int round = 0; round < options_.samples; ++round)
+        {
+            runRound(peers, result);
+        }
+        for (auto& p : peers)
+        {
+            if (p.fd >= 0)
+            {
+                close(p.fd);
+            }
+        }
+        select(result, options_.tolerance);
+        return result;
+    }
+
+    // Fill a client request; the transmit field carries a random cookie the
+    // server echoes back as originate, so stray or spoofed replies are
+    // rejected without disclosing the local clock
+    static void makeRequest(uint8_t packet[sntp_detail::kPacketSize], uint64_t cookie)
+    {
+        memset(packet, 0, sntp_detail::kPacketSize);
+        packet[0] = 0x23; // LI 0, version 4, mode 3 (client)
+        storeBE<uint64_t>(packet + 40, cookie);
+    }
+
+    // Validate a server reply to the request carrying cookie; t1 and t4 are
+    // the local send and receive times in Unix ns
+    static bool parseReply(const uint8_t* packet, size_t length, uint64_t cookie, int64_t t1, int64_t t4,
+                           SntpSample* sample, std::string* error)
+    {
+        auto fail = [&](const std::string& why)
+        {
+            if (error)
+            {
+                *error = why;
+            }
+            return false;
+        };
+        if (length < sntp_detail::kPacketSize)
+        {
+            return fail("short reply");
+        }
+        int leap = packet[0] >> 6, version = packet[0] >> 3 & 7, mode = packet[0] & 7;
+        if ((mode != 4 && mode != 5) || version < 1 || version > 4)
+        {
+            return fail("not a server reply");
+        }
+        if (loadBE<uint64_t>(packet + 24) != cookie)
+        {
+            return fail("originate does not match request");
+        }
+        int stratum = packet[1];
+        if (stratum == 0)
+        {
+            return fail("kiss-o'-death " + std::string(reinterpret_cast<const char*>(packet + 12), 4));
+        }
+        if (leap == 3 || stratum > 15)
+        {
+            return fail("server unsynchronized");
+        }
+        NtpTimestamp receive = NtpTimestamp::fromWire(packet + 32);
+        NtpTimestamp transmit = NtpTimestamp::fromWire(packet + 40);
+        if (transmit.raw() == 0)
+        {
+            return fail("zero transmit timestamp");
+        }
+
+        SntpSample s;
+        int64_t pivot = ntp_detail::floorSeconds(t1);
+        s.t1 = t1;
+        s.t2 = receive.toUnixNanos(pivot);
+        s.t3 = transmit.toUnixNanos(pivot);
+        s.t4 = t4;
+        s.offset = ((s.t2 - s.t1) + (s.t3 - s.t4)) / 2;
+        s.delay = (s.t4 - s.t1) - (s.t3 - s.t2);
+        s.stratum = stratum;
+        s.rootDelay = ntpShortToNanos(loadBE<uint32_t>(packet + 4));
+        s.rootDispersion = ntpShortToNanos(loadBE<uint32_t>(packet + 8));
+        if (s.delay < 0)
+        {
+            return fail("negative delay");
+        }
+        *sample = s;
+        return true;
+    }
+
+    // The servers' samples reduced to one offset (see the file comment);
+    // tolerance widens every server's error interval
+    static void select(SntpResult& result, int64_t tolerance)
+    {
+        struct Edge
+        {
+            int64_t at;
+            int step;
+        };
+        std::vector<Edge> edges;
+        size_t responding = 0;
+        for (auto& s : result.servers)
+        {
+            s.best = -1;
+            for (size_t i = 0; i < s.samples.size(); ++i)
+            {
+                if (s.best < 0 || s.samples[i].delay < s.samples[static_cast<size_t>(s.best)].delay)
+                {
+                    s.best = static_cast<int>(i);
+                }
+            }
+            if (const SntpSample* b = s.bestSample())
+            {
+                responding++;
+                edges.push_back({b->offset - bound(*b, tolerance), +1});
+                edges.push_back({b->offset + bound(*b, tolerance), -1});
+            }
+        }
+        if (responding == 0)
+        {
+            return;
+        }
+
+        // Find the offset range covered by the most error intervals
+        std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b)
+        {
+            return a.at < b.at || (a.at == b.at && a.step > b.step);
+        });
+        int depth = 0, most = 0;
+        int64_t low = 0, high = 0;
+        for (size_t i = 0; i < edges.size(); ++i)
+        {
+            depth += edges[i].step;
+            if (depth > most)
+            {
+                most = depth;
+                low = edges[i].at;
+                high = edges[i + 1].at;
+            }
+        }
+        if (static_cast<size_t>(most) * 2 <= responding && responding > 1)
+        {
+            return; // no majority agrees on the time
+        }
+
+        std::vector<int64_t> offsets;
+        for (auto& s : result.servers)
+        {
+            const SntpSample* b = s.bestSample();
+            s.selected = b && b->offset - bound(*b, tolerance) <= high && b->offset + bound(*b, tolerance) >= low;
+            if (s.selected)
+            {
+                offsets.push_back(b->offset);
+                result.delay = offsets.size() == 1 ? b->delay : std::min(result.delay, b->delay);
+            }
+        }
+        std::sort(offsets.begin(), offsets.end());
+        size_t n = offsets.size();
+        result.offset = n % 2 ? offsets[n / 2] : (offsets[n / 2 - 1] + offsets[n / 2]) / 2;
+        double sum = 0;
+        for (int64_t o : offsets)
+        {
+            sum += static_cast<double>(o - result.offset) * static_cast<double>(o - result.offset);
+        }
+        result.jitter = static_cast<int64_t>(std::sqrt(sum / static_cast<double>(n)));
+        result.ok = true;
+    }
+
+    const SntpOptions& options() const { return options_; }
+
+private:
+    struct Peer
+    {
+        int fd = -1;
+        uint64_t cookie = 0;
+        int64_t t1 = 0;
+        bool waiting = false;
+        bool stopped = false;   ///< Kiss-o'-death: do not ask again this query
+    };
+
+    // Half-width of a sample's error interval: half the round trip, the
+    // server's own distance to its reference, plus a fixed allowance
+    static int64_t bound(const SntpSample& s, int64_t tolerance)
+    {
+        return s.delay / 2 + s.rootDelay / 2 + s.rootDispersion + tolerance;
+    }
+
+    int openSocket(const std::string& server, std::string& error)
+    {
+        std::string host, port;
+        sntp_detail::splitServer(server, host, port);
+        addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_DGRAM;
+        addrinfo* found = nullptr;
+        int rc = getaddrinfo(host.c_str(), port.c_str(), &hints, &found);
+        if (rc != 0)
+        {
+            error = gai_strerror(rc);
+            return -1;
+        }
+        int fd = -1;
+        for (addrinfo* a = found; a && fd < 0; a = a->ai_next)
+        {
+            fd = socket(a->ai_family, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+            int on = 1;
+            if (fd >= 0 && (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) < 0 ||
+                            connect(fd, a->ai_addr, a->ai_addrlen) < 0))
+            {
+                error = strerror(errno);
+                close(fd);
+                fd = -1;
+            }
+        }
+        freeaddrinfo(found);
+        return fd;
+    }
+
+    void runRound(std::vector<Peer>& peers, SntpResult& result)
+    {
+        uint8_t packet[sntp_detail::kPacketSize];
+        std::vector<pollfd> fds;
+        for (size_t i = 0; i < peers.size(); ++i)
+        {
+            Peer& p = peers[i];
+            p.waiting = false;
+            if (p.fd < 0 || p.stopped)
+            {
+                continue;
+            }
+            p.cookie = rng_();
+            makeRequest(packet, p.cookie);
+            p.t1 = sntp_detail::realtimeNanos();
+            if (send(p.fd, packet, sizeof(packet), 0) != static_cast<ssize_t>(sizeof(packet)))
+            {
+                result.servers[i].error = strerror(errno);
+                continue;
+            }
+            p.waiting = true;
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + options_.timeout;
+        for (;;)
+        {
+            fds.clear();
+            for (const auto& p : peers)
+            {
+                if (p.waiting)
+                {
+                    fds.push_back({p.fd, POLLIN, 0});
+                }
+            }
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            if (fds.empty() || left.count() <= 0)
+            {
+                break;
+            }
+            if (poll(fds.data(), fds.size(), static_cast<int>(left.count()) + 1) <= 0)
+            {
+                continue;
+            }
+            for (size_t i = 0; i < peers.size(); ++i)
+            {
+                if (peers[i].waiting)
+                {
+                    receive(peers[i], result.servers[i]);
+                }
+            }
+        }
+        for (size_t i = 0; i < peers.size(); ++i)
+        {
+            if (peers[i].waiting)
+            {
+                result.servers[i].error = "timed out";
+            }
+        }
+    }
+
+    // Drain one socket; a matching reply ends this round for the peer
+    void receive(Peer& p, SntpServerResult& out)
+    {
+        uint8_t packet[128];
+        char control[CMSG_SPACE(sizeof(struct timespec))];
+        for (;;)
+        {
+            iovec iov = {packet, sizeof(packet)};
+            msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            ssize_t n = recvmsg(p.fd, &msg, 0);
+            if (n < 0)
+            {
+                if (errno != EAGAIN && errno != EINTR)
+                {
+                    out.error = strerror(errno); // e.g. ECONNREFUSED from an ICMP error
+                    p.waiting = false;
+                }
+                return;
+            }
+            int64_t t4 = 0;
+            for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c))
+            {
+                if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS)
+                {
+                    struct timespec ts;
+                    memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+                    t4 = sntp_detail::unixNanos(ts);
+                }
+            }
+            if (t4 == 0)
+            {
+                t4 = sntp_detail::realtimeNanos();
+            }
+
+            if (n >= static_cast<ssize_t>(sntp_detail::kPacketSize) && loadBE<uint64_t>(packet + 24) != p.cookie)
+            {
+                continue; // a late reply to an earlier round
+            }
+            SntpSample sample;
+            std::string error;
+            if (parseReply(packet, static_cast<size_t>(n), p.cookie, p.t1, t4, &sample, &error))
+            {
+                out.samples.push_back(sample);
+                p.waiting = false;
+                return;
+            }
+            out.error = error;
+            p.waiting = false;
+            p.stopped = packet[1] == 0; // kiss-o'-death: back off for the rest of the query
+            return;
+        }
+    }
+
+    std::vector<std::string> servers_;
+    SntpOptions options_;
+    std::mt19937_64 rng_;
+};
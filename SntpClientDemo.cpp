@@ -0,0 +1,235 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include "SntpClient.hpp"
+
+// Stand-in NTP server on 127.0.0.1 whose clock runs offset ns ahead of the
+// local one. Inbound and outbound delays are simulated by holding the
+// request before stamping t2 and the reply after stamping t3.
+class FakeNtpServer
+{
+public:
+    enum Mode
+    {
+        Normal,
+        KissOfDeath,
+        Unsynchronized
+    };
+
+    FakeNtpServer(int64_t offset, std::function<int64_t()> inboundDelay = nullptr, Mode mode = Normal)
+        : offset_(offset), inboundDelay_(std::move(inboundDelay)), mode_(mode), running_(true), served_(0)
+    {
+        fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (fd_ < 0 || bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+        {
+            throw std::runtime_error("Cannot bind stand-in NTP server");
+        }
+        socklen_t len = sizeof(addr);
+        getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+        struct timeval tv = {0, 20000};
+        setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        thread_ = std::thread([this]() { serve(); });
+    }
+
+    ~FakeNtpServer()
+    {
+        running_ = false;
+        thread_.join();
+        close(fd_);
+    }
+
+    std::string address() const { return "127.0.0.1:" + std::to_string(port_); }
+    int served() const { return served_; }
+
+private:
+    void serve()
+    {
+        uint8_t packet[48];
+        while (running_)
+        {
+            sockaddr_in peer;
+            socklen_t len = sizeof(peer);
+            ssize_t n = recvfrom(fd_, packet, sizeof(packet), 0, reinterpret_cast<sockaddr*>(&peer), &len);
+            if (n != sizeof(packet))
+            {
+                continue;
+            }
+            if (inboundDelay_)
+            {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(inboundDelay_()));
+            }
+            NtpTimestamp t2 = NtpTimestamp::fromUnixNanos(sntp_detail::realtimeNanos() + offset_);
+            uint64_t originate = loadBE<uint64_t>(packet + 40);
+            memset(packet, 0, sizeof(packet));
+            packet[0] = (mode_ == Unsynchronized ? 0xC0 : 0x00) | 4 << 3 | 4;
+            packet[1] = mode_ == KissOfDeath ? 0 : 2;
+            storeBE<uint32_t>(packet + 4, nanosToNtpShort(100000));  // root delay 0.1 ms
+            storeBE<uint32_t>(packet + 8, nanosToNtpShort(50000));   // root dispersion 0.05 ms
+            memcpy(packet + 12, mode_ == KissOfDeath ? "RATE" : "GPS\0", 4);
+            storeBE<uint64_t>(packet + 24, originate);
+            t2.toWire(packet + 32);
+            NtpTimestamp::fromUnixNanos(sntp_detail::realtimeNanos() + offset_).toWire(packet + 40);
+            sendto(fd_, packet, sizeof(packet), 0, reinterpret_cast<sockaddr*>(&peer), len);
+            served_++;
+        }
+    }
+
+    int64_t offset_;
+    std::function<int64_t()> inboundDelay_;
+    Mode mode_;
+    std::atomic<bool> running_;
+    std::atomic<int> served_;
+    int fd_;
+    uint16_t port_;
+    std::thread thread_;
+};
+
+static bool check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        std::cerr << "Self-test failed: " << what << std::endl;
+    }
+    return ok;
+}
+
+#define SELF_CHECK(cond) ok &= check((cond), #cond)
+
+static std::string micros(int64_t ns)
+{
+    int64_t a = std::llabs(ns);
+    return (ns < 0 ? "-" : "") + std::to_string(a / 1000) + "." + std::to_string(a % 1000 / 100) + " us";
+}
+
+static bool selfTest()
+{
+    bool ok = true;
+    const int64_t kOffset = 5000000; // the stand-in servers run 5 ms ahead
+
+    // Reply validation
+    uint8_t reply[48];
+    SntpClient::makeRequest(reply, 42);
+    SntpSample sample;
+    std::string error;
+    SELF_CHECK(!SntpClient::parseReply(reply, 48, 42, 0, 0, &sample, &error) && error == "not a server reply");
+    reply[0] = 0x24;
+    reply[1] = 1;
+    storeBE<uint64_t>(reply + 24, 41);
+    SELF_CHECK(!SntpClient::parseReply(reply, 48, 42, 0, 0, &sample, &error) && error == "originate does not match request");
+    SELF_CHECK(!SntpClient::parseReply(reply, 40, 42, 0, 0, &sample, &error) && error == "short reply");
+
+    // Good servers, one with 0-4 ms of inbound queueing (which skews each
+    // sample's offset by half its extra delay), one 300 ms off, one sending
+    // kiss-o'-death, one unsynchronized, one port with nothing listening
+    std::mt19937 rng(1);
+    FakeNtpServer a(kOffset), b(kOffset), c(kOffset, [&]() { return int64_t(rng() % 4000000); });
+    FakeNtpServer wrong(kOffset + 300000000), kod(kOffset, nullptr, FakeNtpServer::KissOfDeath);
+    FakeNtpServer unsynced(kOffset, nullptr, FakeNtpServer::Unsynchronized);
+    SntpOptions options;
+    options.samples = 8;
+    options.timeout = std::chrono::milliseconds(200);
+    SntpClient client({a.address(), b.address(), c.address(), wrong.address(), kod.address(), unsynced.address(),
+                       "127.0.0.1:9", "no-such-host.invalid"},
+                      options);
+    SntpResult r = client.query();
+
+    SELF_CHECK(r.ok);
+    SELF_CHECK(std::llabs(r.offset - kOffset) < 1000000);
+    SELF_CHECK(r.servers[0].selected && r.servers[1].selected && r.servers[2].selected);
+    SELF_CHECK(r.servers[0].samples.size() == 8 && r.servers[2].samples.size() == 8);
+    SELF_CHECK(!r.servers[3].selected);
+    SELF_CHECK(r.servers[4].samples.empty() && r.servers[4].error == "kiss-o'-death RATE" && kod.served() == 1);
+    SELF_CHECK(r.servers[5].samples.empty() && r.servers[5].error == "server unsynchronized");
+    SELF_CHECK(r.servers[6].samples.empty() && !r.servers[6].error.empty());
+    SELF_CHECK(r.servers[7].samples.empty() && !r.servers[7].error.empty());
+
+    // Minimum-delay selection on the jittery server beats averaging its samples
+    const SntpServerResult& jittery = r.servers[2];
+    int64_t mean = 0;
+    for (const auto& s : jittery.samples)
+    {
+        mean += s.offset - kOffset;
+    }
+    mean /= static_cast<int64_t>(jittery.samples.size());
+    int64_t bestError = jittery.bestSample() ? jittery.bestSample()->offset - kOffset : 0;
+    SELF_CHECK(std::llabs(bestError) < std::llabs(mean));
+
+    for (size_t i = 0; i < r.servers.size(); ++i)
+    {
+        const SntpServerResult& s = r.servers[i];
+        std::cout << "  " << s.server << ": ";
+        if (const SntpSample* best = s.bestSample())
+        {
+            std::cout << "offset " << micros(best->offset) << " delay " << micros(best->delay) << " ("
+                      << s.samples.size() << " samples)" << (s.selected ? "" : " rejected");
+        }
+        else
+        {
+            std::cout << s.error;
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "  combined: offset " << micros(r.offset) << ", delay " << micros(r.delay) << ", jitter " << micros(r.jitter)
+              << " (mean of jittery samples was off by " << micros(mean) << ")" << std::endl;
+
+    if (ok)
+    {
+        std::cout << "Self-test passed" << std::endl;
+    }
+    return ok;
+}
+
+int main(int argc, char* argv[])
+{
+    if (!selfTest())
+    {
+        return 1;
+    }
+
+    // Measurement overhead: one sample from one local server
+    FakeNtpServer local(0);
+    SntpOptions one;
+    one.samples = 1;
+    SntpClient client({local.address()}, one);
+    int64_t bestWall = INT64_MAX, bestDelay = INT64_MAX;
+    for (int i = 0; i < 200; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        SntpResult r = client.query();
+        int64_t wall = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        if (r.ok)
+        {
+            bestWall = std::min(bestWall, wall);
+            bestDelay = std::min(bestDelay, r.delay);
+        }
+    }
+    std::cout << "One query, one loopback server: " << micros(bestWall) << " wall (socket, send, receive, filter), "
+              << micros(bestDelay) << " measured round trip" << std::endl;
+
+    // Real servers, if any are named: SntpClientDemo pool.ntp.org time.google.com
+    if (argc > 1)
+    {
+        SntpClient real(std::vector<std::string>(argv + 1, argv + argc));
+        SntpResult r = real.query();
+        for (const auto& s : r.servers)
+        {
+            const SntpSample* best = s.bestSample();
+            std::cout << s.server << ": " << (best ? "offset " + micros(best->offset) + " delay " + micros(best->delay) : s.error)
+                      << std::endl;
+        }
+        std::cout << (r.ok ? "Local clock is off by " + micros(-r.offset) : std::string("No agreement between servers"))
+                  << std::endl;
+    }
+    return 0;
+}
@@ -6,34 +6,26 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <dirent.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <sys/resource.h>
+#include "ProcessTable.hpp"
+#include "StackSampler.hpp"
+#include "PeriodicTimer.hpp"
 
-std::vector < std::string > getProcessList() 
+// Live PIDs from a process table kept current by the proc connector
+const std::vector < pid_t > & getProcessList() 
 {
-  std::vector < std::string > processList;
-  DIR * dir = opendir("/proc");
-  if (dir == nullptr) 
-  {
-    std::cerr << "Failed to open /proc directory" << std::endl;
-    return processList;
-  }
-
-  struct dirent * entry;
-  while ((entry = readdir(dir)) != nullptr) 
-  {
-    if (entry -> d_type == DT_DIR && std::string(entry -> d_name).find_first_not_of("0123456789") == std::string::npos) 
-    {
-      processList.push_back(entry -> d_name);
-    }
-  }
-
-  closedir(dir);
-  return processList;
+  static ProcessTable table;
+  table.update();
+  return table.pids();
 }
 
-std::string getProcessStack(const std::string & pid) 
+std::string getProcessStack(pid_t pid) 
 {
   std::string stackTrace;
-  std::ifstream stackFile("/proc/" + pid + "/stack");
+  std::ifstream stackFile("/proc/" + std::to_string(pid) + "/stack");
   if (stackFile.is_open()) 
   {
     std::stringstream buffer;
@@ -43,20 +35,57 @@ std::string getProcessStack(const std::string & pid)
   } 
   else 
   {
-    stackTrace = "Failed to read stack for process " + pid;
+    stackTrace = "Failed to read stack for process " + std::to_string(pid);
   }
   return stackTrace;
 }
 
-int main() 
+static double cpuSeconds() 
+{
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, & ru);
+  return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+// Usage: StackMonitor [--dump] | [hz] [seconds] [--user]
+// Samples every thread's kernel stack and prints folded stacks for
+// flamegraph.pl on stdout; statistics go to stderr. --dump prints each
+// process's current stack once instead.
+int main(int argc, char ** argv) 
 {
-  std::vector < std::string > processList = getProcessList();
-  for (const auto & pid: processList) 
+  if (argc > 1 && std::string(argv[1]) == "--dump") 
   {
-    std::cout << "Process ID: " << pid << std::endl;
-    std::cout << "Stack Trace:" << std::endl;
-    std::cout << getProcessStack(pid) << std::endl;
-    std::cout << std::endl;
+    for (pid_t pid: getProcessList()) 
+    {
+      std::cout << "Process ID: " << pid << std::endl;
+      std::cout << "Stack Trace:" << std::endl;
+      std::cout << getProcessStack(pid) << std::endl;
+      std::cout << std::endl;
+    }
+    return 0;
   }
+
+  int hz = argc > 1 ? atoi(argv[1]) : 100;
+  int seconds = argc > 2 ? atoi(argv[2]) : 2;
+  StackSamplerOptions options;
+  options.userStacks = argc > 3 && std::string(argv[3]) == "--user";
+
+  StackSampler sampler(options);
+  double cpuStart = cpuSeconds();
+  {
+    PeriodicTimer timer([ & sampler]() { sampler.sample(); }, std::chrono::microseconds(1000000 / std::max(1, hz)));
+    timer.start();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    timer.stop();
+  }
+  double cpu = cpuSeconds() - cpuStart;
+
+  sampler.writeFolded(std::cout);
+  std::cerr << sampler.samples() << " samples of " << sampler.threads() << " threads, " << sampler.stacksRead()
+            << " stacks read, " << sampler.taskListings() << " task dirs listed, " << sampler.distinctStacks()
+            << " distinct stacks, " << sampler.distinctFrames() << " frames, " << sampler.memoryBytes() / 1024 << " KiB"
+            << std::endl;
+  std::cerr << "Sampler CPU: " << 100.0 * cpu / seconds << "% of a core, "
+            << (sampler.stacksRead() ? 1e6 * cpu / sampler.stacksRead() : 0.0) << " us per stack" << std::endl;
   return 0;
 }
@@ -0,0 +1,516 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "ProcFs.hpp"
+#include "ProcessTable.hpp"
+
+namespace stack_detail
+{
+
+// Hash-consed frame names: each distinct string is stored once in a byte
+// arena and identified by a dense 32-bit id. Once maxBytes is reached new
+// names map to kOverflow instead of growing the table.
+class FrameTable
+{
+public:
+    static const uint32_t kOverflow = 0;
+
+    explicit FrameTable(size_t maxBytes) : maxBytes_(maxBytes)
+    {
+        intern("[overflow]", 10);
+    }
+
+    uint32_t intern(const char* s, size_t n)
+    {
+        auto it = index_.find(Key{s, n, this});
+        if (it != index_.end())
+        {
+            return it->second;
+        }
+        if (arena_.size() + n > maxBytes_ && !offsets_.empty())
+        {
+            return kOverflow;
+        }
+        uint32_t id = static_cast<uint32_t>(offsets_.size());
+        offsets_.push_back(static_cast<uint32_t>(arena_.size()));
+        lengths_.push_back(static_cast<uint32_t>(n));
+        arena_.insert(arena_.end(), s, s + n);
+        index_.emplace(Key{nullptr, id, this}, id);
+        return id;
+    }
+
+    const char* data(uint32_t id) const { return arena_.data() + offsets_[id]; }
+    size_t length(uint32_t id) const { return lengths_[id]; }
+    size_t size() const { return offsets_.size(); }
+    size_t bytes() const { return arena_.capacity() + index_.size() * 32 + offsets_.capacity() * 8; }
+
+private:
+    // Either a probe (ptr, len) or a stored entry (nullptr, id)
+    struct Key
+    {
+        const char* ptr;
+        size_t n;
+        const FrameTable* table;
+
+        const char* str() const { return ptr ? ptr : table->data(static_cast<uint32_t>(n)); }
+        size_t len() const { return ptr ? n : table->length(static_cast<uint32_t>(n)); }
+    };
+
+    struct Hash
+    {
+        size_t operator()(const Key& k) const
+        {
+            // FNV-1a
+            uint64_t h = 1469598103934665603ULL;
+            const char* s = k.str();
+            for (size_t i = 0, n = k.len(); i < n; ++i)
+            {
+                h = (h ^ static_cast<unsigned char>(s[i])) * 1099511628211ULL;
+            }
+            return static_cast<size_t>(h);
+        }
+    };
+
+    struct Equal
+    {
+        bool operator()(const Key& a, const Key& b) const
+        {
+            return a.len() == b.len() && memcmp(a.str(), b.str(), a.len()) == 0;
+        }
+    };
+
+    size_t maxBytes_;
+    std::vector<char> arena_;
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> lengths_;
+    std::unordered_map<Key, uint32_t, Hash, Equal> index_;
+};
+
+// Stacks as a prefix tree: a node is (parent, frame), hash-consed, so a
+// stack seen a million times costs one counter increment per sample
+class StackTrie
+{
+public:
+    static const uint32_t kRoot = 0;
+
+    explicit StackTrie(size_t maxNodes) : maxNodes_(maxNodes)
+    {
+        nodes_.push_back(Node{kRoot, 0, 0});
+    }
+
+    // Child of parent for frame, or parent itself when the trie is full
+    uint32_t child(uint32_t parent, uint32_t frame, bool& truncated)
+    {
+        uint64_t key = (static_cast<uint64_t>(parent) << 32) | frame;
+        auto it = index_.find(key);
+        if (it != index_.end())
+        {
+            return it->second;
+        }
+        if (nodes_.size() >= maxNodes_)
+        {
+            truncated = true;
+            return parent;
+        }
+        uint32_t id = static_cast<uint32_t>(nodes_.size());
+        nodes_.push_back(Node{parent, frame, 0});
+        index_.emplace(key, id);
+        return id;
+    }
+
+    void count(uint32_t node) { nodes_[node].count++; }
+
+    template <typename Fn>
+    void forEachCounted(Fn fn) const
+    {
+        for (uint32_t i = 1; i < nodes_.size(); ++i)
+        {
+            if (nodes_[i].count)
+            {
+                fn(i, nodes_[i].count);
+            }
+        }
+    }
+
+    uint32_t parent(uint32_t node) const { return nodes_[node].parent; }
+    uint32_t frame(uint32_t node) const { return nodes_[node].frame; }
+    size_t size() const { return nodes_.size(); }
+    size_t bytes() const { return nodes_.capacity() * sizeof(Node) + index_.size() * 32; }
+
+private:
+    struct Node
+    {
+        uint32_t parent;
+        uint32_t frame;
+        uint64_t count;
+    };
+
+    size_t maxNodes_;
+    std::vector<Node> nodes_;
+    std::unordered_map<uint64_t, uint32_t> index_;
+};
+
+} // namespace stack_detail
+
+struct StackSamplerOptions
+{
+    bool userStacks = false;           ///< Also scan user stacks with process_vm_readv (heuristic)
+    size_t maxUserFrames = 16;
+    size_t maxFrameBytes = 4 << 20;    ///< Bound on interned frame names
+    size_t maxStackNodes = 1 << 20;    ///< Bound on distinct stack prefixes
+    unsigned refreshEvery = 100;       ///< Re-list all threads every N samples to pick up new ones
+};
+
+// System-wide sampling profiler over /proc/<pid>/task/<tid>/stack.
+//
+// Each sample() reads the kernel stack of every thread, interns frames into a
+// FrameTable and walks a StackTrie rooted at the process name, so memory is
+// bounded by the distinct stacks seen rather than the number of samples.
+// writeFolded() emits "comm;frame;frame count" lines for flamegraph.pl.
+// Reading other processes' stacks needs CAP_SYS_ADMIN (root).
+//
+// With userStacks, the thread's user pc and sp come from /proc/<tid>/syscall
+// and the top of its stack is scanned for words pointing into executable
+// mappings. That is the usual no-unwinder heuristic: cheap, but it can
+// report stale return addresses.
+class StackSampler
+{
+public:
+    explicit StackSampler(const StackSamplerOptions& options = StackSamplerOptions())
+        : options_(options), frames_(options.maxFrameBytes), stacks_(options.maxStackNodes)
+    {
+        procFd_ = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (procFd_ < 0)
+        {
+            throw std::runtime_error("StackSampler: cannot open /proc");
+        }
+    }
+
+    ~StackSampler()
+    {
+        close(procFd_);
+    }
+
+    StackSampler(const StackSampler&) = delete;
+    StackSampler& operator=(const StackSampler&) = delete;
+
+    // Sample every thread once
+    void sample()
+    {
+        processes_.update();
+        if (threads_.empty() || samples_ % options_.refreshEvery == 0)
+        {
+            refreshThreads();
+        }
+        else if (!processes_.changed().empty())
+        {
+            applyChanges();
+        }
+        for (auto& t : threads_)
+        {
+            if (t.alive)
+            {
+                sampleThread(t);
+            }
+        }
+        samples_++;
+    }
+
+    // Folded stacks ("a;b;c count"), one line per distinct stack
+    void writeFolded(std::ostream& out) const
+    {
+        std::vector<uint32_t> path;
+        stacks_.forEachCounted([&](uint32_t node, uint64_t count)
+        {
+            path.clear();
+            for (uint32_t n = node; n != stack_detail::StackTrie::kRoot; n = stacks_.parent(n))
+            {
+                path.push_back(stacks_.frame(n));
+            }
+            for (size_t i = path.size(); i-- > 0;)
+            {
+                out.write(frames_.data(path[i]), static_cast<std::streamsize>(frames_.length(path[i])));
+                out << (i ? ';' : ' ');
+            }
+            out << count << '\n';
+        });
+    }
+
+    size_t threads() const { return threads_.size(); }
+    uint64_t samples() const { return samples_; }
+    uint64_t stacksRead() const { return stacksRead_; }
+    uint64_t taskListings() const { return taskListings_; }
+    uint64_t truncated() const { return truncated_; }
+    size_t distinctFrames() const { return frames_.size(); }
+    size_t distinctStacks() const { return stacks_.size() - 1; }
+    size_t memoryBytes() const { return frames_.bytes() + stacks_.bytes() + threads_.capacity() * sizeof(Thread); }
+
+private:
+    struct Thread
+    {
+        pid_t pid;
+        pid_t tid;
+        uint32_t root;  ///< Interned process name
+        bool alive;
+    };
+
+    struct Mapping
+    {
+        uint64_t start;
+        uint64_t end;
+        uint64_t offset;
+        std::string module;
+    };
+
+    void refreshThreads()
+    {
+        threads_.clear();
+        maps_.clear();
+        for (pid_t pid : processes_.pids())
+        {
+            addThreads(pid);
+        }
+    }
+
+    // Re-list only the processes the table saw start, exit, exec or rename;
+    // thread counts of the others are picked up by the periodic refresh
+    void applyChanges()
+    {
+        changed_.assign(processes_.changed().begin(), processes_.changed().end());
+        std::sort(changed_.begin(), changed_.end());
+        changed_.erase(std::unique(changed_.begin(), changed_.end()), changed_.end());
+        threads_.erase(std::remove_if(threads_.begin(), threads_.end(), [this](const Thread& t)
+        {
+            return std::binary_search(changed_.begin(), changed_.end(), t.pid);
+        }), threads_.end());
+        for (pid_t pid : changed_)
+        {
+            maps_.erase(pid);
+            if (processes_.contains(pid))
+            {
+                addThreads(pid);
+            }
+        }
+    }
+
+    void addThreads(pid_t pid)
+    {
+        char path[64];
+        snprintf(path, sizeof(path), "%d/task", static_cast<int>(pid));
+        int fd = openat(procFd_, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return;
+        }
+        DIR* dir = fdopendir(fd);
+        if (dir == nullptr)
+        {
+            close(fd);
+            return;
+        }
+        taskListings_++;
+        const char* comm = processes_.name(pid);
+        uint32_t root = frames_.intern(comm, strlen(comm));
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr)
+        {
+            pid_t tid = procfs::parsePid(entry->d_name);
+            if (tid > 0)
+            {
+                threads_.push_back(Thread{pid, tid, root, true});
+            }
+        }
+        closedir(dir);
+        if (options_.userStacks)
+        {
+            loadMaps(pid);
+        }
+    }
+
+    void sampleThread(Thread& t)
+    {
+        char path[64];
+        snprintf(path, sizeof(path), "%d/task/%d/stack", static_cast<int>(t.pid), static_cast<int>(t.tid));
+        ssize_t n = procfs::readAt(procFd_, path, buf_, sizeof(buf_));
+        if (n < 0)
+        {
+            t.alive = false;  // exited, or no permission
+            return;
+        }
+        stacksRead_++;
+
+        bool truncated = false;
+        uint32_t node = stacks_.child(stack_detail::StackTrie::kRoot, t.root, truncated);
+        if (options_.userStacks)
+        {
+            node = appendUserFrames(t, node, truncated);
+        }
+
+        // Lines are "[<0>] func+0x1a/0x40", innermost first; the trie wants root first
+        kernelFrames_.clear();
+        const char* end = buf_ + n;
+        for (const char* p = buf_; p < end; p = procfs::nextLine(p, end))
+        {
+            const char* name = static_cast<const char*>(memchr(p, ' ', end - p));
+            if (name == nullptr)
+            {
+                break;
+            }
+            ++name;
+            const char* stop = name;
+            while (stop < end && *stop != '+' && *stop != '\n')
+            {
+                ++stop;
+            }
+            kernelFrames_.push_back(std::make_pair(name, stop));
+        }
+        for (size_t i = kernelFrames_.size(); i-- > 0;)
+        {
+            char sym[128];
+            size_t len = std::min<size_t>(kernelFrames_[i].second - kernelFrames_[i].first, sizeof(sym) - 4);
+            memcpy(sym, kernelFrames_[i].first, len);
+            memcpy(sym + len, "_[k]", 4);
+            node = stacks_.child(node, frames_.intern(sym, len + 4), truncated);
+        }
+        stacks_.count(node);
+        truncated_ += truncated;
+    }
+
+    uint32_t appendUserFrames(const Thread& t, uint32_t node, bool& truncated)
+    {
+        // "nr args... sp pc", "-1 sp pc", or "running"
+        char path[64];
+        char line[256];
+        snprintf(path, sizeof(path), "%d/task/%d/syscall", static_cast<int>(t.pid), static_cast<int>(t.tid));
+        ssize_t n = procfs::readAt(procFd_, path, line, sizeof(line) - 1);
+        if (n <= 0 || line[0] == 'r')
+        {
+            return node;
+        }
+        line[n] = '\0';
+        uint64_t words[8];
+        int count = 0;
+        for (char* p = line; count < 8 && *p;)
+        {
+            char* next;
+            words[count++] = strtoull(p, &next, 0);
+            if (next == p)
+            {
+                break;
+            }
+            p = next;
+        }
+        if (count < 3)
+        {
+            return node;
+        }
+        uint64_t sp = words[count - 2];
+        uint64_t pc = words[count - 1];
+
+        auto maps = maps_.find(t.pid);
+        if (maps == maps_.end())
+        {
+            return node;
+        }
+
+        userFrames_.clear();
+        userFrames_.push_back(pc);
+        uint64_t stack[512];
+        struct iovec local = {stack, sizeof(stack)};
+        struct iovec remote = {reinterpret_cast<void*>(sp), sizeof(stack)};
+        ssize_t got = process_vm_readv(t.pid, &local, 1, &remote, 1, 0);
+        for (ssize_t i = 0; i < got / 8 && userFrames_.size() < options_.maxUserFrames; ++i)
+        {
+            if (findMapping(maps->second, stack[i]))
+            {
+                userFrames_.push_back(stack[i]);
+            }
+        }
+        // Scanned words run innermost to outermost
+        for (size_t i = userFrames_.size(); i-- > 0;)
+        {
+            const Mapping* m = findMapping(maps->second, userFrames_[i]);
+            if (m == nullptr)
+            {
+                continue;
+            }
+            char sym[256];
+            int len = snprintf(sym, sizeof(sym), "%s+0x%llx", m->module.c_str(),
+                               static_cast<unsigned long long>(userFrames_[i] - m->start + m->offset));
+            len = std::min<int>(len, sizeof(sym) - 1);
+            node = stacks_.child(node, frames_.intern(sym, static_cast<size_t>(len)), truncated);
+        }
+        return node;
+    }
+
+    static const Mapping* findMapping(const std::vector<Mapping>& maps, uint64_t addr)
+    {
+        auto it = std::upper_bound(maps.begin(), maps.end(), addr,
+                                   [](uint64_t a, const Mapping& m) { return a < m.start; });
+        if (it == maps.begin())
+        {
+            return nullptr;
+        }
+        --it;
+        return addr < it->end ? &*it : nullptr;
+    }
+
+    // Executable mappings of pid, sorted by address
+    void loadMaps(pid_t pid)
+    {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/maps", static_cast<int>(pid));
+        FILE* f = fopen(path, "re");
+        if (f == nullptr)
+        {
+            return;
+        }
+        std::vector<Mapping>& maps = maps_[pid];
+        char line[512];
+        while (fgets(line, sizeof(line), f))
+        {
+            unsigned long long start, end, offset;
+            char perms[8];
+            int nameAt = 0;
+            if (sscanf(line, "%llx-%llx %7s %llx %*s %*s %n", &start, &end, perms, &offset, &nameAt) < 4 ||
+                perms[2] != 'x')
+            {
+                continue;
+            }
+            std::string module = nameAt ? line + nameAt : "";
+            module.erase(module.find_last_not_of("\n ") + 1);
+            module = module.empty() ? "[anon]" : module.substr(module.rfind('/') + 1);
+            maps.push_back(Mapping{start, end, offset, module});
+        }
+        fclose(f);
+        std::sort(maps.begin(), maps.end(), [](const Mapping& a, const Mapping& b) { return a.start < b.start; });
+    }
+
+    StackSamplerOptions options_;
+    int procFd_ = -1;
+    ProcessTable processes_;
+    stack_detail::FrameTable frames_;
+    stack_detail::StackTrie stacks_;
+    std::vector<Thread> threads_;
+    std::unordered_map<pid_t, std::vector<Mapping>> maps_;
+    std::vector<pid_t> changed_;
+    std::vector<std::pair<const char*, const char*>> kernelFrames_;
+    std::vector<uint64_t> userFrames_;
+    char buf_[8192];
+    uint64_t samples_ = 0;
+    uint64_t stacksRead_ = 0;
+    uint64_t taskListings_ = 0;
+    uint64_t truncated_ = 0;
+};
@@ -0,0 +1,452 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+// Dynamic bitset backed by 64-bit words
+class BitVector
+{
+public:
+    BitVector() = default;
+
+    explicit BitVector(uint64_t nbits, bool value = false)
+    {
+        resize(nbits, value);
+    }
+
+    void resize(uint64_t nbits, bool value = false)
+    {
+        uint64_t old = size_;
+        words_.resize((nbits + 63) / 64, value ? ~0ULL : 0ULL);
+        size_ = nbits;
+        if (value && old < nbits && old % 64 != 0)
+        {
+            words_[old / 64] |= ~0ULL << (old % 64);
+        }
+        clearTail();
+    }
+
+    void set(uint64_t i)   { words_[i >> 6] |=  (1ULL << (i & 63)); }
+    void reset(uint64_t i) { words_[i >> 6] &= ~(1ULL << (i & 63)); }
+    void flip(uint64_t i)  { words_[i >> 6] ^=  (1ULL << (i & 63)); }
+
+    bool test(uint64_t i) const
+    {
+        return (words_[i >> 6] >> (i & 63)) & 1ULL;
+    }
+
+    void push_back(bool value)
+    {
+        if (size_ % 64 == 0)
+        {
+            words_.push_back(0);
+        }
+        if (value)
+        {
+            words_[size_ >> 6] |= 1ULL << (size_ & 63);
+        }
+        ++size_;
+    }
+
+    uint64_t count() const
+    {
+        uint64_t n = 0;
+        for (uint64_t w : words_)
+        {
+            n += __builtin_popcountll(w);
+        }
+        return n;
+    }
+
+    uint64_t size() const { return size_; }
+    const uint64_t* data() const { return words_.data(); }
+    uint64_t* data() { return words_.data(); }
+    size_t wordCount() const { return words_.size(); }
+
+private:
+    // Keep the bits past size() zero so popcounts over whole words stay exact
+    void clearTail()
+    {
+        if (size_ % 64 != 0)
+        {
+            words_.back() &= (1ULL << (size_ % 64)) - 1;
+        }
+    }
+
+    std::vector<uint64_t> words_;
+    uint64_t size_ = 0;
+};
+
+// Position of the k-th (0-based) set bit inside a 64-bit word
+inline unsigned select64(uint64_t word, unsigned k)
+{
+#if defined(__BMI2__)
+    return __builtin_ctzll(_pdep_u64(1ULL << k, word));
+#else
+    for (unsigned i = 0; i < k; ++i)
+    {
+        word &= word - 1;
+    }
+    return __builtin_ctzll(word);
+#endif
+}
+
+// Immutable rank/select index over a bit vector.
+//
+// Layout follows the "poppy" scheme: one 64-bit entry per 2048-bit superblock
+// holding a 32-bit cumulative count plus three 10-bit counts of its 512-bit
+// blocks, a 64-bit absolute count every 2^32 bits, and a sample of the
+// superblock holding every 8192nd set bit for select. Overhead is ~3.2%.
+//
+// All sections live in one contiguous image so the structure can be written
+// with save() and memory-mapped back with map() without any rebuilding.
+class RankSelect
+{
+public:
+    static const uint64_t kSuperBits = 2048;
+    static const uint64_t kBlockBits = 512;
+    static const uint64_t kSelectSample = 8192;
+    static const uint64_t kMagic = 0x3153524B4E415231ULL; // "1RANKRS1"
+
+    RankSelect() = default;
+
+    explicit RankSelect(const BitVector& bits)
+    {
+        build(bits.data(), bits.size());
+    }
+
+    RankSelect(const uint64_t* words, uint64_t nbits)
+    {
+        build(words, nbits);
+    }
+
+    ~RankSelect()
+    {
+        unmap();
+    }
+
+    RankSelect(RankSelect&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    RankSelect& operator=(RankSelect&& other) noexcept
+    {
+        if (this != &other)
+        {
+            unmap();
+            image_ = std::move(other.image_);
+            mapped_ = other.mapped_;
+            mappedLen_ = other.mappedLen_;
+            other.mapped_ = nullptr;
+            other.mappedLen_ = 0;
+            attach(mapped_ ? static_cast<const uint64_t*>(mapped_) : image_.data());
+        }
+        return *this;
+    }
+
+    RankSelect(const RankSelect&) = delete;
+    RankSelect& operator=(const RankSelect&) = delete;
+
+    uint64_t size() const { return hdr_ ? hdr_->nbits : 0; }
+    uint64_t ones() const { return hdr_ ? hdr_->nones : 0; }
+
+    bool test(uint64_t i) const
+    {
+        return (bits_[i >> 6] >> (i & 63)) & 1ULL;
+    }
+
+    // Number of set bits in [0, i)
+    uint64_t rank1(uint64_t i) const
+    {
+        uint64_t sb = i / kSuperBits;
+        uint64_t entry = l12_[sb];
+        uint64_t r = l0_[i >> 32] + (entry & 0xFFFFFFFFULL);
+
+        unsigned blk = (i / kBlockBits) & 3;
+        for (unsigned k = 0; k < blk; ++k)
+        {
+            r += (entry >> (32 + 10 * k)) & 0x3FF;
+        }
+
+        uint64_t w = (sb * kSuperBits + blk * kBlockBits) / 64;
+        uint64_t end = i >> 6;
+        for (; w < end; ++w)
+        {
+            r += __builtin_popcountll(bits_[w]);
+        }
+        if (i & 63)
+        {
+            r += __builtin_popcountll(bits_[end] & ((1ULL << (i & 63)) - 1));
+        }
+        return r;
+    }
+
+    // Number of clear bits in [0, i)
+    uint64_t rank0(uint64_t i) const
+    {
+        return i - rank1(i);
+    }
+
+    // Position of the k-th (0-based) set bit; k must be < ones()
+    uint64_t select1(uint64_t k) const
+    {
+        // Narrow the superblock range with the sampled positions, then binary search
+        uint64_t lo = samples_[k / kSelectSample];
+        uint64_t hi = (k / kSelectSample + 1 < hdr_->nsamples) ? samples_[k / kSelectSample + 1] + 1 : hdr_->nsuper;
+        hi = std::min<uint64_t>(std::max<uint64_t>(hi, lo + 1), hdr_->nsuper);
+        while (hi - lo > 1)
+        {
+            uint64_t mid = lo + (hi - lo) / 2;
+            if (superRank(mid) <= k)
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+
+        uint64_t entry = l12_[lo];
+        uint64_t rem = k - superRank(lo);
+        uint64_t w = lo * kSuperBits / 64;
+        for (unsigned blk = 0; blk < 3; ++blk)
+        {
+            uint64_t c = (entry >> (32 + 10 * blk)) & 0x3FF;
+            if (rem < c)
+            {
+                break;
+            }
+            rem -= c;
+            w += kBlockBits / 64;
+        }
+
+        for (;; ++w)
+        {
+            uint64_t c = __builtin_popcountll(bits_[w]);
+            if (rem < c)
+            {
+                return w * 64 + select64(bits_[w], static_cast<unsigned>(rem));
+            }
+            rem -= c;
+        }
+    }
+
+    // Bytes used by the index on top of the raw bits
+    size_t overheadBytes() const
+    {
+        return byteSize() - sizeof(Header) - hdr_->nwords * sizeof(uint64_t);
+    }
+
+    // Total image size in bytes
+    size_t byteSize() const
+    {
+        return hdr_ ? hdr_->totalWords * sizeof(uint64_t) : 0;
+    }
+
+    // Write the image to disk so it can later be map()ped
+    bool save(const std::string& path) const
+    {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+        {
+            return false;
+        }
+        const char* p = reinterpret_cast<const char*>(hdr_);
+        size_t left = byteSize();
+        while (left > 0)
+        {
+            ssize_t n = ::write(fd, p, left);
+            if (n <= 0)
+            {
+                ::close(fd);
+                return false;
+            }
+            p += n;
+            left -= static_cast<size_t>(n);
+        }
+        return ::close(fd) == 0;
+    }
+
+    // Map a previously saved image read-only; throws std::runtime_error on failure
+    static RankSelect map(const std::string& path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("RankSelect: cannot open " + path);
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header))
+        {
+            ::close(fd);
+            throw std::runtime_error("RankSelect: bad image " + path);
+        }
+        void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED)
+        {
+            throw std::runtime_error("RankSelect: mmap failed for " + path);
+        }
+
+        const Header* h = static_cast<const Header*>(p);
+        if (h->magic != kMagic || h->totalWords * sizeof(uint64_t) != static_cast<uint64_t>(st.st_size))
+        {
+            munmap(p, st.st_size);
+            throw std::runtime_error("RankSelect: corrupt image " + path);
+        }
+
+        RankSelect rs;
+        rs.mapped_ = p;
+        rs.mappedLen_ = st.st_size;
+        rs.attach(static_cast<const uint64_t*>(p));
+        return rs;
+    }
+
+private:
+    struct Header
+    {
+        uint64_t magic;
+        uint64_t nbits;
+        uint64_t nones;
+        uint64_t nwords;
+        uint64_t nsuper;
+        uint64_t nl0;
+        uint64_t nsamples;
+        uint64_t totalWords;
+    };
+
+    uint64_t superRank(uint64_t sb) const
+    {
+        return l0_[(sb * kSuperBits) >> 32] + (l12_[sb] & 0xFFFFFFFFULL);
+    }
+
+    void build(const uint64_t* words, uint64_t nbits)
+    {
+        uint64_t nwords = (nbits + 63) / 64;
+        // One spare superblock entry keeps rank1(size()) in bounds
+        uint64_t nsuper = nbits / kSuperBits + 1;
+        uint64_t nl0 = (nbits >> 32) + 1;
+
+        uint64_t ones = 0;
+        for (uint64_t i = 0; i < nwords; ++i)
+        {
+            ones += __builtin_popcountll(words[i]);
+        }
+        // One sample per started group of kSelectSample ones, so every
+        // sample is written (a trailing one past the last set bit would stay 0)
+        uint64_t nsamples = ones == 0 ? 1 : (ones + kSelectSample - 1) / kSelectSample;
+
+        // Bits are padded to a whole superblock so the scans never run off the end
+        uint64_t paddedWords = nsuper * kSuperBits / 64;
+        uint64_t headerWords = sizeof(Header) / sizeof(uint64_t);
+        uint64_t total = headerWords + paddedWords + nl0 + nsuper + (nsamples + 1) / 2;
+        image_.assign(total, 0);
+
+        Header* h = reinterpret_cast<Header*>(image_.data());
+        h->magic = kMagic;
+        h->nbits = nbits;
+        h->nones = ones;
+        h->nwords = paddedWords;
+        h->nsuper = nsuper;
+        h->nl0 = nl0;
+        h->nsamples = nsamples;
+        h->totalWords = total;
+        attach(image_.data());
+
+        uint64_t* bits = const_cast<uint64_t*>(bits_);
+        uint64_t* l0 = const_cast<uint64_t*>(l0_);
+        uint64_t* l12 = const_cast<uint64_t*>(l12_);
+        uint32_t* samples = const_cast<uint32_t*>(samples_);
+
+        if (nwords > 0)
+        {
+            std::memcpy(bits, words, nwords * sizeof(uint64_t));
+            if (nbits % 64 != 0)
+            {
+                bits[nwords - 1] &= (1ULL << (nbits % 64)) - 1;
+            }
+        }
+
+        uint64_t cum = 0;
+        uint64_t nextSample = 0;
+        for (uint64_t sb = 0; sb < nsuper; ++sb)
+        {
+            uint64_t bitPos = sb * kSuperBits;
+            if ((bitPos & 0xFFFFFFFFULL) == 0)
+            {
+                l0[bitPos >> 32] = cum;
+            }
+            uint64_t entry = cum - l0[bitPos >> 32];
+
+            uint64_t sbOnes = 0;
+            for (unsigned blk = 0; blk < 4; ++blk)
+            {
+                uint64_t c = 0;
+                for (uint64_t w = 0; w < kBlockBits / 64; ++w)
+                {
+                    c += __builtin_popcountll(bits[(bitPos + blk * kBlockBits) / 64 + w]);
+                }
+                if (blk < 3)
+                {
+                    entry |= c << (32 + 10 * blk);
+                }
+                sbOnes += c;
+            }
+            l12[sb] = entry;
+
+            while (nextSample < nsamples && nextSample * kSelectSample < cum + sbOnes)
+            {
+                samples[nextSample++] = static_cast<uint32_t>(sb);
+            }
+            cum += sbOnes;
+        }
+    }
+
+    void attach(const uint64_t* base)
+    {
+        if (base == nullptr)
+        {
+            hdr_ = nullptr;
+            return;
+        }
+        hdr_ = reinterpret_cast<const Header*>(base);
+        bits_ = base + sizeof(Header) / sizeof(uint64_t);
+        l0_ = bits_ + hdr_->nwords;
+        l12_ = l0_ + hdr_->nl0;
+        samples_ = reinterpret_cast<const uint32_t*>(l12_ + hdr_->nsuper);
+    }
+
+    void unmap()
+    {
+        if (mapped_)
+        {
+            munmap(mapped_, mappedLen_);
+            mapped_ = nullptr;
+            mappedLen_ = 0;
+        }
+    }
+
+    std::vector<uint64_t> image_;
+    void* mapped_ = nullptr;
+    size_t mappedLen_ = 0;
+
+    const Header* hdr_ = nullptr;
+    const uint64_t* bits_ = nullptr;
+    const uint64_t* l0_ = nullptr;
+    const uint64_t* l12_ = nullptr;
+    const uint32_t* samples_ = nullptr;
+};
@@ -0,0 +1,139 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include "SuccinctBitset.hpp"
+
+// Compile: g++ -std=c++17 -O2 -march=native -o SuccinctBitsetDemo SuccinctBitsetDemo.cpp
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t nbits = argc > 1 ? std::stoull(argv[1]) : 100000000ULL;
+    const int queries = 10000000;
+
+    std::mt19937_64 rng(42);
+    BitVector bits(nbits);
+    std::vector<bool> reference(nbits);
+    for (uint64_t i = 0; i < nbits; ++i)
+    {
+        if ((rng() & 7) == 0)
+        {
+            bits.set(i);
+            reference[i] = true;
+        }
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    RankSelect rs(bits);
+    std::cout << "Built index over " << nbits << " bits (" << rs.ones() << " set) in "
+              << secondsSince(t0) << " s" << std::endl;
+    std::cout << "Index overhead: " << 100.0 * rs.overheadBytes() / ((nbits + 7) / 8) << "%" << std::endl;
+
+    // Spot-check rank and select against a naive scan
+    uint64_t running = 0;
+    for (uint64_t i = 0; i < nbits && i < 1000000; ++i)
+    {
+        if (rs.rank1(i) != running)
+        {
+            std::cerr << "rank1 mismatch at " << i << std::endl;
+            return 1;
+        }
+        if (reference[i])
+        {
+            if (rs.select1(running) != i)
+            {
+                std::cerr << "select1 mismatch for k=" << running << std::endl;
+                return 1;
+            }
+            ++running;
+        }
+    }
+    if (rs.rank1(nbits) != rs.ones())
+    {
+        std::cerr << "rank1(size) mismatch" << std::endl;
+        return 1;
+    }
+    // Boundary: the number of set bits is an exact multiple of the select sample rate
+    for (uint64_t count : {RankSelect::kSelectSample, 2 * RankSelect::kSelectSample})
+    {
+        BitVector run(200000);
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            run.set(50000 + i);
+        }
+        RankSelect runIndex(run);
+        for (uint64_t k = 0; k < count; ++k)
+        {
+            if (runIndex.select1(k) != 50000 + k)
+            {
+                std::cerr << "select1 mismatch for k=" << k << " with " << count << " set" << std::endl;
+                return 1;
+            }
+        }
+    }
+    std::cout << "Rank/select verified" << std::endl;
+
+    std::vector<uint64_t> positions(queries);
+    for (auto& p : positions)
+    {
+        p = rng() % nbits;
+    }
+
+    uint64_t sink = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (uint64_t p : positions)
+    {
+        sink += rs.rank1(p);
+    }
+    std::cout << "rank1:   " << secondsSince(t0) * 1e9 / queries << " ns/op" << std::endl;
+
+    t0 = std::chrono::steady_clock::now();
+    for (uint64_t p : positions)
+    {
+        sink += rs.select1(p % rs.ones());
+    }
+    std::cout << "select1: " << secondsSince(t0) * 1e9 / queries << " ns/op" << std::endl;
+
+    t0 = std::chrono::steady_clock::now();
+    for (uint64_t p : positions)
+    {
+        sink += rs.test(p);
+    }
+    std::cout << "test (RankSelect):       " << secondsSince(t0) * 1e9 / queries << " ns/op" << std::endl;
+
+    t0 = std::chrono::steady_clock::now();
+    for (uint64_t p : positions)
+    {
+        sink += reference[p];
+    }
+    std::cout << "test (std::vector<bool>): " << secondsSince(t0) * 1e9 / queries << " ns/op" << std::endl;
+
+    // Round-trip through a memory-mapped image
+    const std::string path = "rankselect.img";
+    if (!rs.save(path))
+    {
+        std::cerr << "Failed to save " << path << std::endl;
+        return 1;
+    }
+    RankSelect mapped = RankSelect::map(path);
+    for (int i = 0; i < 1000; ++i)
+    {
+        uint64_t p = positions[i];
+        if (mapped.rank1(p) != rs.rank1(p))
+        {
+            std::cerr << "Mapped image mismatch" << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "Mapped image verified (" << mapped.byteSize() << " bytes)" << std::endl;
+    std::remove(path.c_str());
+
+    std::cout << "checksum " << sink << std::endl;
+    return 0;
+}
@@ -0,0 +1,330 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include "EventLoop.hpp"
+
+extern char** environ;
+
+struct ServiceSpec
+{
+    std::string name;
+    std::vector<std::string> argv;                                  ///< argv[0] is looked up in PATH
+    std::chrono::milliseconds minBackoff = std::chrono::milliseconds(100);
+    std::chrono::milliseconds maxBackoff = std::chrono::seconds(30);
+    std::chrono::milliseconds stableAfter = std::chrono::seconds(10); ///< Uptime that resets the backoff
+};
+
+// Keeps a set of services running from one EventLoop.
+//
+// Children are started with posix_spawnp() and watched through a pidfd
+// registered in epoll, so an exit is seen as soon as the kernel reaps it and
+// nothing polls while services are healthy. The first restart after a stable
+// run is immediate; repeated quick failures back off exponentially up to
+// maxBackoff. Kernels without pidfd_open (< 5.3) fall back to SIGCHLD.
+class Supervisor
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    enum class Event
+    {
+        Started,
+        Exited,
+        SpawnFailed
+    };
+
+    // Called for every lifecycle change; status is the waitpid() status for
+    // Exited, or -1 when the child was reaped elsewhere (SIGCHLD ignored, or
+    // another waitpid(-1) in the process) and its status is lost
+    typedef std::function<void(const ServiceSpec& spec, Event event, pid_t pid, int status)> Listener;
+
+    explicit Supervisor(EventLoop& loop) : loop_(loop)
+    {
+    }
+
+    ~Supervisor()
+    {
+        for (auto& s : services_)
+        {
+            if (s.pidfd >= 0)
+            {
+                loop_.removeFd(s.pidfd);
+                close(s.pidfd);
+            }
+        }
+    }
+
+    Supervisor(const Supervisor&) = delete;
+    Supervisor& operator=(const Supervisor&) = delete;
+
+    void setListener(Listener listener) { listener_ = std::move(listener); }
+
+    void add(const ServiceSpec& spec)
+    {
+        services_.push_back(Service());
+        services_.back().spec = spec;
+    }
+
+    // Load services from a file of "name: command args..." lines ('#' comments)
+    bool loadConfig(const std::string& path)
+    {
+        std::ifstream in(path);
+        if (!in)
+        {
+            perror(("Supervisor: " + path).c_str());
+            return false;
+        }
+        std::string line;
+        while (std::getline(in, line))
+        {
+            line = line.substr(0, line.find('#'));
+            size_t colon = line.find(':');
+            if (colon == std::string::npos)
+            {
+                continue;
+            }
+            ServiceSpec spec;
+            std::istringstream name(line.substr(0, colon));
+            name >> spec.name;
+            std::istringstream args(line.substr(colon + 1));
+            std::string arg;
+            while (args >> arg)
+            {
+                spec.argv.push_back(arg);
+            }
+            if (!spec.name.empty() && !spec.argv.empty())
+            {
+                add(spec);
+            }
+        }
+        return true;
+    }
+
+    // Launch every service; call once from the loop thread before run()
+    void start()
+    {
+        for (size_t i = 0; i < services_.size(); ++i)
+        {
+            spawn(i);
+        }
+    }
+
+    // Send SIGTERM to every child, SIGKILL after grace, and stop the loop
+    // once all of them have exited
+    void shutdown(std::chrono::milliseconds grace = std::chrono::seconds(5))
+    {
+        stopping_ = true;
+        for (auto& s : services_)
+        {
+            if (s.restartTimer >= 0)
+            {
+                loop_.cancelTimer(s.restartTimer);
+                s.restartTimer = -1;
+            }
+            if (s.pid > 0)
+            {
+                kill(s.pid, SIGTERM);
+            }
+        }
+        loop_.addTimer(grace, std::chrono::nanoseconds(0), [this]()
+        {
+            for (auto& s : services_)
+            {
+                if (s.pid > 0)
+                {
+                    kill(s.pid, SIGKILL);
+                }
+            }
+        });
+        stopIfIdle();
+    }
+
+    size_t running() const
+    {
+        return static_cast<size_t>(std::count_if(services_.begin(), services_.end(),
+                                                 [](const Service& s) { return s.pid > 0; }));
+    }
+
+    // Restarts performed for a service so far
+    unsigned restarts(const std::string& name) const
+    {
+        for (const auto& s : services_)
+        {
+            if (s.spec.name == name)
+            {
+                return s.restarts;
+            }
+        }
+        return 0;
+    }
+
+private:
+    struct Service
+    {
+        ServiceSpec spec;
+        pid_t pid = -1;
+        int pidfd = -1;
+        int restartTimer = -1;
+        unsigned failures = 0;   ///< Consecutive quick exits, drives the backoff
+        unsigned restarts = 0;
+        Clock::time_point startedAt;
+    };
+
+    void notify(const Service& s, Event e, pid_t pid, int status)
+    {
+        if (listener_)
+        {
+            listener_(s.spec, e, pid, status);
+        }
+    }
+
+    void spawn(size_t i)
+    {
+        Service& s = services_[i];
+        s.restartTimer = -1;
+
+        std::vector<char*> argv;
+        for (auto& a : s.spec.argv)
+        {
+            argv.push_back(const_cast<char*>(a.c_str()));
+        }
+        argv.push_back(nullptr);
+
+        // Children must not inherit signals the loop has blocked for signalfd
+        posix_spawnattr_t attr;
+        posix_spawnattr_init(&attr);
+        sigset_t empty;
+        sigemptyset(&empty);
+        posix_spawnattr_setsigmask(&attr, &empty);
+        posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+
+        pid_t pid;
+        int rc = posix_spawnp(&pid, argv[0], nullptr, &attr, argv.data(), environ);
+        posix_spawnattr_destroy(&attr);
+        if (rc != 0)
+        {
+            notify(s, Event::SpawnFailed, -1, rc);
+            scheduleRestart(i);
+            return;
+        }
+
+        s.pid = pid;
+        s.startedAt = Clock::now();
+        notify(s, Event::Started, pid, 0);
+
+        s.pidfd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+        if (s.pidfd >= 0)
+        {
+            loop_.addFd(s.pidfd, EPOLLIN, [this, i](uint32_t) { reap(i); });
+        }
+        else
+        {
+            watchSigchld();
+            reap(i); // it may have exited before SIGCHLD was routed to the loop
+        }
+    }
+
+    // Collect the exit status of service i if its child has terminated
+    void reap(size_t i)
+    {
+        Service& s = services_[i];
+        int status = -1;
+        if (s.pid <= 0)
+        {
+            return;
+        }
+        pid_t rc = waitpid(s.pid, &status, WNOHANG);
+        if (rc == 0 || (rc < 0 && errno != ECHILD))
+        {
+            return;
+        }
+        if (rc < 0)
+        {
+            status = -1; // already reaped by someone else; it is gone all the same
+        }
+        if (s.pidfd >= 0)
+        {
+            loop_.removeFd(s.pidfd);
+            close(s.pidfd);
+            s.pidfd = -1;
+        }
+        pid_t pid = s.pid;
+        s.pid = -1;
+        notify(s, Event::Exited, pid, status);
+
+        if (stopping_)
+        {
+            stopIfIdle();
+            return;
+        }
+        if (Clock::now() - s.startedAt >= s.spec.stableAfter)
+        {
+            s.failures = 0;
+        }
+        scheduleRestart(i);
+    }
+
+    void scheduleRestart(size_t i)
+    {
+        Service& s = services_[i];
+        std::chrono::milliseconds delay(0);
+        if (s.failures > 0)
+        {
+            int shift = static_cast<int>(std::min(s.failures - 1, 20u));
+            delay = std::min<std::chrono::milliseconds>(s.spec.minBackoff * (1LL << shift), s.spec.maxBackoff);
+        }
+        s.failures++;
+        s.restartTimer = loop_.addTimer(delay, std::chrono::nanoseconds(0), [this, i]()
+        {
+            services_[i].restarts++;
+            spawn(i);
+        });
+    }
+
+    void watchSigchld()
+    {
+        if (sigchldWatched_)
+        {
+            return;
+        }
+        sigchldWatched_ = true;
+        loop_.addSignal(SIGCHLD, [this](const struct signalfd_siginfo&)
+        {
+            for (size_t i = 0; i < services_.size(); ++i)
+            {
+                if (services_[i].pidfd < 0)
+                {
+                    reap(i);
+                }
+            }
+        });
+    }
+
+    void stopIfIdle()
+    {
+        if (stopping_ && running() == 0)
+        {
+            loop_.stop();
+        }
+    }
+
+    EventLoop& loop_;
+    std::vector<Service> services_;
+    Listener listener_;
+    bool stopping_ = false;
+    bool sigchldWatched_ = false;
+};
@@ -0,0 +1,367 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+// Hierarchical timing wheel driving any number of timers from one thread.
+//
+// Four levels of 256 slots cover 2^32 ticks. Timers live in a slab and are
+// linked into their slot with index-based intrusive lists, so schedule() and
+// cancel() are O(1). Expired callbacks run on a small executor pool (or on the
+// wheel thread itself when the pool size is 0).
+class TimerWheel
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef uint64_t TimerId;
+    static const TimerId kInvalidTimer = 0;
+
+    explicit TimerWheel(std::chrono::nanoseconds tick = std::chrono::milliseconds(1), size_t workers = 1)
+        : tick_(tick), workerCount_(workers), running_(false)
+    {
+        for (auto& h : heads_)
+        {
+            h = kNil;
+        }
+    }
+
+    ~TimerWheel()
+    {
+        stop();
+    }
+
+    void start()
+    {
+        if (running_.exchange(true))
+        {
+            return;
+        }
+        for (size_t i = 0; i < workerCount_; ++i)
+        {
+            workers_.emplace_back([this]() { workerLoop(); });
+        }
+        ticker_ = std::thread([this]() { tickLoop(); });
+    }
+
+    void stop()
+    {
+        {
+            // Cleared under the queue lock so a worker between checking its
+            // wait predicate and blocking cannot miss the wakeup
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            if (!running_.exchange(false))
+            {
+                return;
+            }
+        }
+        queueCv_.notify_all();
+        if (ticker_.joinable())
+        {
+            ticker_.join();
+        }
+        for (auto& w : workers_)
+        {
+            w.join();
+        }
+        workers_.clear();
+    }
+
+    // Run callback once after delay, then every period if period is non-zero
+    template <typename Rep, typename Period>
+    TimerId schedule(std::chrono::duration<Rep, Period> delay, std::function<void()> callback,
+                     std::chrono::nanoseconds period = std::chrono::nanoseconds::zero())
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t ticks = toTicks(Clock::now() + delay);
+        uint32_t idx = allocNode();
+        Node& n = nodes_[idx];
+        n.expiry = ticks > now_ ? ticks : now_ + 1;
+        n.period = period.count() > 0 ? std::max<uint64_t>(1, (period + tick_ - std::chrono::nanoseconds(1)) / tick_) : 0;
+        n.callback = std::move(callback);
+        insert(idx);
+        ++active_;
+        return makeId(idx, n.generation);
+    }
+
+    // Cancel a pending timer; returns false if it already fired or was cancelled
+    bool cancel(TimerId id)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint32_t idx = static_cast<uint32_t>(id & 0xFFFFFFFFULL) - 1;
+        if (id == kInvalidTimer || idx >= nodes_.size())
+        {
+            return false;
+        }
+        Node& n = nodes_[idx];
+        if (n.generation != static_cast<uint32_t>(id >> 32) || n.slot == kNil)
+        {
+            return false;
+        }
+        unlink(idx);
+        freeNode(idx);
+        --active_;
+        return true;
+    }
+
+    size_t active() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return active_;
+    }
+
+    std::chrono::nanoseconds tick() const { return tick_; }
+
+    // Absolute time at which a tick number is due
+    Clock::time_point tickTime(uint64_t ticks) const
+    {
+        return origin_ + tick_ * ticks;
+    }
+
+private:
+    static const uint32_t kNil = 0xFFFFFFFFu;
+    static const unsigned kLevels = 4;
+    static const unsigned kSlotBits = 8;
+    static const unsigned kSlots = 1u << kSlotBits;
+
+    struct Node
+    {
+        uint64_t expiry = 0;
+        uint64_t period = 0;
+        std::function<void()> callback;
+        uint32_t prev = kNil;
+        uint32_t next = kNil;
+        uint32_t slot = kNil;
+        uint32_t generation = 1;
+    };
+
+    static TimerId makeId(uint32_t idx, uint32_t generation)
+    {
+        return (static_cast<uint64_t>(generation) << 32) | (idx + 1);
+    }
+
+    uint64_t toTicks(Clock::time_point t) const
+    {
+        auto d = t - origin_;
+        return d.count() <= 0 ? 0 : static_cast<uint64_t>((d + tick_ - Clock::duration(1)) / tick_);
+    }
+
+    // Last tick that has fully elapsed at time t
+    uint64_t elapsedTicks(Clock::time_point t) const
+    {
+        auto d = t - origin_;
+        return d.count() <= 0 ? 0 : static_cast<uint64_t>(d / tick_);
+    }
+
+    uint32_t allocNode()
+    {
+        if (!freeList_.empty())
+        {
+            uint32_t idx = freeList_.back();
+            freeList_.pop_back();
+            return idx;
+        }
+        nodes_.emplace_back();
+        return static_cast<uint32_t>(nodes_.size() - 1);
+    }
+
+    void freeNode(uint32_t idx)
+    {
+        Node& n = nodes_[idx];
+        n.callback = nullptr;
+        n.generation++;
+        n.slot = kNil;
+        freeList_.push_back(idx);
+    }
+
+    // Link a node into the slot matching its distance from the current tick
+    void insert(uint32_t idx)
+    {
+        Node& n = nodes_[idx];
+        uint64_t delta = n.expiry - now_;
+        unsigned level = 0;
+        while (level + 1 < kLevels && delta >= (1ULL << (kSlotBits * (level + 1))))
+        {
+            ++level;
+        }
+        // Timers beyond the wheel's span park in the top level and re-cascade
+        uint64_t when = level == kLevels - 1 && delta >= (1ULL << (kSlotBits * kLevels)) ? now_ + (1ULL << (kSlotBits * kLevels)) - 1 : n.expiry;
+        uint32_t slot = level * kSlots + static_cast<uint32_t>((when >> (kSlotBits * level)) & (kSlots - 1));
+
+        n.slot = slot;
+        n.prev = kNil;
+        n.next = heads_[slot];
+        if (n.next != kNil)
+        {
+            nodes_[n.next].prev = idx;
+        }
+        heads_[slot] = idx;
+    }
+
+    void unlink(uint32_t idx)
+    {
+        Node& n = nodes_[idx];
+        if (n.prev != kNil)
+        {
+            nodes_[n.prev].next = n.next;
+        }
+        else
+        {
+            heads_[n.slot] = n.next;
+        }
+        if (n.next != kNil)
+        {
+            nodes_[n.next].prev = n.prev;
+        }
+        n.prev = n.next = n.slot = kNil;
+    }
+
+    // Detach a whole slot and return its first node
+    uint32_t takeSlot(uint32_t slot)
+    {
+        uint32_t head = heads_[slot];
+        heads_[slot] = kNil;
+        return head;
+    }
+
+    // Advance one tick, cascading higher levels and collecting due callbacks
+    void advance(std::vector<std::function<void()>>& due)
+    {
+        ++now_;
+        for (unsigned level = 1; level < kLevels; ++level)
+        {
+            if ((now_ & ((1ULL << (kSlotBits * level)) - 1)) != 0)
+            {
+                break;
+            }
+            uint32_t slot = level * kSlots + static_cast<uint32_t>((now_ >> (kSlotBits * level)) & (kSlots - 1));
+            for (uint32_t idx = takeSlot(slot); idx != kNil;)
+            {
+                uint32_t next = nodes_[idx].next;
+                insert(idx);
+                idx = next;
+            }
+        }
+
+        for (uint32_t idx = takeSlot(static_cast<uint32_t>(now_ & (kSlots - 1))); idx != kNil;)
+        {
+            Node& n = nodes_[idx];
+            uint32_t next = n.next;
+            n.slot = kNil;
+            if (n.expiry > now_)
+            {
+                insert(idx);
+            }
+            else if (n.period > 0)
+            {
+                due.push_back(n.callback);
+                n.expiry += n.period;
+                if (n.expiry <= now_)
+                {
+                    n.expiry = now_ + 1;
+                }
+                insert(idx);
+            }
+            else
+            {
+                due.push_back(std::move(n.callback));
+                freeNode(idx);
+                --active_;
+            }
+            idx = next;
+        }
+    }
+
+    void tickLoop()
+    {
+        std::vector<std::function<void()>> due;
+        uint64_t target = 1;
+        while (running_)
+        {
+            std::this_thread::sleep_until(tickTime(target));
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                // Catch up on every tick that elapsed while we slept
+                target = elapsedTicks(Clock::now());
+                while (now_ < target)
+                {
+                    advance(due);
+                }
+            }
+            ++target;
+            dispatch(due);
+        }
+    }
+
+    void dispatch(std::vector<std::function<void()>>& due)
+    {
+        if (due.empty())
+        {
+            return;
+        }
+        if (workerCount_ == 0)
+        {
+            for (auto& cb : due)
+            {
+                cb();
+            }
+        }
+        else
+        {
+            {
+                std::lock_guard<std::mutex> lock(queueMutex_);
+                for (auto& cb : due)
+                {
+                    queue_.push_back(std::move(cb));
+                }
+            }
+            queueCv_.notify_all();
+        }
+        due.clear();
+    }
+
+    void workerLoop()
+    {
+        for (;;)
+        {
+            std::function<void()> cb;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex_);
+                queueCv_.wait(lock, [this]() { return !queue_.empty() || !running_; });
+                if (queue_.empty())
+                {
+                    return;
+                }
+                cb = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            cb();
+        }
+    }
+
+    const std::chrono::nanoseconds tick_;
+    const size_t workerCount_;
+    std::atomic<bool> running_;
+    Clock::time_point origin_ = Clock::now();
+
+    mutable std::mutex mutex_;
+    uint64_t now_ = 0;
+    size_t active_ = 0;
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> freeList_;
+    uint32_t heads_[kLevels * kSlots];
+
+    std::mutex queueMutex_;
+    std::condition_variable queueCv_;
+    std::deque<std::function<void()>> queue_;
+
+    std::thread ticker_;
+    std::vector<std::thread> workers_;
+};
@@ -0,0 +1,77 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <sys/resource.h>
+#include "TimerWheel.hpp"
+#include "HighResolutionTimer.hpp"
+
+// Compile: g++ -std=c++17 -O2 -pthread -o TimerWheelDemo TimerWheelDemo.cpp
+// Usage:   ./TimerWheelDemo [active_timers]
+
+static double cpuSeconds()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    const auto spread = std::chrono::seconds(2);
+
+    TimerWheel wheel(std::chrono::milliseconds(1), 2);
+
+    // The Timer from HighResolutionTimer.hpp, driven by this wheel
+    std::atomic<int> periodicFired(0);
+    Timer<> periodic([&periodicFired]() { periodicFired++; }, std::chrono::milliseconds(100), wheel);
+    wheel.start();
+    periodic.start();
+
+    std::vector<TimerWheel::Clock::time_point> deadline(count);
+    std::vector<int64_t> lateness(count, -1);
+    std::atomic<size_t> fired(0);
+    std::mt19937_64 rng(7);
+
+    double cpuStart = cpuSeconds();
+    auto wallStart = TimerWheel::Clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto delay = std::chrono::microseconds(200000 + rng() % std::chrono::duration_cast<std::chrono::microseconds>(spread).count());
+        deadline[i] = TimerWheel::Clock::now() + delay;
+        wheel.schedule(delay, [i, &deadline, &lateness, &fired]()
+        {
+            lateness[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(TimerWheel::Clock::now() - deadline[i]).count();
+            fired++;
+        });
+    }
+    auto addTime = TimerWheel::Clock::now() - wallStart;
+    std::cout << "Scheduled " << count << " timers in "
+              << std::chrono::duration<double, std::milli>(addTime).count() << " ms ("
+              << std::chrono::duration<double, std::nano>(addTime).count() / count << " ns/add)" << std::endl;
+
+    // Cancel a pending timer to exercise the O(1) unlink path
+    TimerWheel::TimerId victim = wheel.schedule(std::chrono::seconds(10), []() {});
+    std::cout << "Cancel pending timer: " << std::boolalpha << wheel.cancel(victim)
+              << ", cancel again: " << wheel.cancel(victim) << std::endl;
+
+    while (fired < count)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    double wall = std::chrono::duration<double>(TimerWheel::Clock::now() - wallStart).count();
+    double cpu = cpuSeconds() - cpuStart;
+    periodic.stop();
+    wheel.stop();
+
+    std::sort(lateness.begin(), lateness.end());
+    auto pct = [&lateness](double p) { return lateness[static_cast<size_t>(p * (lateness.size() - 1))] / 1000.0; };
+    std::cout << "Firing lateness (us): p50 " << pct(0.50) << ", p99 " << pct(0.99)
+              << ", p99.9 " << pct(0.999) << ", max " << lateness.back() / 1000.0 << std::endl;
+    std::cout << "CPU: " << cpu << " s over " << wall << " s wall (" << 100.0 * cpu / wall << "% of a core)" << std::endl;
+    std::cout << "Periodic timer fired " << periodicFired << " times, active timers left: " << wheel.active() << std::endl;
+    return 0;
+}
@@ -0,0 +1,256 @@
+#pragma once
+
+// Low-overhead scoped tracing.
+//
+//   TRACE_SCOPE("forward_packet");   // times the enclosing block
+//   TRACE_FUNCTION();                // same, named after the function
+//   Tracer::writeChromeJson(out);    // dump for chrome://tracing / Perfetto
+//
+// Scopes are timestamped with the TSC, calibrated once against steady_clock,
+// and appended to a per-thread ring buffer with no locks or atomics RMW on the
+// hot path. Tracing is compiled out entirely unless ENABLE_TRACING is defined:
+// the macros then expand to nothing.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <sys/syscall.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace trace_detail
+{
+
+inline uint64_t readTicks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Linear TSC -> steady_clock mapping measured over a short busy window
+struct Calibration
+{
+    uint64_t baseTicks;
+    int64_t baseNs;
+    double nsPerTick;
+
+    Calibration()
+    {
+        using namespace std::chrono;
+        auto t0 = steady_clock::now();
+        uint64_t c0 = readTicks();
+        auto t1 = t0;
+        while (t1 - t0 < milliseconds(20))
+        {
+            t1 = steady_clock::now();
+        }
+        uint64_t c1 = readTicks();
+        baseTicks = c0;
+        baseNs = duration_cast<nanoseconds>(t0.time_since_epoch()).count();
+        nsPerTick = c1 > c0 ? static_cast<double>(duration_cast<nanoseconds>(t1 - t0).count()) / (c1 - c0) : 1.0;
+    }
+
+    int64_t toNs(uint64_t ticks) const
+    {
+        return baseNs + static_cast<int64_t>((static_cast<int64_t>(ticks - baseTicks)) * nsPerTick);
+    }
+};
+
+struct Event
+{
+    const char* name;
+    uint64_t begin;
+    uint64_t end;
+};
+
+// Single-producer ring owned by one thread; older events are overwritten
+class ThreadBuffer
+{
+public:
+    static const size_t kCapacity = 1 << 16;
+
+    explicit ThreadBuffer(long tid) : tid_(tid), head_(0), events_(kCapacity)
+    {
+    }
+
+    void push(const char* name, uint64_t begin, uint64_t end)
+    {
+        uint64_t h = head_.load(std::memory_order_relaxed);
+        Event& e = events_[h & (kCapacity - 1)];
+        e.name = name;
+        e.begin = begin;
+        e.end = end;
+        head_.store(h + 1, std::memory_order_release);
+    }
+
+    // Copy out the events still held in the ring
+    void snapshot(std::vector<Event>& out) const
+    {
+        uint64_t head = head_.load(std::memory_order_acquire);
+        uint64_t first = head > kCapacity ? head - kCapacity : 0;
+        size_t start = out.size();
+        for (uint64_t i = first; i < head; ++i)
+        {
+            out.push_back(events_[i & (kCapacity - 1)]);
+        }
+        // Drop anything the writer lapped while we were copying
+        uint64_t after = head_.load(std::memory_order_acquire);
+        if (after > first + kCapacity)
+        {
+            size_t lost = static_cast<size_t>(after - kCapacity - first);
+            lost = lost < out.size() - start ? lost : out.size() - start;
+            out.erase(out.begin() + start, out.begin() + start + lost);
+        }
+    }
+
+    long tid() const { return tid_; }
+
+private:
+    const long tid_;
+    std::atomic<uint64_t> head_;
+    std::vector<Event> events_;
+};
+
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+    static Registry& instance()
+    {
+        static Registry r;
+        return r;
+    }
+};
+
+inline ThreadBuffer& localBuffer()
+{
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (__builtin_expect(buffer == nullptr, 0))
+    {
+        auto b = std::make_shared<ThreadBuffer>(static_cast<long>(syscall(SYS_gettid)));
+        Registry& r = Registry::instance();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.buffers.push_back(b);
+        buffer = b.get();
+    }
+    return *buffer;
+}
+
+inline void writeJsonString(std::ostream& out, const char* s)
+{
+    out << '"';
+    for (; *s; ++s)
+    {
+        unsigned char c = static_cast<unsigned char>(*s);
+        if (c == '"' || c == '\\')
+        {
+            out << '\\' << *s;
+        }
+        else if (c < 0x20)
+        {
+            static const char hex[] = "0123456789abcdef";
+            out << "\\u00" << hex[c >> 4] << hex[c & 15];
+        }
+        else
+        {
+            out << *s;
+        }
+    }
+    out << '"';
+}
+
+} // namespace trace_detail
+
+class Tracer
+{
+public:
+    // Calibrate the TSC up front so the first traced scope does not pay for it
+    static const trace_detail::Calibration& calibration()
+    {
+        static const trace_detail::Calibration c;
+        return c;
+    }
+
+    // Record a completed span; name must outlive the export (use literals)
+    static void record(const char* name, uint64_t beginTicks, uint64_t endTicks)
+    {
+        trace_detail::localBuffer().push(name, beginTicks, endTicks);
+    }
+
+    // Export every buffered event in Chrome trace-event JSON (also loadable by Perfetto)
+    static void writeChromeJson(std::ostream& out)
+    {
+        const trace_detail::Calibration& cal = calibration();
+        trace_detail::Registry& r = trace_detail::Registry::instance();
+        std::vector<std::shared_ptr<trace_detail::ThreadBuffer>> buffers;
+        {
+            std::lock_guard<std::mutex> lock(r.mutex);
+            buffers = r.buffers;
+        }
+
+        const long pid = static_cast<long>(getpid());
+        std::vector<trace_detail::Event> events;
+        bool first = true;
+        out << "{\"traceEvents\":[";
+        for (const auto& b : buffers)
+        {
+            events.clear();
+            b->snapshot(events);
+            for (const auto& e : events)
+            {
+                int64_t beginNs = cal.toNs(e.begin);
+                int64_t durNs = static_cast<int64_t>((e.end - e.begin) * cal.nsPerTick);
+                out << (first ? "\n" : ",\n") << "{\"name\":";
+                trace_detail::writeJsonString(out, e.name);
+                out << ",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << b->tid()
+                    << ",\"ts\":" << beginNs / 1000 << '.' << (beginNs % 1000) / 100
+                    << ",\"dur\":" << durNs / 1000.0 << '}';
+                first = false;
+            }
+        }
+        out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    }
+};
+
+// RAII span covering the lifetime of the object
+class TraceScope
+{
+public:
+    explicit TraceScope(const char* name) : name_(name), begin_(trace_detail::readTicks())
+    {
+    }
+
+    ~TraceScope()
+    {
+        Tracer::record(name_, begin_, trace_detail::readTicks());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+    uint64_t begin_;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#if defined(ENABLE_TRACING)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define TRACE_FUNCTION() TRACE_SCOPE(__func__)
+#else
+#define TRACE_SCOPE(name) do { } while (0)
+#define TRACE_FUNCTION() do { } while (0)
+#endif
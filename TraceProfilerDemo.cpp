@@ -0,0 +1,76 @@
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cmath>
+#include "TraceProfiler.hpp"
+#include "greatCircleDistance.hpp"
+
+// Compile with tracing:    g++ -std=c++17 -O2 -pthread -DENABLE_TRACING -o TraceProfilerDemo TraceProfilerDemo.cpp
+// Compile without tracing: g++ -std=c++17 -O2 -pthread -o TraceProfilerDemo TraceProfilerDemo.cpp
+
+double geodesyBatch(int n)
+{
+    TRACE_FUNCTION();
+    double sum = 0.0;
+    for (int i = 0; i < n; ++i)
+    {
+        TRACE_SCOPE("greatCircleDistance");
+        sum += greatCircleDistance(51.5 + i * 1e-6, -0.12, 48.85, 2.35);
+    }
+    return sum;
+}
+
+int main()
+{
+    Tracer::calibration();
+
+    // Overhead of an empty traced scope versus an untraced loop
+    const int iterations = 10000000;
+    volatile int sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        TRACE_SCOPE("empty");
+        sink = sink + 1;
+    }
+    double traced = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        sink = sink + 1;
+    }
+    double baseline = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+#if defined(ENABLE_TRACING)
+    std::cout << "Tracing enabled, TSC at " << 1.0 / Tracer::calibration().nsPerTick << " GHz" << std::endl;
+#else
+    std::cout << "Tracing compiled out" << std::endl;
+#endif
+    std::cout << "Per-scope overhead: " << traced - baseline << " ns" << std::endl;
+
+    // A small multi-threaded workload to look at in chrome://tracing or ui.perfetto.dev
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t)
+    {
+        workers.emplace_back([]()
+        {
+            for (int b = 0; b < 20; ++b)
+            {
+                geodesyBatch(500);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+    }
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+
+    std::ofstream out("trace.json");
+    Tracer::writeChromeJson(out);
+    std::cout << "Wrote trace.json" << std::endl;
+    return 0;
+}
@@ -30,6 +30,7 @@ g++ -std=c++11 -o udp_forwarder udp_forwarder.cpp
 #include <cstring>
 #include <iostream>
 #include <netinet/in.h>
+#include <netdb.h>
 #include <string>
 #include <sys/socket.h>
 #include <unistd.h>
@@ -39,6 +40,8 @@ g++ -std=c++11 -o udp_forwarder udp_forwarder.cpp
 #include <memory>
 #include <algorithm>
 #include <getopt.h>
+#include <fcntl.h>
+#include "EventLoop.hpp"
 /**
  * @brief Maximum UDP payload size for IPv4
  * 
@@ -78,13 +81,6 @@ struct RateLimitInfo {
     int packet_count = 0;                               ///< Packet count in current window
 };
 
-/**
- * @brief Global flag for graceful shutdown
- * 
- * Set to false when SIGINT or SIGTERM is received to break the main loop
- */
-static volatile bool keep_running = true;
-
 /**
  * @brief Configuration for the forwarder instance
  */
@@ -95,28 +91,6 @@ static ForwarderConfig g_config;
  */
 static std::map<uint32_t, RateLimitInfo> g_rate_map;
 
-/**
- * @brief Signal handler for graceful shutdown
- * 
- * Handles SIGINT (Ctrl+C) and SIGTERM signals by setting the
- * keep_running flag to false, allowing the program to exit cleanly
- * 
- * @param sig Signal number (unused)
- */
-void signal_handler(int sig) {
-    static int call_count = 0;
-    call_count++;
-    
-    if (call_count >= 3) {
-        std::cerr << "\nForcing shutdown after multiple interrupts...\n";
-        exit(1);
-    }
-    
-    std::cerr << "\nReceived signal " << sig 
-              << ". Shutting down gracefully... (Press Ctrl+C again to force)\n";
-    keep_running = false;
-}
-
 /**
  * @brief Parse an IP:PORT string into sockaddr_in structure
  * 
@@ -358,22 +332,26 @@ int initialize_socket() {
 }
 
 /**
- * @brief Setup signal handlers for graceful shutdown
+ * @brief Setup signal handling for graceful shutdown
+ * 
+ * Routes SIGINT (Ctrl+C) and SIGTERM through the event loop's signalfd,
+ * so shutdown is handled synchronously in the loop instead of from an
+ * async signal handler. The first signal stops the loop; cleanup after
+ * it does not block, so there is nothing to force.
  * 
- * Registers handlers for SIGINT (Ctrl+C) and SIGTERM using sigaction
- * for better portability and control.
+ * @param[in] loop Event loop that dispatches the forwarder
  */
-void setup_signal_handlers() {
-    struct sigaction sa;
-    sa.sa_handler = signal_handler;
-    sigemptyset(&sa.sa_mask);
-    sa.sa_flags = 0;
+void setup_signal_handlers(EventLoop& loop) {
+    auto on_signal = [&loop](const struct signalfd_siginfo& info) {
+        std::cerr << "\nReceived signal " << info.ssi_signo << ". Shutting down gracefully...\n";
+        loop.stop();
+    };
     
-    if (sigaction(SIGINT, &sa, nullptr) < 0) {
+    if (!loop.addSignal(SIGINT, on_signal)) {
         perror("Warning: Failed to set SIGINT handler");
     }
     
-    if (sigaction(SIGTERM, &sa, nullptr) < 0) {
+    if (!loop.addSignal(SIGTERM, on_signal)) {
         perror("Warning: Failed to set SIGTERM handler");
     }
 }
@@ -391,40 +369,35 @@ std::string addr_to_string(const struct sockaddr_in& addr) {
 }
 
 /**
- * @brief Main packet forwarding loop
+ * @brief Forward every packet currently queued on the socket
  * 
- * Continuously receives packets and forwards them to all configured
- * destinations. Handles rate limiting and verbose logging.
+ * Receives until the non-blocking socket would block and forwards each
+ * packet to all configured destinations. Handles rate limiting and
+ * verbose logging.
  * 
- * @param[in] sock_fd Socket file descriptor for listening
+ * @param[in] sock_fd Non-blocking socket file descriptor for listening
+ * @param[in] buffer Receive buffer of at least MAX_UDP_PAYLOAD bytes
+ * @return true once the socket is drained, false on a fatal receive error
  */
-void run_forwarder(int sock_fd) {
-    std::vector<char> buffer(MAX_UDP_PAYLOAD);
-    struct sockaddr_in src_addr;
-    socklen_t src_addr_len = sizeof(src_addr);
-    
-    std::cout << "UDP Forwarder started\n";
-    std::cout << "Listening on port: " << g_config.listen_port << "\n";
-    std::cout << "Destinations (" << g_config.destinations.size() << "):\n";
-    for (const auto& dest : g_config.destinations) {
-        std::cout << "  - " << addr_to_string(dest) << "\n";
-    }
-    std::cout << "Rate limit: " << g_config.rate_limit << " packets/sec per source\n";
-    std::cout << "Verbose mode: " << (g_config.verbose ? "enabled" : "disabled") << "\n";
-    std::cout << "Press Ctrl+C to stop\n\n";
-    
-    while (keep_running) {
+bool forward_pending_packets(int sock_fd, std::vector<char>& buffer) {
+    for (;;) {
+        struct sockaddr_in src_addr;
+        socklen_t src_addr_len = sizeof(src_addr);
+        
         // Receive packet
         ssize_t received = recvfrom(sock_fd, buffer.data(), buffer.size(), 0,
                                    reinterpret_cast<struct sockaddr*>(&src_addr), &src_addr_len);
         
         if (received < 0) {
             if (errno == EINTR) {
-                // Interrupted by signal, check keep_running flag
                 continue;
             }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // Socket drained, wait for the next readiness event
+                return true;
+            }
             perror("Error: Failed to receive packet");
-            break;
+            return false;
         }
         
         // Apply rate limiting
@@ -464,13 +437,56 @@ void run_forwarder(int sock_fd) {
     }
 }
 
+/**
+ * @brief Main packet forwarding loop
+ * 
+ * Registers the listening socket with the event loop and runs it until
+ * shutdown. Each readiness event drains every queued packet and forwards
+ * it to all configured destinations. Handles rate limiting and verbose
+ * logging. Timers and other sockets can share the same loop.
+ * 
+ * @param[in] loop Event loop to dispatch from
+ * @param[in] sock_fd Socket file descriptor for listening
+ */
+void run_forwarder(EventLoop& loop, int sock_fd) {
+    std::vector<char> buffer(MAX_UDP_PAYLOAD);
+    
+    // Non-blocking so a readiness event can drain the socket completely
+    int flags = fcntl(sock_fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(sock_fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        perror("Error: Failed to make socket non-blocking");
+        return;
+    }
+    
+    std::cout << "UDP Forwarder started\n";
+    std::cout << "Listening on port: " << g_config.listen_port << "\n";
+    std::cout << "Destinations (" << g_config.destinations.size() << "):\n";
+    for (const auto& dest : g_config.destinations) {
+        std::cout << "  - " << addr_to_string(dest) << "\n";
+    }
+    std::cout << "Rate limit: " << g_config.rate_limit << " packets/sec per source\n";
+    std::cout << "Verbose mode: " << (g_config.verbose ? "enabled" : "disabled") << "\n";
+    std::cout << "Press Ctrl+C to stop\n\n";
+    
+    if (!loop.addFd(sock_fd, EPOLLIN, [&loop, &buffer, sock_fd](uint32_t) {
+            if (!forward_pending_packets(sock_fd, buffer)) {
+                loop.stop();
+            }
+        })) {
+        return;
+    }
+    
+    loop.run();
+    loop.removeFd(sock_fd);
+}
+
 /**
  * @brief Main entry point for the UDP forwarder
  * 
  * Orchestrates the entire forwarding process:
  * 1. Parse command line arguments
  * 2. Initialize socket
- * 3. Setup signal handlers
+ * 3. Setup signal handling on the event loop
  * 4. Run main forwarding loop
  * 5. Cleanup and exit
  * 
@@ -495,11 +511,12 @@ int main(int argc, char** argv) {
     }
     
     // Setup signal handlers for graceful shutdown
-    setup_signal_handlers();
+    EventLoop loop;
+    setup_signal_handlers(loop);
     
     try {
         // Run the main forwarding loop
-        run_forwarder(sock_fd);
+        run_forwarder(loop, sock_fd);
     } catch (const std::exception& e) {
         std::cerr << "Error: Unexpected exception: " << e.what() << "\n";
         close(sock_fd);
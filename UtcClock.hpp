@@ -0,0 +1,303 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+// Wall-clock time for hot paths: UTC nanoseconds from the TSC in a few
+// cycles, instead of a clock_gettime() per event.
+//
+//   int64_t t = UtcClock::global().nowNanos();
+//   char line[32];
+//   UtcClock::format(t, line, 6);      // "2026-10-18 09:41:07.123456"
+//
+// The mapping is ns = baseNanos + (tsc - baseTicks) * multiplier / 2^32,
+// published with a seqlock so readers never block. A background thread
+// recalibrates it against CLOCK_REALTIME once per interval. The rate comes
+// from CLOCK_MONOTONIC across the interval, so it follows NTP slewing but
+// not steps. Small errors are steered out over the next interval by
+// adjusting the rate, so the time read never jumps; an error over 1 ms
+// (the kernel clock was stepped) is applied at once.
+//
+// Without an invariant TSC (or off x86) nowNanos() falls back to
+// clock_gettime(CLOCK_REALTIME).
+
+class UtcClock
+{
+public:
+    explicit UtcClock(std::chrono::milliseconds recalibrate = std::chrono::milliseconds(1000), bool background = true)
+        : interval_(recalibrate), seq_(0), baseTicks_(0), baseNanos_(0), multiplier_(0), lastError_(0),
+          running_(false), tsc_(invariantTsc())
+    {
+        if (tsc_)
+        {
+            // Initial rate over a short busy window
+            last_ = sample();
+            Sample s = last_;
+            while (s.monotonic - last_.monotonic < 10000000)
+            {
+                s = sample();
+            }
+            publish(s.ticks, s.realtime, rate(last_, s));
+            last_ = s;
+        }
+        if (tsc_ && background)
+        {
+            running_ = true;
+            worker_ = std::thread([this]() { run(); });
+        }
+    }
+
+    ~UtcClock()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        wake_.notify_all();
+        if (worker_.joinable())
+        {
+            worker_.join();
+        }
+    }
+
+    UtcClock(const UtcClock&) = delete;
+    UtcClock& operator=(const UtcClock&) = delete;
+
+    // Process-wide instance, recalibrated every second
+    static UtcClock& global()
+    {
+        static UtcClock clock;
+        return clock;
+    }
+
+    // Unix time in nanoseconds
+    int64_t nowNanos() const
+    {
+        if (!tsc_)
+        {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+        }
+        return toNanos(readTicks());
+    }
+
+    std::chrono::system_clock::time_point now() const
+    {
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(nowNanos())));
+    }
+
+    // Raw ticks, for stamping now and converting later (or never)
+    static uint64_t readTicks()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    int64_t toNanos(uint64_t ticks) const
+    {
+        for (;;)
+        {
+            uint32_t s0 = seq_.load(std::memory_order_acquire);
+            uint64_t base = baseTicks_.load(std::memory_order_relaxed);
+            int64_t nanos = baseNanos_.load(std::memory_order_relaxed);
+            uint64_t mult = multiplier_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if ((s0 & 1) == 0 && seq_.load(std::memory_order_relaxed) == s0)
+            {
+                __int128 delta = static_cast<int64_t>(ticks - base);
+                return nanos + static_cast<int64_t>((delta * mult) >> 32);
+            }
+        }
+    }
+
+    // Re-read CLOCK_REALTIME and correct the mapping. The background thread
+    // calls this; without it, call it about once per interval.
+    void calibrate()
+    {
+        if (!tsc_)
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(calibrating_);
+        Sample s = sample();
+        if (s.ticks == last_.ticks)
+        {
+            return;
+        }
+        uint64_t mult = rate(last_, s);
+        int64_t predicted = toNanos(s.ticks);
+        int64_t error = s.realtime - predicted;
+        lastError_.store(error, std::memory_order_relaxed);
+        if (error > kStepThreshold || error < -kStepThreshold)
+        {
+            publish(s.ticks, s.realtime, mult);
+        }
+        else
+        {
+            // Continue from where readers are now, at a rate that closes
+            // the error by the next calibration
+            __int128 steer = (static_cast<__int128>(error) << 32) / static_cast<int64_t>(s.ticks - last_.ticks);
+            publish(s.ticks, predicted, static_cast<uint64_t>(static_cast<__int128>(mult) + steer));
+        }
+        last_ = s;
+    }
+
+    bool usingTsc() const { return tsc_; }
+    double ticksPerSecond() const { return tsc_ ? 4294967296e9 / static_cast<double>(multiplier_.load()) : 0; }
+    int64_t lastError() const { return lastError_.load(std::memory_order_relaxed); } ///< At the last calibration, ns
+
+    // "YYYY-MM-DD HH:MM:SS" plus '.' and digits (0-9) of fraction; returns
+    // the length (19 + digits + 1 with a fraction). out needs 30 bytes. The
+    // date part is formatted once per second per thread and copied after.
+    static size_t format(int64_t nanos, char* out, int digits = 6)
+    {
+        struct Cache
+        {
+            int64_t second = INT64_MIN;
+            char text[20];
+        };
+        static thread_local Cache cache;
+        int64_t second = nanos / 1000000000 - (nanos % 1000000000 < 0);
+        uint32_t fraction = static_cast<uint32_t>(nanos - second * 1000000000);
+        if (second != cache.second)
+        {
+            time_t t = static_cast<time_t>(second);
+            struct tm tm;
+            gmtime_r(&t, &tm);
+            strftime(cache.text, sizeof(cache.text), "%Y-%m-%d %H:%M:%S", &tm);
+            cache.second = second;
+        }
+        memcpy(out, cache.text, 19);
+        if (digits <= 0)
+        {
+            out[19] = '\0';
+            return 19;
+        }
+        digits = digits > 9 ? 9 : digits;
+        out[19] = '.';
+        for (int i = 9; i > digits; --i)
+        {
+            fraction /= 10;
+        }
+        for (int i = digits; i > 0; --i)
+        {
+            out[19 + i] = static_cast<char>('0' + fraction % 10);
+            fraction /= 10;
+        }
+        out[20 + digits] = '\0';
+        return static_cast<size_t>(20 + digits);
+    }
+
+private:
+    static const int64_t kStepThreshold = 1000000;
+
+    struct Sample
+    {
+        uint64_t ticks;
+        int64_t realtime;
+        int64_t monotonic;
+    };
+
+    static int64_t nanos(const struct timespec& ts)
+    {
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+
+    // Both clocks against the TSC; of a few tries, the one where the reads
+    // were closest together (least likely to have been interrupted)
+    static Sample sample()
+    {
+        Sample best = {0, 0, 0};
+        uint64_t bestSpan = UINT64_MAX;
+        for (int i = 0; i < 5; ++i)
+        {
+            struct timespec rt, mono;
+            uint64_t a = readTicks();
+            clock_gettime(CLOCK_REALTIME, &rt);
+            uint64_t b = readTicks();
+            clock_gettime(CLOCK_MONOTONIC, &mono);
+            uint64_t c = readTicks();
+            if (c - a < bestSpan)
+            {
+                bestSpan = c - a;
+                // Realtime was read between a and b. Monotonic, read just
+                // after, is only used for differences between samples, where
+                // the constant lag cancels.
+                best.ticks = a + (b - a) / 2;
+                best.realtime = nanos(rt);
+                best.monotonic = nanos(mono);
+            }
+        }
+        return best;
+    }
+
+    // ns per tick in 32.32 fixed point
+    static uint64_t rate(const Sample& from, const Sample& to)
+    {
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(to.monotonic - from.monotonic) << 32) /
+                                     (to.ticks - from.ticks));
+    }
+
+    void publish(uint64_t ticks, int64_t nanos, uint64_t mult)
+    {
+        uint32_t s = seq_.load(std::memory_order_relaxed);
+        seq_.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        baseTicks_.store(ticks, std::memory_order_relaxed);
+        baseNanos_.store(nanos, std::memory_order_relaxed);
+        multiplier_.store(mult, std::memory_order_relaxed);
+        seq_.store(s + 2, std::memory_order_release);
+    }
+
+    static bool invariantTsc()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned eax, ebx, ecx, edx;
+        return __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8));
+#else
+        return false;
+#endif
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (running_)
+        {
+            wake_.wait_for(lock, interval_);
+            if (running_)
+            {
+                calibrate();
+            }
+        }
+    }
+
+    std::chrono::milliseconds interval_;
+    std::atomic<uint32_t> seq_;
+    std::atomic<uint64_t> baseTicks_;
+    std::atomic<int64_t> baseNanos_;
+    std::atomic<uint64_t> multiplier_;
+    std::atomic<int64_t> lastError_;
+    Sample last_;                ///< Previous calibration point
+    std::mutex calibrating_;     ///< One writer at a time
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool running_;
+    bool tsc_;
+    std::thread worker_;
+};
@@ -0,0 +1,192 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "UtcClock.hpp"
+
+static bool check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        std::cerr << "Self-test failed: " << what << std::endl;
+    }
+    return ok;
+}
+
+#define SELF_CHECK(cond) ok &= check((cond), #cond)
+
+static int64_t realtimeNanos()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+static bool selfTest()
+{
+    bool ok = true;
+    char text[32];
+
+    SELF_CHECK(UtcClock::format(1700000000123456789LL, text, 6) == 26 && std::string(text) == "2023-11-14 22:13:20.123456");
+    SELF_CHECK(UtcClock::format(1700000000123456789LL, text, 9) == 29 && std::string(text) == "2023-11-14 22:13:20.123456789");
+    SELF_CHECK(UtcClock::format(1700000000999999999LL, text, 0) == 19 && std::string(text) == "2023-11-14 22:13:20");
+    SELF_CHECK(UtcClock::format(1700000001000000000LL, text, 3) == 23 && std::string(text) == "2023-11-14 22:13:21.000");
+    SELF_CHECK(UtcClock::format(-1, text, 3) == 23 && std::string(text) == "1969-12-31 23:59:59.999");
+
+    // Against the kernel clock for two seconds, recalibrating every 100 ms:
+    // each reading must fall between two clock_gettime() calls around it,
+    // give or take the calibration error, and never go backwards
+    UtcClock clock(std::chrono::milliseconds(100));
+    std::vector<int64_t> errors;
+    int64_t previous = 0, backwards = 0;
+    int64_t end = realtimeNanos() + 2000000000LL;
+    for (int64_t t = realtimeNanos(); t < end; t = realtimeNanos())
+    {
+        for (int i = 0; i < 1000; ++i)
+        {
+            int64_t now = clock.nowNanos();
+            backwards += now < previous;
+            previous = now;
+        }
+        int64_t before = realtimeNanos();
+        int64_t now = clock.nowNanos();
+        int64_t after = realtimeNanos();
+        if (after - before < 2000)
+        {
+            errors.push_back(now < before ? now - before : now > after ? now - after : 0);
+        }
+    }
+    std::sort(errors.begin(), errors.end(), [](int64_t a, int64_t b) { return std::llabs(a) < std::llabs(b); });
+    SELF_CHECK(!errors.empty());
+    SELF_CHECK(backwards == 0);
+    int64_t median = errors.empty() ? 0 : std::llabs(errors[errors.size() / 2]);
+    int64_t p99 = errors.empty() ? 0 : std::llabs(errors[errors.size() * 99 / 100]);
+    SELF_CHECK(!clock.usingTsc() || p99 < 20000);
+
+    // Without the background thread, calibrate() by hand keeps it in step
+    UtcClock manual(std::chrono::milliseconds(1000), false);
+    manual.calibrate();
+    SELF_CHECK(std::llabs(manual.nowNanos() - realtimeNanos()) < 100000);
+
+    std::cout << (clock.usingTsc() ? "TSC" : "clock_gettime fallback") << " at " << clock.ticksPerSecond() / 1e6
+              << " MHz; outside clock_gettime brackets: median " << median << " ns, p99 " << p99 << " ns over "
+              << errors.size() << " checks; last calibration error " << clock.lastError() << " ns" << std::endl;
+    if (ok)
+    {
+        std::cout << "Self-test passed" << std::endl;
+    }
+    return ok;
+}
+
+template <typename Fn>
+static double nanosPer(size_t count, Fn fn)
+{
+    double best = 1e9;
+    for (int run = 0; run < 5; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn(count);
+        best = std::min(best, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count);
+    }
+    return best;
+}
+
+int main()
+{
+    if (!selfTest())
+    {
+        return 1;
+    }
+
+    UtcClock& clock = UtcClock::global();
+    volatile int64_t sink = 0;
+    const size_t n = 2000000;
+
+    double sys = nanosPer(n, [&](size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            sink = std::chrono::system_clock::now().time_since_epoch().count();
+        }
+    });
+    double gettime = nanosPer(n, [&](size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            sink = realtimeNanos();
+        }
+    });
+    double coarse = nanosPer(n, [&](size_t count)
+    {
+        struct timespec ts;
+        for (size_t i = 0; i < count; ++i)
+        {
+            clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+            sink = ts.tv_nsec;
+        }
+    });
+    double ticks = nanosPer(n, [&](size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            sink = static_cast<int64_t>(UtcClock::readTicks());
+        }
+    });
+    double tsc = nanosPer(n, [&](size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            sink = clock.nowNanos();
+        }
+    });
+
+    // Per-event log timestamps: ctime_r as in NTPSync.cpp, gmtime_r +
+    // strftime + the fraction, and the cached formatter
+    char text[64];
+    const size_t m = 500000;
+    double ctimeFormat = nanosPer(m, [&](size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            time_t t = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+            ctime_r(&t, text);
+            sink = text[18];
+        }
+    });
+    double strftimeFormat = nanosPer(m, [&](size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            struct tm tm;
+            gmtime_r(&ts.tv_sec, &tm);
+            size_t len = strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &tm);
+            snprintf(text + len, sizeof(text) - len, ".%06ld", ts.tv_nsec / 1000);
+            sink = text[20];
+        }
+    });
+    double cachedFormat = nanosPer(m, [&](size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            UtcClock::format(clock.nowNanos(), text, 6);
+            sink = text[20];
+        }
+    });
+
+    UtcClock::format(clock.nowNanos(), text, 9);
+    std::cout << "Now: " << text << " UTC" << std::endl;
+    std::cout << "ns per call:" << std::endl;
+    std::cout << "  system_clock::now()              " << sys << std::endl;
+    std::cout << "  clock_gettime(CLOCK_REALTIME)    " << gettime << std::endl;
+    std::cout << "  clock_gettime(REALTIME_COARSE)   " << coarse << " (jiffy resolution)" << std::endl;
+    std::cout << "  UtcClock::readTicks (rdtsc)      " << ticks << std::endl;
+    std::cout << "  UtcClock::nowNanos               " << tsc << std::endl;
+    std::cout << "  ctime_r(system_clock)            " << ctimeFormat << std::endl;
+    std::cout << "  gmtime_r + strftime + fraction   " << strftimeFormat << std::endl;
+    std::cout << "  UtcClock now + format            " << cachedFormat << std::endl;
+    return 0;
+}
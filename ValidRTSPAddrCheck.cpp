@@ -1,20 +1,167 @@
 #include <iostream>
 #include <regex>
 #include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstring>
+#include <arpa/inet.h>
+#include "AddressValidators.hpp"
 
-bool isValidRTSPAddress(const std::string& address) 
+bool isValidRTSPAddress(const std::string& address)
 {
-    const std::regex rtspRegex("^rtsp://[a-zA-Z0-9.-]+(?::\\d+)?(/[a-zA-Z0-9-._~%!$&'()*+,;=:@/]*)?(\\?[a-zA-Z0-9-._~%!$&'()*+,;=:@/?]*)?$");
+    return parseRtspUrl(address);
+}
+
+// The original patterns, kept as the reference the DFAs must agree with
+static const char* kRtspPattern = "^rtsp://[a-zA-Z0-9.-]+(?::\\d+)?(/[a-zA-Z0-9-._~%!$&'()*+,;=:@/]*)?(\\?[a-zA-Z0-9-._~%!$&'()*+,;=:@/?]*)?$";
+static const char* kMacPattern = "^([0-9A-Fa-f]{2}[:-]){5}([0-9A-Fa-f]{2})$";
+
+// As the checks used to be written: the pattern is compiled on every call
+bool isValidRTSPAddressRegex(const std::string& address)
+{
+    const std::regex rtspRegex(kRtspPattern);
     return std::regex_match(address, rtspRegex);
 }
 
-int main() 
+bool isValidMacAddressRegex(const std::string& macAddress)
+{
+    std::regex macRegex(kMacPattern);
+    return std::regex_match(macAddress, macRegex);
+}
+
+// Compiled once; isolates the matcher cost from the compile cost
+static bool matchesCached(const std::string& s, const char* pattern)
+{
+    static const std::regex rtsp(kRtspPattern);
+    static const std::regex mac(kMacPattern);
+    return std::regex_match(s, pattern == kRtspPattern ? rtsp : mac);
+}
+
+// Random edits of valid inputs: most are still close to valid, which is
+// where a hand-written DFA would disagree with the pattern if it were wrong
+static std::vector<std::string> mutate(const std::vector<std::string>& seeds, size_t count, const std::string& alphabet)
+{
+    std::mt19937 rng(42);
+    std::vector<std::string> out;
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::string s = seeds[rng() % seeds.size()];
+        for (unsigned edits = rng() % 3; edits > 0 && !s.empty(); --edits)
+        {
+            size_t pos = rng() % (s.size() + 1);
+            char c = alphabet[rng() % alphabet.size()];
+            switch (rng() % 3)
+            {
+            case 0: s.insert(s.begin() + static_cast<std::ptrdiff_t>(pos), c); break;
+            case 1: if (pos < s.size()) s.erase(pos, 1); break;
+            default: if (pos < s.size()) s[pos] = c; break;
+            }
+        }
+        out.push_back(s);
+    }
+    return out;
+}
+
+template <typename Fn>
+static double nanosPerCall(const std::vector<std::string>& inputs, Fn fn)
+{
+    size_t accepted = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& s : inputs)
+    {
+        accepted += fn(s);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    volatile size_t sink = accepted;
+    (void)sink;
+    return ns / static_cast<double>(inputs.size());
+}
+
+static bool selfTest(const std::vector<std::string>& urls, const std::vector<std::string>& macs,
+                     const std::vector<std::string>& hosts)
+{
+    size_t mismatches = 0;
+    for (const auto& u : urls)
+    {
+        mismatches += isValidRTSPAddress(u) != matchesCached(u, kRtspPattern);
+    }
+    for (const auto& m : macs)
+    {
+        mismatches += parseMacAddress(m) != matchesCached(m, kMacPattern);
+    }
+    // IPv4 and IPv6 must accept exactly what inet_pton does
+    for (const auto& h : hosts)
+    {
+        unsigned char ref[16], mine[16];
+        bool v4 = inet_pton(AF_INET, h.c_str(), ref) == 1;
+        mismatches += parseIPv4(h, mine) != v4 || (v4 && memcmp(ref, mine, 4) != 0);
+        bool v6 = inet_pton(AF_INET6, h.c_str(), ref) == 1;
+        mismatches += parseIPv6(h, mine) != v6 || (v6 && memcmp(ref, mine, 16) != 0);
+    }
+
+    HostPortParts hp;
+    mismatches += !parseHostPort("[fe80::1]:554", &hp) || hp.family != HostPortParts::IPv6 || hp.portNumber != 554;
+    mismatches += !parseHostPort("10.0.0.1:8554", &hp) || hp.family != HostPortParts::IPv4 || hp.address[3] != 1;
+    mismatches += !parseHostPort("camera-1.example.com:554", &hp) || hp.family != HostPortParts::Name;
+    mismatches += parseHostPort("10.0.0.256:554") || parseHostPort("host:65536") || parseHostPort("-bad.com:1") ||
+                  parseHostPort("[::1]554") || parseHostPort("host:");
+
+    if (mismatches)
+    {
+        std::cerr << "Self-test failed: " << mismatches << " disagreements" << std::endl;
+        return false;
+    }
+    std::cout << "Self-test passed (" << urls.size() + macs.size() + hosts.size() << " inputs agree with regex/inet_pton)"
+              << std::endl;
+    return true;
+}
+
+int main()
 {
-    std::string address1 = "rtsp://example.com:8554/stream1";
+    std::string address1 = "rtsp://example.com:8554/stream1?track=video";
     std::string address2 = "invalid_address";
 
     std::cout << "Address 1 is valid: " << std::boolalpha << isValidRTSPAddress(address1) << std::endl;
     std::cout << "Address 2 is valid: " << std::boolalpha << isValidRTSPAddress(address2) << std::endl;
 
+    RtspUrlParts url;
+    if (parseRtspUrl(address1, &url))
+    {
+        std::cout << "  host=" << url.host << " port=" << url.port << " path=" << url.path << " query=" << url.query << std::endl;
+    }
+
+    std::vector<std::string> urls = mutate({"rtsp://example.com:8554/stream1", "rtsp://10.0.0.1/live?x=1&y=2",
+                                            "rtsp://cam-1.local:554/a/b/c.sdp", "rtsp://h?q/?"},
+                                           200000, "rtsp:/?@%.-_~09aZ[]# ");
+    std::vector<std::string> macs = mutate({"00:1A:2b:3C:4d:5E", "AA-BB-CC-DD-EE-FF", "01:23-45:67-89:ab"},
+                                           200000, "0aFg:-. ");
+    std::vector<std::string> hosts = mutate({"192.168.0.1", "0.0.0.0", "255.255.255.255", "::1", "::", "fe80::1:2",
+                                             "2001:db8:0:0:0:0:2:1", "::ffff:10.0.0.1", "1:2:3:4:5:6:7::"},
+                                            200000, "0123456789abcdefg:.");
+    if (!selfTest(urls, macs, hosts))
+    {
+        return 1;
+    }
+
+    std::vector<std::string> urlSample(urls.begin(), urls.begin() + 2000);
+    std::vector<std::string> macSample(macs.begin(), macs.begin() + 2000);
+    double rtspRegex = nanosPerCall(urlSample, [](const std::string& s) { return isValidRTSPAddressRegex(s); });
+    double rtspCached = nanosPerCall(urls, [](const std::string& s) { return matchesCached(s, kRtspPattern); });
+    double rtspDfa = nanosPerCall(urls, [](const std::string& s) { RtspUrlParts p; return parseRtspUrl(s, &p); });
+    double macRegex = nanosPerCall(macSample, [](const std::string& s) { return isValidMacAddressRegex(s); });
+    double macCached = nanosPerCall(macs, [](const std::string& s) { return matchesCached(s, kMacPattern); });
+    double macDfa = nanosPerCall(macs, [](const std::string& s) { MacAddressParts p; return parseMacAddress(s, &p); });
+    double hostDfa = nanosPerCall(hosts, [](const std::string& s) { uint8_t a[16]; return parseIPv6(s, a) || parseIPv4(s, a); });
+    double hostPton = nanosPerCall(hosts, [](const std::string& s)
+    {
+        unsigned char a[16];
+        return inet_pton(AF_INET6, s.c_str(), a) == 1 || inet_pton(AF_INET, s.c_str(), a) == 1;
+    });
+
+    std::cout << "ns per call        regex/call   regex/cached   DFA" << std::endl;
+    std::cout << "RTSP URL           " << rtspRegex << "   " << rtspCached << "   " << rtspDfa << std::endl;
+    std::cout << "MAC address        " << macRegex << "   " << macCached << "   " << macDfa << std::endl;
+    std::cout << "IPv4/IPv6          inet_pton " << hostPton << "   DFA " << hostDfa << std::endl;
     return 0;
 }
@@ -1,38 +1,49 @@
 
 #include <iostream>
-#include <cstdio>
-#include <cstring>
-#include <fcntl.h>
-#include <unistd.h>
+#include <chrono>
+#include <csignal>
+#include <thread>
+#include "Watchdog.hpp"
+
+// A process guarded by the watchdog daemon (LinuxWatchDog.cpp). Each pass
+// of the main loop beats; if a pass ever takes longer than the deadline,
+// the daemon stops feeding /dev/watchdog and the machine is reset.
+// SIGTERM/SIGINT end the loop so the heartbeat detaches: a process that
+// is stopped on purpose must not look hung.
+static volatile std::sig_atomic_t stopRequested = 0;
+
+static void requestStop(int)
+{
+    stopRequested = 1;
+}
 
 int main() 
 {
-    const char* watchdog_dev = "/dev/watchdog";
-    int watchdog_fd = open(watchdog_dev, O_WRONLY);
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = requestStop;
+    sigaction(SIGTERM, &sa, nullptr);
+    sigaction(SIGINT, &sa, nullptr);
 
-    if (watchdog_fd == -1) 
+    try
     {
-        std::cerr << "Failed to open watchdog device" << std::endl;
-        return 1;
-    }
+        HeartbeatTable table(kHeartbeatTable);
+        Heartbeat heartbeat(table, "WatchDogApp", std::chrono::seconds(5));
+        std::cout << "Registered with the watchdog daemon" << std::endl;
 
-    std::cout << "Watchdog device opened successfully" << std::endl;
-
-    const int timeout = 10; // Watchdog timeout in seconds
-    const char* magic_str = "V";
-
-    while (true) 
-    {
-        if (write(watchdog_fd, magic_str, 1) != 1) 
+        while (!stopRequested) 
         {
-            std::cerr << "Failed to write to watchdog device" << std::endl;
-            break;
-        }
+            // The real work goes here
+            std::this_thread::sleep_for(std::chrono::seconds(1));
 
-        std::cout << "Watchdog timer reset" << std::endl;
-        sleep(timeout / 2); // Reset watchdog timer every half of the timeout
+            heartbeat.beat();
+        }
+        std::cout << "Stopping; detaching from the watchdog daemon" << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << " (is the watchdog daemon running?)" << std::endl;
+        return 1;
     }
-
-    close(watchdog_fd);
     return 0;
 }
@@ -0,0 +1,478 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <linux/watchdog.h>
+#include "EventLoop.hpp"
+
+// Hardware watchdog that is only fed while the processes it guards are
+// alive and making progress.
+//
+// Monitored processes attach to a shared-memory table of heartbeat slots
+// and call beat() from their main loop; a beat is one store to a counter in
+// their own cache line, with no system call or lock. The daemon samples the
+// counters every check period and pets /dev/watchdog only if every attached
+// client's counter has moved within its deadline. A client that hangs or
+// dies without detaching therefore lets the hardware reset the machine.
+//
+//   daemon:  WatchdogDevice dog; HeartbeatTable table(kHeartbeatTable, true);
+//            WatchdogManager manager(loop, dog, table); manager.start(); loop.run();
+//   client:  HeartbeatTable table(kHeartbeatTable); Heartbeat hb(table, "worker", 2s);
+//            for (;;) { work(); hb.beat(); }
+
+static const char* const kHeartbeatTable = "/watchdog-heartbeats";
+
+// One client's slot; each on its own cache line so beats do not contend
+struct alignas(64) HeartbeatSlot
+{
+    enum : uint32_t
+    {
+        kFree,
+        kClaimed,   ///< Being filled in by a client
+        kActive
+    };
+
+    std::atomic<uint32_t> state;
+    std::atomic<uint32_t> generation;   ///< Bumped on every attach
+    std::atomic<uint64_t> beats;
+    int64_t deadlineNs;
+    int32_t pid;
+    char name[36];
+};
+
+struct HeartbeatHeader
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    char pad[48];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "heartbeats need address-free atomics");
+static_assert(sizeof(HeartbeatSlot) == 64, "one slot per cache line");
+
+// The table as a POSIX shared-memory object (/dev/shm/<name>)
+class HeartbeatTable
+{
+public:
+    static const uint64_t kMagic = 0x57444f4748425431ull; // "WDOGHBT1"
+
+    // create: make the object if needed (the daemon); otherwise attach to
+    // an existing one (clients). Throws if it cannot be opened or mapped.
+    explicit HeartbeatTable(const std::string& name = kHeartbeatTable, bool create = false, uint32_t capacity = 64)
+    {
+        int fd = shm_open(name.c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT : 0), 0600);
+        if (fd < 0)
+        {
+            throw std::runtime_error("HeartbeatTable: cannot open " + name + ": " + strerror(errno));
+        }
+        struct stat st;
+        fstat(fd, &st);
+        size_t wanted = sizeof(HeartbeatHeader) + capacity * sizeof(HeartbeatSlot);
+        bool fresh = create && static_cast<size_t>(st.st_size) < sizeof(HeartbeatHeader);
+        if (fresh && ftruncate(fd, static_cast<off_t>(wanted)) < 0)
+        {
+            close(fd);
+            throw std::runtime_error("HeartbeatTable: cannot size " + name + ": " + strerror(errno));
+        }
+        size_ = fresh ? wanted : static_cast<size_t>(st.st_size);
+        void* p = size_ >= sizeof(HeartbeatHeader) ? mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        close(fd);
+        if (p == MAP_FAILED)
+        {
+            throw std::runtime_error("HeartbeatTable: cannot map " + name);
+        }
+        header_ = static_cast<HeartbeatHeader*>(p);
+        slots_ = reinterpret_cast<HeartbeatSlot*>(header_ + 1);
+        if (fresh)
+        {
+            // A new object is zero-filled, i.e. every slot kFree
+            header_->version = 1;
+            header_->capacity = capacity;
+            std::atomic_thread_fence(std::memory_order_release);
+            header_->magic = kMagic;
+        }
+        if (header_->magic != kMagic ||
+            sizeof(HeartbeatHeader) + header_->capacity * sizeof(HeartbeatSlot) > size_)
+        {
+            munmap(header_, size_);
+            throw std::runtime_error("HeartbeatTable: " + name + " is not a heartbeat table");
+        }
+    }
+
+    ~HeartbeatTable()
+    {
+        munmap(header_, size_);
+    }
+
+    HeartbeatTable(const HeartbeatTable&) = delete;
+    HeartbeatTable& operator=(const HeartbeatTable&) = delete;
+
+    static bool unlink(const std::string& name = kHeartbeatTable) { return shm_unlink(name.c_str()) == 0; }
+
+    uint32_t capacity() const { return header_->capacity; }
+    HeartbeatSlot& slot(uint32_t i) { return slots_[i]; }
+    const HeartbeatSlot& slot(uint32_t i) const { return slots_[i]; }
+
+private:
+    HeartbeatHeader* header_;
+    HeartbeatSlot* slots_;
+    size_t size_;
+};
+
+// A client's registration. Attaching under a name that is already active
+// takes that slot over, so a restarted process picks up where it left off.
+// Destroying the handle (a clean exit) detaches; a crash leaves the slot
+// active and overdue, which is the point.
+class Heartbeat
+{
+public:
+    Heartbeat(HeartbeatTable& table, const std::string& name, std::chrono::milliseconds deadline)
+        : slot_(nullptr), count_(0)
+    {
+        if (name.empty() || name.size() >= sizeof(slot_->name))
+        {
+            throw std::runtime_error("Heartbeat: bad client name '" + name + "'");
+        }
+        for (uint32_t i = 0; i < table.capacity() && !slot_; ++i)
+        {
+            HeartbeatSlot& s = table.slot(i);
+            if (s.state.load(std::memory_order_acquire) == HeartbeatSlot::kActive && name == s.name)
+            {
+                uint32_t expected = HeartbeatSlot::kActive;
+                if (s.state.compare_exchange_strong(expected, HeartbeatSlot::kClaimed, std::memory_order_acquire))
+                {
+                    slot_ = &s;
+                }
+            }
+        }
+        for (uint32_t i = 0; i < table.capacity() && !slot_; ++i)
+        {
+            HeartbeatSlot& s = table.slot(i);
+            uint32_t expected = HeartbeatSlot::kFree;
+            if (s.state.compare_exchange_strong(expected, HeartbeatSlot::kClaimed, std::memory_order_acquire))
+            {
+                slot_ = &s;
+            }
+        }
+        if (!slot_)
+        {
+            throw std::runtime_error("Heartbeat: table full");
+        }
+        memset(slot_->name, 0, sizeof(slot_->name));
+        memcpy(slot_->name, name.data(), name.size());
+        slot_->pid = static_cast<int32_t>(getpid());
+        slot_->deadlineNs = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline).count();
+        count_ = slot_->beats.load(std::memory_order_relaxed);
+        slot_->generation.fetch_add(1, std::memory_order_relaxed);
+        slot_->state.store(HeartbeatSlot::kActive, std::memory_order_release);
+    }
+
+    ~Heartbeat()
+    {
+        slot_->state.store(HeartbeatSlot::kFree, std::memory_order_release);
+    }
+
+    Heartbeat(const Heartbeat&) = delete;
+    Heartbeat& operator=(const Heartbeat&) = delete;
+
+    // This slot has one writer, so no read-modify-write is needed
+    void beat()
+    {
+        slot_->beats.store(++count_, std::memory_order_release);
+    }
+
+private:
+    HeartbeatSlot* slot_;
+    uint64_t count_;
+};
+
+// /dev/watchdog, or any writable fd standing in for it (a pipe in tests):
+// ioctls that fail with ENOTTY fall back to the write interface.
+// Closing without magicClose() leaves the timer running, so if the daemon
+// itself dies the machine is reset.
+class WatchdogDevice
+{
+public:
+    explicit WatchdogDevice(const std::string& path = "/dev/watchdog") : useWrite_(false)
+    {
+        fd_ = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd_ < 0)
+        {
+            throw std::runtime_error("WatchdogDevice: cannot open " + path + ": " + strerror(errno));
+        }
+    }
+
+    explicit WatchdogDevice(int fd) : fd_(fd), useWrite_(false)
+    {
+    }
+
+    ~WatchdogDevice()
+    {
+        if (fd_ >= 0)
+        {
+            close(fd_);
+        }
+    }
+
+    WatchdogDevice(const WatchdogDevice&) = delete;
+    WatchdogDevice& operator=(const WatchdogDevice&) = delete;
+
+    // The timeout the driver actually set (it may round), or -1
+    int setTimeout(int seconds)
+    {
+        int value = seconds;
+        if (ioctl(fd_, WDIOC_SETTIMEOUT, &value) < 0)
+        {
+            return -1;
+        }
+        return value;
+    }
+
+    int timeout() const
+    {
+        int value = -1;
+        return ioctl(fd_, WDIOC_GETTIMEOUT, &value) < 0 ? -1 : value;
+    }
+
+    bool keepalive()
+    {
+        if (!useWrite_)
+        {
+            int dummy = 0;
+            if (ioctl(fd_, WDIOC_KEEPALIVE, &dummy) == 0)
+            {
+                return true;
+            }
+            if (errno != ENOTTY && errno != EINVAL)
+            {
+                return false;
+            }
+            useWrite_ = true;
+        }
+        return write(fd_, "\0", 1) == 1;
+    }
+
+    // Write the magic character and close: drivers without nowayout stop
+    // the timer. For a clean shutdown only.
+    bool magicClose()
+    {
+        bool ok = write(fd_, "V", 1) == 1;
+        ok &= close(fd_) == 0;
+        fd_ = -1;
+        return ok;
+    }
+
+    bool isOpen() const { return fd_ >= 0; }
+
+private:
+    int fd_;
+    bool useWrite_;
+};
+
+struct WatchdogOptions
+{
+    std::chrono::seconds timeout{10};                ///< Hardware timeout set on start()
+    std::chrono::milliseconds check{1000};           ///< Sample heartbeats (and maybe pet) this often
+};
+
+// A client as the daemon last saw it
+struct ClientHealth
+{
+    std::string name;
+    int pid;
+    int64_t sinceBeatNs;    ///< Time since its counter last moved
+    int64_t deadlineNs;
+    bool attached;          ///< False once it has detached
+    bool healthy;           ///< Attached and within its deadline
+};
+
+// The daemon side, driven by an EventLoop timer
+class WatchdogManager
+{
+public:
+    // Called when a client goes overdue or recovers, and when one attaches or detaches
+    typedef std::function<void(const ClientHealth& client)> Listener;
+
+    WatchdogManager(EventLoop& loop, WatchdogDevice& device, HeartbeatTable& table, WatchdogOptions options = WatchdogOptions())
+        : loop_(loop), device_(device), table_(table), options_(options), timer_(-1), pets_(0), withheld_(0),
+          tracked_(table.capacity())
+    {
+    }
+
+    ~WatchdogManager()
+    {
+        if (timer_ >= 0)
+        {
+            loop_.cancelTimer(timer_);
+        }
+    }
+
+    WatchdogManager(const WatchdogManager&) = delete;
+    WatchdogManager& operator=(const WatchdogManager&) = delete;
+
+    void setListener(Listener listener) { listener_ = std::move(listener); }
+
+    // Arm the hardware and start checking; call from the loop thread. A
+    // device without WDIOC_SETTIMEOUT keeps its own timeout.
+    bool start()
+    {
+        int set = device_.setTimeout(static_cast<int>(options_.timeout.count()));
+        if (set < 0 && errno != ENOTTY)
+        {
+            perror("WatchdogManager: WDIOC_SETTIMEOUT");
+        }
+        check();
+        timer_ = loop_.addTimer(options_.check, options_.check, [this]() { check(); });
+        return timer_ >= 0;
+    }
+
+    // Sample every heartbeat; pet only if all attached clients are in time.
+    // Returns whether the device was fed.
+    bool check()
+    {
+        int64_t now = monotonicNs();
+        bool allHealthy = true;
+        for (uint32_t i = 0; i < table_.capacity(); ++i)
+        {
+            const HeartbeatSlot& slot = table_.slot(i);
+            Tracked& t = tracked_[i];
+            bool active = slot.state.load(std::memory_order_acquire) == HeartbeatSlot::kActive;
+            uint32_t generation = slot.generation.load(std::memory_order_relaxed);
+            if (!active)
+            {
+                if (t.active)
+                {
+                    t.active = false;
+                    notify(slot, t, now);
+                }
+                continue;
+            }
+            uint64_t beats = slot.beats.load(std::memory_order_acquire);
+            if (!t.active || t.generation != generation || beats != t.beats)
+            {
+                // New attach or progress: the deadline runs from now
+                bool attached = !t.active || t.generation != generation;
+                t.active = true;
+                t.generation = generation;
+                t.beats = beats;
+                t.lastProgress = now;
+                if (attached || !t.healthy)
+                {
+                    t.healthy = true;
+                    notify(slot, t, now);
+                }
+                continue;
+            }
+            if (now - t.lastProgress > slot.deadlineNs)
+            {
+                allHealthy = false;
+                if (t.healthy)
+                {
+                    t.healthy = false;
+                    notify(slot, t, now);
+                }
+            }
+        }
+        if (!allHealthy)
+        {
+            withheld_++;
+            return false;
+        }
+        if (!device_.keepalive())
+        {
+            perror("WatchdogManager: keepalive");
+            return false;
+        }
+        pets_++;
+        return true;
+    }
+
+    // Stop checking and disarm the hardware (magic close)
+    bool shutdown()
+    {
+        if (timer_ >= 0)
+        {
+            loop_.cancelTimer(timer_);
+            timer_ = -1;
+        }
+        return device_.isOpen() && device_.magicClose();
+    }
+
+    std::vector<ClientHealth> clients() const
+    {
+        std::vector<ClientHealth> out;
+        int64_t now = monotonicNs();
+        for (uint32_t i = 0; i < table_.capacity(); ++i)
+        {
+            if (tracked_[i].active)
+            {
+                out.push_back(health(table_.slot(i), tracked_[i], now));
+            }
+        }
+        return out;
+    }
+
+    uint64_t pets() const { return pets_; }
+    uint64_t withheld() const { return withheld_; }   ///< Checks that did not pet
+
+private:
+    struct Tracked
+    {
+        bool active = false;
+        bool healthy = true;
+        uint32_t generation = 0;
+        uint64_t beats = 0;
+        int64_t lastProgress = 0;
+    };
+
+    static int64_t monotonicNs()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+
+    static ClientHealth health(const HeartbeatSlot& slot, const Tracked& t, int64_t now)
+    {
+        ClientHealth h;
+        h.name = std::string(slot.name, strnlen(slot.name, sizeof(slot.name)));
+        h.pid = slot.pid;
+        h.sinceBeatNs = now - t.lastProgress;
+        h.deadlineNs = slot.deadlineNs;
+        h.attached = t.active;
+        h.healthy = t.active && t.healthy;
+        return h;
+    }
+
+    void notify(const HeartbeatSlot& slot, const Tracked& t, int64_t now)
+    {
+        if (listener_)
+        {
+            listener_(health(slot, t, now));
+        }
+    }
+
+    EventLoop& loop_;
+    WatchdogDevice& device_;
+    HeartbeatTable& table_;
+    WatchdogOptions options_;
+    Listener listener_;
+    int timer_;
+    uint64_t pets_;
+    uint64_t withheld_;
+    std::vector<Tracked> tracked_;
+};
@@ -0,0 +1,204 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include "Watchdog.hpp"
+
+static bool check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        std::cerr << "Self-test failed: " << what << std::endl;
+    }
+    return ok;
+}
+
+#define SELF_CHECK(cond) ok &= check((cond), #cond)
+
+using std::chrono::milliseconds;
+
+// A monitored worker: beats every 5 ms, except while hung
+static void worker(HeartbeatTable& table, const char* name, std::atomic<bool>& hung, std::atomic<bool>& done)
+{
+    Heartbeat hb(table, name, milliseconds(100));
+    while (!done)
+    {
+        if (!hung)
+        {
+            hb.beat();
+        }
+        std::this_thread::sleep_for(milliseconds(5));
+    }
+}
+
+static bool selfTest(const std::string& tableName)
+{
+    bool ok = true;
+    HeartbeatTable table(tableName, true, 16);
+
+    // Taking over a name reuses its slot; detaching frees it
+    {
+        Heartbeat first(table, "restarted", milliseconds(100));
+        Heartbeat second(table, "restarted", milliseconds(100));
+        int active = 0;
+        for (uint32_t i = 0; i < table.capacity(); ++i)
+        {
+            active += table.slot(i).state == HeartbeatSlot::kActive;
+        }
+        SELF_CHECK(active == 1);
+    }
+    SELF_CHECK(table.slot(0).state == HeartbeatSlot::kFree);
+
+    // The fake device is a pipe; pets arrive as '\0' and the magic close as 'V'
+    int pipeFds[2];
+    SELF_CHECK(pipe2(pipeFds, O_NONBLOCK | O_CLOEXEC) == 0);
+    WatchdogDevice device(pipeFds[1]);
+    SELF_CHECK(device.setTimeout(5) == -1 && errno == ENOTTY);
+
+    EventLoop loop;
+    WatchdogOptions options;
+    options.check = milliseconds(20);
+    WatchdogManager manager(loop, device, table, options);
+    std::vector<std::string> events;
+    manager.setListener([&](const ClientHealth& c)
+    {
+        events.push_back(c.name + (!c.attached ? " detached" : c.healthy ? " ok" : " overdue"));
+    });
+
+    // Worker b hangs from 300 ms to 600 ms; with a 100 ms deadline the pets
+    // must stop by about 420 ms and resume at about 600 ms
+    std::atomic<bool> aHung(false), bHung(false), done(false);
+    std::thread a(worker, std::ref(table), "a", std::ref(aHung), std::ref(done));
+    std::thread b(worker, std::ref(table), "b", std::ref(bHung), std::ref(done));
+    std::this_thread::sleep_for(milliseconds(20));
+    uint64_t atStart = 0, beforeHang = 0, hangEarly = 0, hangLate = 0;
+    loop.addTimer(milliseconds(0), milliseconds(0), [&]() { manager.start(); atStart = manager.pets(); });
+    loop.addTimer(milliseconds(280), milliseconds(0), [&]() { beforeHang = manager.pets(); });
+    loop.addTimer(milliseconds(300), milliseconds(0), [&]() { bHung = true; });
+    loop.addTimer(milliseconds(450), milliseconds(0), [&]() { hangEarly = manager.pets(); });
+    loop.addTimer(milliseconds(590), milliseconds(0), [&]() { hangLate = manager.pets(); });
+    loop.addTimer(milliseconds(600), milliseconds(0), [&]() { bHung = false; });
+    // A client that comes and goes cleanly does not block the pets
+    std::unique_ptr<Heartbeat> passing;
+    loop.addTimer(milliseconds(650), milliseconds(0), [&]() { passing.reset(new Heartbeat(table, "passing", milliseconds(500))); });
+    loop.addTimer(milliseconds(750), milliseconds(0), [&]() { passing.reset(); });
+    loop.addTimer(milliseconds(900), milliseconds(0), [&]() { loop.stop(); });
+    loop.run();
+    uint64_t atEnd = manager.pets();
+    std::vector<ClientHealth> clients = manager.clients();
+    SELF_CHECK(manager.shutdown());
+    done = true;
+    a.join();
+    b.join();
+
+    std::string written;
+    char buffer[4096];
+    for (ssize_t n; (n = read(pipeFds[0], buffer, sizeof(buffer))) > 0;)
+    {
+        written.append(buffer, static_cast<size_t>(n));
+    }
+    close(pipeFds[0]);
+
+    SELF_CHECK(beforeHang - atStart >= 10);
+    SELF_CHECK(hangLate == hangEarly);               // nothing fed while b was overdue
+    SELF_CHECK(atEnd - hangLate >= 8);               // and feeding resumed
+    SELF_CHECK(manager.withheld() >= 6);
+    SELF_CHECK(written.size() == atEnd + 1 && written.back() == 'V' && written.find('V') == atEnd);
+    SELF_CHECK(clients.size() == 2 && clients[0].healthy && clients[1].healthy);
+    std::string log;
+    for (const auto& e : events)
+    {
+        log += e + ", ";
+    }
+    SELF_CHECK(log == "a ok, b ok, b overdue, b ok, passing ok, passing detached, ");
+
+    std::cout << "Pets " << atEnd << ", withheld " << manager.withheld() << " (b hung for 300 ms); events: " << log
+              << "magic close written" << std::endl;
+    if (ok)
+    {
+        std::cout << "Self-test passed" << std::endl;
+    }
+    return ok;
+}
+
+template <typename Fn>
+static double nanosPer(size_t count, Fn fn)
+{
+    double best = 1e9;
+    for (int run = 0; run < 5; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn(count);
+        best = std::min(best, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count);
+    }
+    return best;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string tableName = "/watchdog-demo-" + std::to_string(getpid());
+    bool ok = selfTest(tableName);
+    if (!ok)
+    {
+        HeartbeatTable::unlink(tableName);
+        return 1;
+    }
+
+    // What a client pays per heartbeat: the shared-memory store, against a
+    // datagram to the daemon over a Unix socket
+    HeartbeatTable table(tableName);
+    Heartbeat hb(table, "bench", milliseconds(1000));
+    double shm = nanosPer(10000000, [&](size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            hb.beat();
+        }
+    });
+    int sv[2];
+    socketpair(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0, sv);
+    double sock = nanosPer(100000, [&](size_t count)
+    {
+        char c = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            send(sv[0], &c, 1, 0);
+            if (i % 64 == 63)
+            {
+                while (recv(sv[1], &c, 1, MSG_DONTWAIT) > 0)
+                {
+                }
+            }
+        }
+    });
+    close(sv[0]);
+    close(sv[1]);
+    HeartbeatTable::unlink(tableName);
+    std::cout << "ns per heartbeat: shared memory " << shm << ", Unix datagram " << sock << std::endl;
+
+    // Against a real device, e.g. after modprobe softdog: WatchdogDemo /dev/watchdog
+    if (argc > 1)
+    {
+        try
+        {
+            WatchdogDevice dog(argv[1]);
+            std::cout << "Timeout set to " << dog.setTimeout(5) << " s, reads back " << dog.timeout() << " s" << std::endl;
+            for (int i = 0; i < 3; ++i)
+            {
+                dog.keepalive();
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+            }
+            std::cout << (dog.magicClose() ? "Disarmed with magic close" : "Magic close failed") << std::endl;
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
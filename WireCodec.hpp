@@ -0,0 +1,224 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "ByteSwap.hpp"
+
+// Compile-time description of a packed binary wire format.
+//
+// A layout is declared once as a list of fields; offsets, total size and the
+// byte order of each field are all constants, so get<I>() on a received buffer
+// compiles down to an unaligned load plus (at most) a bswap.
+//
+//   using SensorHeader = WireLayout<
+//       Field<uint16_t>,                    // magic
+//       Field<uint8_t>,                     // version
+//       Pad<1>,
+//       Field<uint32_t>,                    // sequence
+//       Field<uint64_t>,                    // timestamp
+//       Field<uint32_t, Endian::Big, 3>,    // 24-bit length
+//       Field<float, Endian::Little>>;      // gain
+//
+//   uint32_t seq = SensorHeader::get<4>(buffer.data());
+
+enum class Endian
+{
+    Big,
+    Little
+};
+
+// One wire field: host type, wire byte order and wire width in bytes
+template <typename T, Endian E = Endian::Big, size_t Width = sizeof(T)>
+struct Field
+{
+    static_assert(std::is_trivially_copyable<T>::value, "wire fields must be trivially copyable");
+    static_assert(Width == sizeof(T) || (std::is_integral<T>::value && Width > 0 && Width < sizeof(T)),
+                  "narrow wire widths are only supported for integers");
+    typedef T type;
+    static constexpr Endian endian = E;
+    static constexpr size_t width = Width;
+};
+
+// Value type reported for padding fields
+struct Padding
+{
+};
+
+// N bytes of padding that are skipped on decode and zeroed on encode
+template <size_t N>
+struct Pad
+{
+    typedef Padding type;
+    static constexpr Endian endian = Endian::Big;
+    static constexpr size_t width = N;
+};
+
+namespace wire_detail
+{
+
+template <typename F>
+inline typename F::type readField(const unsigned char* p)
+{
+    typedef typename F::type T;
+    if constexpr (std::is_same<T, Padding>::value)
+    {
+        return Padding();
+    }
+    else if constexpr (F::width == sizeof(T))
+    {
+        return F::endian == Endian::Big ? loadBE<T>(p) : loadLE<T>(p);
+    }
+    else
+    {
+        // Narrow integer: assemble the bytes, then sign-extend if needed
+        uint64_t v = 0;
+        for (size_t i = 0; i < F::width; ++i)
+        {
+            size_t shift = F::endian == Endian::Big ? (F::width - 1 - i) * 8 : i * 8;
+            v |= static_cast<uint64_t>(p[i]) << shift;
+        }
+        if constexpr (std::is_signed<T>::value)
+        {
+            const unsigned bits = F::width * 8;
+            const uint64_t sign = 1ULL << (bits - 1);
+            v = (v ^ sign) - sign;
+        }
+        return static_cast<T>(v);
+    }
+}
+
+template <typename F>
+inline void writeField(unsigned char* p, typename F::type value)
+{
+    typedef typename F::type T;
+    if constexpr (std::is_same<T, Padding>::value)
+    {
+        std::memset(p, 0, F::width);
+    }
+    else if constexpr (F::width == sizeof(T))
+    {
+        if (F::endian == Endian::Big)
+        {
+            storeBE<T>(p, value);
+        }
+        else
+        {
+            storeLE<T>(p, value);
+        }
+    }
+    else
+    {
+        uint64_t v = static_cast<uint64_t>(value);
+        for (size_t i = 0; i < F::width; ++i)
+        {
+            size_t shift = F::endian == Endian::Big ? (F::width - 1 - i) * 8 : i * 8;
+            p[i] = static_cast<unsigned char>(v >> shift);
+        }
+    }
+}
+
+} // namespace wire_detail
+
+template <typename... Fields>
+struct WireLayout
+{
+    static constexpr size_t count = sizeof...(Fields);
+    static constexpr size_t size = (Fields::width + ... + 0);
+
+    template <size_t I>
+    using field = typename std::tuple_element<I, std::tuple<Fields...>>::type;
+
+    template <size_t I>
+    using type = typename field<I>::type;
+
+    // Host-side values of every field, in declaration order
+    typedef std::tuple<typename Fields::type...> Values;
+
+    template <size_t I>
+    static constexpr size_t offset()
+    {
+        constexpr size_t widths[] = {Fields::width..., 0};
+        size_t off = 0;
+        for (size_t i = 0; i < I; ++i)
+        {
+            off += widths[i];
+        }
+        return off;
+    }
+
+    // Read field I straight out of a buffer holding at least size bytes
+    template <size_t I>
+    static type<I> get(const void* buf)
+    {
+        constexpr size_t off = offset<I>();
+        return wire_detail::readField<field<I>>(static_cast<const unsigned char*>(buf) + off);
+    }
+
+    // Write field I into a buffer holding at least size bytes
+    template <size_t I>
+    static void set(void* buf, type<I> value)
+    {
+        constexpr size_t off = offset<I>();
+        wire_detail::writeField<field<I>>(static_cast<unsigned char*>(buf) + off, value);
+    }
+
+    static Values decode(const void* buf)
+    {
+        return decodeImpl(buf, std::index_sequence_for<Fields...>());
+    }
+
+    static void encode(void* buf, const Values& values)
+    {
+        encodeImpl(buf, values, std::index_sequence_for<Fields...>());
+    }
+
+private:
+    template <size_t... Is>
+    static Values decodeImpl(const void* buf, std::index_sequence<Is...>)
+    {
+        return Values(get<Is>(buf)...);
+    }
+
+    template <size_t... Is>
+    static void encodeImpl(void* buf, const Values& values, std::index_sequence<Is...>)
+    {
+        (set<Is>(buf, std::get<Is>(values)), ...);
+    }
+};
+
+// Zero-copy read-only view of one record inside a received buffer
+template <typename Layout>
+class WireView
+{
+public:
+    explicit WireView(const void* data) : data_(static_cast<const unsigned char*>(data))
+    {
+    }
+
+    // True when a datagram of the given length holds a complete record
+    static bool fits(size_t length)
+    {
+        return length >= Layout::size;
+    }
+
+    template <size_t I>
+    typename Layout::template type<I> get() const
+    {
+        return Layout::template get<I>(data_);
+    }
+
+    const unsigned char* data() const { return data_; }
+
+    // View of the record immediately following this one
+    WireView next() const
+    {
+        return WireView(data_ + Layout::size);
+    }
+
+private:
+    const unsigned char* data_;
+};
@@ -1,84 +1,108 @@
 #include <iostream>
-#include <fstream>
 #include <string>
-#include <sstream>
 #include <vector>
-#include <stack>
+#include "XmlConfigRead.hpp"
+#include "XmlPullParser.hpp"
+#include "XmlDocument.hpp"
+#include "XmlConfigWatcher.hpp"
+#include <csignal>
 
-std::vector < std::string > parseXML(const std::string & xmlData) 
+// Print the elements matching an XmlDocument path query, e.g.
+// "config/forwarder/destination[@port]"
+static int printQuery(const std::string & path, const std::string & query) 
 {
-  std::vector < std::string > tokens;
-  std::string token;
-  std::stack < char > tagStack;
-  bool isTag = false;
-  bool isClosingTag = false;
-
-  for (char c: xmlData) 
+  XmlDocument doc = XmlDocument::load(path);
+  std::vector < XmlNode > matches = doc.query(query);
+  for (const XmlNode & node: matches) 
   {
-    if (c == '<') 
-    {
-      if (!token.empty()) 
-      {
-        tokens.push_back(token);
-        token.clear();
-      }
-      isTag = true;
-      if (tagStack.empty() || tagStack.top() != '/') 
-      {
-        tagStack.push(c);
-      } 
-      else 
-      {
-        isClosingTag = true;
-        tagStack.pop();
-      }
-    } 
-    else
-    if (c == '>') 
+    std::cout << node.name();
+    for (size_t i = 0; i < node.attributeCount(); ++i) 
     {
-      if (isTag) 
-      {
-        tokens.push_back(token);
-        token.clear();
-      }
-      isTag = false;
-      isClosingTag = false;
-      if (!tagStack.empty()) 
-      {
-        tagStack.pop();
-      }
-    } 
-    else
-    if (isTag) 
-    {
-      token += c;
-    } 
-    else 
+      std::cout << " " << node.attributeName(i) << "=" << node.attributeValue(i);
+    }
+    if (!node.text().empty()) 
     {
-      token += c;
+      std::cout << ": " << node.text();
     }
+    std::cout << std::endl;
   }
+  return matches.empty() ? 1 : 0;
+}
 
-  if (!token.empty()) 
+// Follow edits to the file and print only the parts that changed under
+// prefix (e.g. "config/forwarder"), until interrupted
+static int watchConfig(const std::string & path, const std::string & prefix) 
+{
+  EventLoop loop;
+  XmlConfigWatcher watcher(loop, path);
+  watcher.subscribe(prefix, [](const std::vector < XmlChange > & changes) 
   {
-    tokens.push_back(token);
+    static const char * kinds[] = {"added", "removed", "modified"};
+    for (const XmlChange & change: changes) 
+    {
+      std::cout << kinds[change.kind] << " " << change.path << std::endl;
+    }
+  });
+  if (!watcher.start()) 
+  {
+    std::cerr << path << ": " << watcher.error() << std::endl;
+    return 1;
   }
-
-  return tokens;
+  loop.addSignal(SIGINT, [&](const struct signalfd_siginfo &) { loop.stop(); });
+  loop.addSignal(SIGTERM, [&](const struct signalfd_siginfo &) { loop.stop(); });
+  std::cout << "Watching " << path << " (" << watcher.document() -> nodeCount() << " nodes)" << std::endl;
+  loop.run();
+  return 0;
 }
 
-int main() 
+int main(int argc, char ** argv) 
 {
-  std::ifstream file("input.xml");
-  std::stringstream buffer;
-  buffer << file.rdbuf();
-  std::string xmlData = buffer.str();
+  if (argc > 1 && std::string(argv[1]) == "--watch") 
+  {
+    return watchConfig(argc > 2 ? argv[2] : "input.xml", argc > 3 ? argv[3] : "");
+  }
 
-  std::vector < std::string > tokens = parseXML(xmlData);
+  std::string path = argc > 1 ? argv[1] : "input.xml";
+  try 
+  {
+    if (argc > 2) 
+    {
+      return printQuery(path, argv[2]);
+    }
 
-  for (const std::string & token: tokens) 
+    MappedFile file(path);
+    XmlPullParser parser(file.view());
+
+    for (XmlEvent event = parser.next(); event != XmlEvent::EndDocument; event = parser.next()) 
+    {
+      std::string indent(2 * parser.depth(), ' ');
+      switch (event) 
+      {
+      case XmlEvent::StartElement:
+        std::cout << indent.substr(2) << parser.name();
+        for (size_t i = 0; i < parser.attributeCount(); ++i) 
+        {
+          const XmlAttribute & attr = parser.attribute(i);
+          std::cout << " " << attr.name << "=" << XmlPullParser::decode(attr.value);
+        }
+        std::cout << std::endl;
+        break;
+      case XmlEvent::Text:
+      case XmlEvent::CData:
+        std::cout << indent << (parser.textHasEntities() ? XmlPullParser::decode(parser.text()) : std::string(parser.text())) << std::endl;
+        break;
+      case XmlEvent::Error:
+        std::cerr << path << ": " << parser.errorMessage() << std::endl;
+        return 1;
+      default:
+        break;
+      }
+    }
+  } 
+  catch (const std::exception & e) 
   {
-    std::cout << token << std::endl;
+    std::cerr << e.what() << std::endl;
+    return 1;
   }
 
   return 0;
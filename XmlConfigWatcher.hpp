@@ -0,0 +1,546 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include "EventLoop.hpp"
+#include "XmlDocument.hpp"
+
+namespace xml_detail
+{
+
+inline uint64_t mix64(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Non-cryptographic 64-bit hash, 8 bytes per step
+inline uint64_t hashBytes(const char* p, size_t n, uint64_t seed = 0)
+{
+    uint64_t h = seed ^ (n * 0x9E3779B97F4A7C15ULL);
+    for (; n >= 8; p += 8, n -= 8)
+    {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        h = ((h << 31 | h >> 33) ^ w) * 0x9E3779B97F4A7C15ULL;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, p, n);
+    return mix64(h ^ tail);
+}
+
+inline uint64_t hashView(std::string_view s, uint64_t seed)
+{
+    return hashBytes(s.data(), s.size(), seed);
+}
+
+} // namespace xml_detail
+
+struct XmlChange
+{
+    enum Kind
+    {
+        Added,      ///< Only after is valid
+        Removed,    ///< Only before is valid
+        Modified    ///< Name, attributes or text of the element changed; both valid
+    };
+
+    Kind kind;
+    std::string path;   ///< Path query selecting the element, e.g. config/forwarder[@id='3']
+    XmlNode before;     ///< Element in the previous document (valid during delivery only)
+    XmlNode after;      ///< Element in the new document
+};
+
+// Structural diff of two XmlDocuments. Every element gets a hash of its
+// own content (name, attributes, text) and one of its whole subtree, so
+// identical subtrees are skipped without being walked. Siblings are paired
+// by name plus their "id" or "name" attribute, or by position among
+// same-named siblings when they have neither. A change to an element's own
+// content is reported once for that element rather than for its children;
+// a pure reordering of siblings is not reported.
+class XmlDiff
+{
+public:
+    explicit XmlDiff(const XmlDocument& doc) : doc_(&doc)
+    {
+        size_t n = doc.nodeCount();
+        own_.assign(n, 0);
+        subtree_.assign(n, 0);
+        // Children have larger indices than their parent, so walking backwards
+        // sees every subtree before the node that owns it
+        for (size_t i = n; i-- > 0;)
+        {
+            XmlNode node = doc.node(i);
+            if (!node.isElement())
+            {
+                continue;
+            }
+            uint64_t own = xml_detail::hashView(node.name(), 1);
+            for (size_t a = 0; a < node.attributeCount(); ++a)
+            {
+                own = xml_detail::hashView(node.attributeName(a), own);
+                own = xml_detail::hashView(node.attributeValue(a), own);
+            }
+            uint64_t sub = 0;
+            for (XmlNode c : node.children())
+            {
+                if (c.isText())
+                {
+                    own = xml_detail::hashView(c.text(), own);
+                }
+                else
+                {
+                    sub = xml_detail::mix64(sub ^ subtree_[c.index()]) + 1;
+                }
+            }
+            own_[i] = own;
+            subtree_[i] = xml_detail::mix64(own ^ (sub * 0x9E3779B97F4A7C15ULL));
+        }
+    }
+
+    const XmlDocument& document() const { return *doc_; }
+    uint64_t subtreeHash(XmlNode n) const { return subtree_[n.index()]; }
+    uint64_t ownHash(XmlNode n) const { return own_[n.index()]; }
+
+    // Changes turning before into after
+    static std::vector<XmlChange> compare(const XmlDiff& before, const XmlDiff& after)
+    {
+        std::vector<XmlChange> changes;
+        XmlNode a = before.doc_->root();
+        XmlNode b = after.doc_->root();
+        if (a.name() != b.name())
+        {
+            changes.push_back(XmlChange{XmlChange::Removed, std::string(a.name()), a, XmlNode()});
+            changes.push_back(XmlChange{XmlChange::Added, std::string(b.name()), XmlNode(), b});
+            return changes;
+        }
+        diffNode(before, after, a, b, std::string(a.name()), changes);
+        return changes;
+    }
+
+private:
+    // How an element is told apart from its siblings. position only names it
+    // in paths; matching ignores it so an inserted keyed sibling does not
+    // renumber the unkeyed ones.
+    struct Key
+    {
+        std::string_view name;
+        std::string_view attr;    ///< "id", "name" or empty
+        std::string_view value;   ///< Value of attr, or empty
+        uint32_t ordinal;         ///< 1-based among same-named siblings without attr
+        uint32_t position;        ///< 1-based among all same-named siblings, as query() counts
+
+        bool operator==(const Key& o) const
+        {
+            return name == o.name && attr == o.attr && value == o.value && ordinal == o.ordinal;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& k) const
+        {
+            uint64_t h = xml_detail::hashView(k.name, k.ordinal);
+            return static_cast<size_t>(xml_detail::hashView(k.value, h));
+        }
+    };
+
+    static void keys(XmlNode parent, std::vector<XmlNode>& nodes, std::vector<Key>& out)
+    {
+        std::unordered_map<std::string_view, uint32_t> seen, all;
+        nodes.reserve(parent.childCount());
+        out.reserve(parent.childCount());
+        for (XmlNode c : parent.children())
+        {
+            if (!c.isElement())
+            {
+                continue;
+            }
+            Key k{c.name(), std::string_view(), std::string_view(), 0, ++all[c.name()]};
+            if (c.hasAttribute("id"))
+            {
+                k.attr = "id";
+            }
+            else if (c.hasAttribute("name"))
+            {
+                k.attr = "name";
+            }
+            if (!k.attr.empty())
+            {
+                k.value = c.attribute(k.attr);
+            }
+            else
+            {
+                k.ordinal = ++seen[k.name];
+            }
+            nodes.push_back(c);
+            out.push_back(k);
+        }
+    }
+
+    // Path step selecting the element. The predicate syntax has no escapes,
+    // so a value holding both quote kinds, or a ']', falls back to position.
+    static std::string step(const Key& k)
+    {
+        std::string s(k.name);
+        bool quotable = k.value.find(']') == std::string_view::npos &&
+                        (k.value.find('\'') == std::string_view::npos || k.value.find('"') == std::string_view::npos);
+        if (!k.attr.empty() && quotable)
+        {
+            char quote = k.value.find('\'') == std::string_view::npos ? '\'' : '"';
+            s += "[@" + std::string(k.attr) + "=" + quote + std::string(k.value) + quote + "]";
+        }
+        else
+        {
+            s += "[" + std::to_string(k.position) + "]";
+        }
+        return s;
+    }
+
+    static void diffNode(const XmlDiff& before, const XmlDiff& after, XmlNode a, XmlNode b,
+                         const std::string& path, std::vector<XmlChange>& changes)
+    {
+        if (before.subtreeHash(a) == after.subtreeHash(b))
+        {
+            return;
+        }
+        if (before.ownHash(a) != after.ownHash(b))
+        {
+            changes.push_back(XmlChange{XmlChange::Modified, path, a, b});
+            return;
+        }
+
+        std::vector<XmlNode> oldNodes, newNodes;
+        std::vector<Key> oldKeys, newKeys;
+        keys(a, oldNodes, oldKeys);
+        keys(b, newNodes, newKeys);
+
+        // Common case: the same children in the same order
+        if (oldKeys == newKeys)
+        {
+            for (size_t i = 0; i < oldNodes.size(); ++i)
+            {
+                if (before.subtreeHash(oldNodes[i]) != after.subtreeHash(newNodes[i]))
+                {
+                    diffNode(before, after, oldNodes[i], newNodes[i], path + "/" + step(oldKeys[i]), changes);
+                }
+            }
+            return;
+        }
+
+        std::unordered_map<Key, size_t, KeyHash> index;
+        for (size_t i = 0; i < oldKeys.size(); ++i)
+        {
+            index.emplace(oldKeys[i], i);
+        }
+        std::vector<bool> matched(oldNodes.size(), false);
+        for (size_t i = 0; i < newNodes.size(); ++i)
+        {
+            auto it = index.find(newKeys[i]);
+            if (it == index.end() || matched[it->second])
+            {
+                changes.push_back(XmlChange{XmlChange::Added, path + "/" + step(newKeys[i]), XmlNode(), newNodes[i]});
+                continue;
+            }
+            matched[it->second] = true;
+            diffNode(before, after, oldNodes[it->second], newNodes[i], path + "/" + step(newKeys[i]), changes);
+        }
+        for (size_t i = 0; i < oldNodes.size(); ++i)
+        {
+            if (!matched[i])
+            {
+                changes.push_back(XmlChange{XmlChange::Removed, path + "/" + step(oldKeys[i]), oldNodes[i], XmlNode()});
+            }
+        }
+    }
+
+    const XmlDocument* doc_;
+    std::vector<uint64_t> own_;
+    std::vector<uint64_t> subtree_;
+};
+
+// Watches an XML config file with inotify and tells subscribers which
+// parts of it changed.
+//
+// The directory is watched rather than the file, so editors that save by
+// writing a temporary file and renaming it over the original are handled.
+// On every close-after-write or rename the file is read and hashed; the
+// document is only re-parsed when the hash differs from the last load, and
+// only the subtrees that differ (see XmlDiff) are delivered. A file that
+// fails to parse leaves the previous document in place.
+class XmlConfigWatcher
+{
+public:
+    typedef std::function<void(const std::vector<XmlChange>& changes)> Handler;
+
+    XmlConfigWatcher(EventLoop& loop, const std::string& path) : loop_(loop), path_(path)
+    {
+        size_t slash = path.rfind('/');
+        dir_ = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+        file_ = slash == std::string::npos ? path : path.substr(slash + 1);
+    }
+
+    ~XmlConfigWatcher()
+    {
+        if (inotifyFd_ >= 0)
+        {
+            loop_.removeFd(inotifyFd_);
+            close(inotifyFd_);
+        }
+    }
+
+    XmlConfigWatcher(const XmlConfigWatcher&) = delete;
+    XmlConfigWatcher& operator=(const XmlConfigWatcher&) = delete;
+
+    // Load the file and start watching; false if either fails (see error())
+    bool start()
+    {
+        inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd_ < 0 ||
+            inotify_add_watch(inotifyFd_, dir_.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+        {
+            error_ = "inotify on " + dir_ + ": " + strerror(errno);
+            return false;
+        }
+        loop_.addFd(inotifyFd_, EPOLLIN, [this](uint32_t) { onNotify(); });
+        reload();
+        return current_ != nullptr;
+    }
+
+    // Receive changes at or below prefix ("config/forwarder"; "" for all).
+    // Steps without a predicate match any predicate, and a change to an
+    // ancestor of prefix is delivered too since it contains the subtree.
+    int subscribe(const std::string& prefix, Handler handler)
+    {
+        subscribers_.push_back(Subscriber{nextId_, prefix, std::move(handler)});
+        return nextId_++;
+    }
+
+    void unsubscribe(int id)
+    {
+        for (size_t i = 0; i < subscribers_.size(); ++i)
+        {
+            if (subscribers_[i].id == id)
+            {
+                subscribers_.erase(subscribers_.begin() + static_cast<std::ptrdiff_t>(i));
+                return;
+            }
+        }
+    }
+
+    // Check the file now; true if the document changed
+    bool reload()
+    {
+        checks_++;
+        std::string text;
+        if (!readFile(text))
+        {
+            return false;
+        }
+        uint64_t hash = xml_detail::hashBytes(text.data(), text.size());
+        if (current_ && hash == hash_)
+        {
+            return false;
+        }
+
+        std::unique_ptr<Loaded> next(new Loaded());
+        try
+        {
+            next->doc.reset(new XmlDocument(XmlDocument::parse(std::move(text))));
+        }
+        catch (const std::exception& e)
+        {
+            error_ = e.what();
+            failures_++;
+            return false;
+        }
+        next->diff.reset(new XmlDiff(*next->doc));
+        parses_++;
+        hash_ = hash;
+        error_.clear();
+
+        std::unique_ptr<Loaded> previous = std::move(current_);
+        current_ = std::move(next);
+        if (previous)
+        {
+            // The previous document stays alive until subscribers have seen it
+            deliver(XmlDiff::compare(*previous->diff, *current_->diff));
+        }
+        return true;
+    }
+
+    // Current document, nullptr before the first successful load
+    const XmlDocument* document() const { return current_ ? current_->doc.get() : nullptr; }
+
+    const std::string& error() const { return error_; }
+    uint64_t checks() const { return checks_; }     ///< Notifications handled
+    uint64_t parses() const { return parses_; }     ///< Loads whose hash differed
+    uint64_t failures() const { return failures_; } ///< Loads that did not parse
+
+    // True if a change at changePath concerns a subscriber of prefix
+    static bool concerns(std::string_view prefix, std::string_view changePath)
+    {
+        while (!prefix.empty() && !changePath.empty())
+        {
+            std::string_view s = firstStep(prefix);
+            std::string_view c = firstStep(changePath);
+            if (s.find('[') == std::string_view::npos ? c.substr(0, c.find('[')) != s : c != s)
+            {
+                return false;
+            }
+            prefix.remove_prefix(std::min(prefix.size(), s.size() + 1));
+            changePath.remove_prefix(std::min(changePath.size(), c.size() + 1));
+        }
+        return true;
+    }
+
+private:
+    struct Loaded
+    {
+        std::unique_ptr<XmlDocument> doc;
+        std::unique_ptr<XmlDiff> diff;
+    };
+
+    struct Subscriber
+    {
+        int id;
+        std::string prefix;
+        Handler handler;
+    };
+
+    // Up to the first '/' outside a predicate
+    static std::string_view firstStep(std::string_view path)
+    {
+        char quote = 0;
+        for (size_t i = 0; i < path.size(); ++i)
+        {
+            char ch = path[i];
+            if (quote)
+            {
+                quote = ch == quote ? 0 : quote;
+            }
+            else if (ch == '\'' || ch == '"')
+            {
+                quote = ch;
+            }
+            else if (ch == '/')
+            {
+                return path.substr(0, i);
+            }
+        }
+        return path;
+    }
+
+    // The file is read rather than mapped: writers that truncate and rewrite
+    // it in place would otherwise change the text under the live document
+    bool readFile(std::string& text)
+    {
+        int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) < 0)
+        {
+            error_ = path_ + ": " + strerror(errno);
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            return false;
+        }
+        text.resize(static_cast<size_t>(st.st_size));
+        size_t done = 0;
+        while (done < text.size())
+        {
+            ssize_t n = read(fd, &text[done], text.size() - done);
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                break; // shrank while reading; parse what is there
+            }
+            done += static_cast<size_t>(n);
+        }
+        close(fd);
+        text.resize(done);
+        return true;
+    }
+
+    void onNotify()
+    {
+        alignas(struct inotify_event) char buf[4096];
+        bool relevant = false;
+        ssize_t n;
+        while ((n = read(inotifyFd_, buf, sizeof(buf))) > 0)
+        {
+            for (char* p = buf; p < buf + n;)
+            {
+                const struct inotify_event* ev = reinterpret_cast<const struct inotify_event*>(p);
+                if (ev->len > 0 && file_ == ev->name)
+                {
+                    relevant = true;
+                }
+                p += sizeof(struct inotify_event) + ev->len;
+            }
+        }
+        // Several events for one save collapse into one check
+        if (relevant)
+        {
+            reload();
+        }
+    }
+
+    void deliver(const std::vector<XmlChange>& changes)
+    {
+        if (changes.empty())
+        {
+            return;
+        }
+        std::vector<XmlChange> selected;
+        std::vector<Subscriber> subscribers = subscribers_; // handlers may unsubscribe
+        for (const auto& s : subscribers)
+        {
+            selected.clear();
+            for (const auto& c : changes)
+            {
+                if (concerns(s.prefix, c.path))
+                {
+                    selected.push_back(c);
+                }
+            }
+            if (!selected.empty())
+            {
+                s.handler(selected);
+            }
+        }
+    }
+
+    EventLoop& loop_;
+    std::string path_;
+    std::string dir_;
+    std::string file_;
+    int inotifyFd_ = -1;
+    std::unique_ptr<Loaded> current_;
+    uint64_t hash_ = 0;
+    std::vector<Subscriber> subscribers_;
+    int nextId_ = 1;
+    std::string error_;
+    uint64_t checks_ = 0;
+    uint64_t parses_ = 0;
+    uint64_t failures_ = 0;
+};
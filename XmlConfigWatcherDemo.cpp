@@ -0,0 +1,205 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <sys/stat.h>
+#include "XmlConfigWatcher.hpp"
+#include "XmlConfigRead.hpp"
+
+static const char* kDir = "/tmp/xml_config_watcher_demo";
+
+static std::string makeConfig(int forwarders, int firstId, const std::string& level, int editedPort)
+{
+    std::string doc = "<config>\n  <logging level=\"" + level + "\"/>\n";
+    for (int i = firstId; i < firstId + forwarders; ++i)
+    {
+        int port = i == 2 ? editedPort : 7000 + i % 1000;
+        doc += "  <forwarder id=\"" + std::to_string(i) + "\">\n"
+               "    <listen port=\"" + std::to_string(5000 + i % 1000) + "\"/>\n"
+               "    <destination host=\"10.0." + std::to_string(i % 255) + ".1\" port=\"" + std::to_string(port) + "\"/>\n"
+               "  </forwarder>\n";
+    }
+    return doc + "</config>\n";
+}
+
+static void writeFile(const std::string& path, const std::string& text)
+{
+    std::ofstream(path) << text;
+}
+
+// Editors commonly save by writing a temporary file and renaming it
+static void replaceFile(const std::string& path, const std::string& text)
+{
+    writeFile(path + ".tmp", text);
+    std::rename((path + ".tmp").c_str(), path.c_str());
+}
+
+static bool check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        std::cerr << "Self-test failed: " << what << std::endl;
+    }
+    return ok;
+}
+
+#define SELF_CHECK(cond) ok &= check((cond), #cond)
+
+static bool selfTest()
+{
+    bool ok = true;
+    std::string path = std::string(kDir) + "/config.xml";
+    writeFile(path, makeConfig(3, 1, "info", 7002));
+
+    EventLoop loop;
+    XmlConfigWatcher watcher(loop, path);
+    std::vector<XmlChange> forwarders, logging;
+    std::string lastPort;
+    watcher.subscribe("config/forwarder", [&](const std::vector<XmlChange>& changes)
+    {
+        forwarders.insert(forwarders.end(), changes.begin(), changes.end());
+        for (const auto& c : changes)
+        {
+            if (c.kind == XmlChange::Modified)
+            {
+                lastPort = std::string(c.after.attribute("port"));
+            }
+        }
+    });
+    watcher.subscribe("config/logging", [&](const std::vector<XmlChange>& changes)
+    {
+        logging.insert(logging.end(), changes.begin(), changes.end());
+    });
+    SELF_CHECK(watcher.start());
+
+    // Each step makes an edit; the next step checks what it delivered
+    std::vector<std::function<void()>> steps;
+    steps.push_back([&]() { writeFile(path, makeConfig(3, 1, "info", 9999)); });
+    steps.push_back([&]()
+    {
+        SELF_CHECK(forwarders.size() == 1 && logging.empty());
+        SELF_CHECK(forwarders.size() == 1 && forwarders[0].kind == XmlChange::Modified);
+        SELF_CHECK(forwarders.size() == 1 && forwarders[0].path == "config/forwarder[@id='2']/destination[1]");
+        SELF_CHECK(lastPort == "9999");
+        forwarders.clear();
+        writeFile(path, makeConfig(3, 1, "info", 9999)); // same bytes again
+    });
+    steps.push_back([&]()
+    {
+        SELF_CHECK(forwarders.empty() && watcher.parses() == 2);
+        replaceFile(path, makeConfig(3, 2, "info", 9999)); // drops id 1, adds id 4
+    });
+    steps.push_back([&]()
+    {
+        SELF_CHECK(forwarders.size() == 2 && logging.empty());
+        SELF_CHECK(forwarders.size() == 2 && forwarders[0].kind == XmlChange::Added &&
+                   forwarders[0].path == "config/forwarder[@id='4']");
+        SELF_CHECK(forwarders.size() == 2 && forwarders[1].kind == XmlChange::Removed &&
+                   forwarders[1].path == "config/forwarder[@id='1']");
+        forwarders.clear();
+        writeFile(path, "<config><logging level='debug'>"); // truncated save
+    });
+    steps.push_back([&]()
+    {
+        SELF_CHECK(watcher.failures() == 1 && !watcher.error().empty());
+        SELF_CHECK(watcher.document()->query("config/forwarder").size() == 3);
+        writeFile(path, makeConfig(3, 2, "debug", 9999));
+    });
+    steps.push_back([&]()
+    {
+        SELF_CHECK(logging.size() == 1 && forwarders.empty());
+        SELF_CHECK(logging.size() == 1 && logging[0].before.attribute("level") == "info" &&
+                   logging[0].after.attribute("level") == "debug");
+        loop.stop();
+    });
+
+    size_t next = 0;
+    loop.addTimer(std::chrono::milliseconds(20), std::chrono::milliseconds(20), [&]() { steps[next++](); });
+    loop.run();
+
+    SELF_CHECK(XmlConfigWatcher::concerns("", "config"));
+    SELF_CHECK(XmlConfigWatcher::concerns("config/forwarder", "config"));
+    SELF_CHECK(XmlConfigWatcher::concerns("config/forwarder[@id='2']", "config/forwarder[@id='2']/listen[1]"));
+    SELF_CHECK(!XmlConfigWatcher::concerns("config/forwarder[@id='2']", "config/forwarder[@id='3']"));
+    SELF_CHECK(!XmlConfigWatcher::concerns("config/forwarder", "config/logging[1]"));
+
+    // Reported paths select the changed element again: positions count keyed
+    // siblings too, and a value with a quote in it is quoted the other way
+    XmlDocument before = XmlDocument::parse("<config><route id='a'/><route>x</route><route name=\"it's\">1</route>"
+                                            "<route name='&apos;&quot;'>1</route></config>");
+    XmlDocument after = XmlDocument::parse("<config><route id='a'/><route>y</route><route name=\"it's\">2</route>"
+                                           "<route name='&apos;&quot;'>2</route></config>");
+    std::vector<XmlChange> changes = XmlDiff::compare(XmlDiff(before), XmlDiff(after));
+    SELF_CHECK(changes.size() == 3);
+    SELF_CHECK(changes.size() == 3 && changes[0].path == "config/route[2]" &&
+               changes[1].path == "config/route[@name=\"it's\"]" && changes[2].path == "config/route[4]");
+    for (const auto& c : changes)
+    {
+        std::vector<XmlNode> found = after.query(c.path);
+        SELF_CHECK(found.size() == 1 && found[0] == c.after);
+    }
+    std::remove(path.c_str());
+    if (ok)
+    {
+        std::cout << "Self-test passed (" << watcher.checks() << " checks, " << watcher.parses() << " parses)" << std::endl;
+    }
+    return ok;
+}
+
+template <typename Fn>
+static double milliseconds(Fn fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+    mkdir(kDir, 0755);
+    if (!selfTest())
+    {
+        return 1;
+    }
+
+    // A large config where one destination port changes between saves
+    std::string path = std::string(kDir) + "/large.xml";
+    std::string before = makeConfig(300000, 1, "info", 7002);
+    std::string after = makeConfig(300000, 1, "info", 9999);
+    writeFile(path, before);
+
+    EventLoop loop;
+    XmlConfigWatcher watcher(loop, path);
+    size_t delivered = 0;
+    watcher.subscribe("config/forwarder", [&](const std::vector<XmlChange>& changes) { delivered += changes.size(); });
+    watcher.start();
+
+    // Best of three saves, alternating between the two versions
+    double unchanged = 1e9, changed = 1e9, legacy = 1e9;
+    for (int run = 0; run < 3; ++run)
+    {
+        writeFile(path, run % 2 ? before : after);
+        changed = std::min(changed, milliseconds([&]() { watcher.reload(); }));
+        unchanged = std::min(unchanged, milliseconds([&]() { watcher.reload(); }));
+        legacy = std::min(legacy, milliseconds([&]()
+        {
+            std::ifstream in(path);
+            std::stringstream buffer;
+            buffer << in.rdbuf();
+            parseXML(buffer.str());
+        }));
+    }
+
+    std::cout << "Config: " << after.size() / (1 << 20) << " MiB, " << watcher.document()->nodeCount() << " nodes" << std::endl;
+    std::cout << "Unchanged save (hash only):   " << unchanged << " ms" << std::endl;
+    std::cout << "One edit (hash, parse, diff): " << changed << " ms, " << delivered / 3 << " change delivered per save" << std::endl;
+    std::cout << "Full re-read with parseXML:   " << legacy << " ms, every subsystem re-initialized" << std::endl;
+    std::remove(path.c_str());
+    rmdir(kDir);
+    return delivered == 3 ? 0 : 1;
+}
@@ -0,0 +1,692 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "XmlPullParser.hpp"
+
+class XmlDocument;
+
+// Lightweight handle to an element or text node of an XmlDocument
+class XmlNode
+{
+public:
+    class Range;
+
+    XmlNode() = default;
+
+    bool valid() const { return doc_ != nullptr; }
+    explicit operator bool() const { return valid(); }
+
+    bool isElement() const;
+    bool isText() const;
+
+    // Qualified element name as written ("fw:forwarder"); empty for text
+    std::string_view name() const;
+    std::string_view localName() const;
+
+    // Text node content, or the first text child of an element; entities decoded
+    std::string_view text() const;
+
+    // Attribute value by qualified or local name; empty if absent
+    std::string_view attribute(std::string_view name) const;
+    bool hasAttribute(std::string_view name) const;
+    size_t attributeCount() const;
+    std::string_view attributeName(size_t i) const;
+    std::string_view attributeValue(size_t i) const;
+
+    XmlNode parent() const;
+    Range children() const;
+    size_t childCount() const;
+    XmlNode child(size_t i) const;
+
+    // Nodes matching a path relative to this node; see XmlDocument::query
+    std::vector<XmlNode> query(std::string_view path) const;
+    XmlNode queryFirst(std::string_view path) const;
+
+    uint32_t index() const { return index_; }
+    bool operator==(const XmlNode& o) const { return doc_ == o.doc_ && index_ == o.index_; }
+    bool operator!=(const XmlNode& o) const { return !(*this == o); }
+
+private:
+    friend class XmlDocument;
+    XmlNode(const XmlDocument* doc, uint32_t index) : doc_(doc), index_(index) {}
+
+    const XmlDocument* doc_ = nullptr;
+    uint32_t index_ = 0;
+};
+
+// Read-only DOM. Nodes, attributes, child index lists and decoded strings
+// are bump-allocated from one arena per document; names and values without
+// entity references are offsets into the source text, which the document
+// keeps alive (mapped, for load()). The children of a node are a contiguous
+// range of the child index array, so traversal never chases sibling
+// pointers. XmlNode handles point at the document and must not outlive it
+// or be kept across a move.
+//
+// Path queries are a small XPath subset:
+//   config/forwarder/destination          child steps from the root element
+//   /config//destination                  '//' matches at any depth
+//   destination[@port]                    has attribute
+//   destination[@port='7777']             attribute equals
+//   destination[2]                        1-based position among matches
+//                                         (any other [...] matches nothing)
+//   *                                     any element
+// Names match either the qualified name or the local name.
+class XmlDocument
+{
+public:
+    static const uint32_t kNone = 0xFFFFFFFFu;
+
+    // Map and parse a file; throws std::runtime_error on I/O or syntax errors.
+    // The file must not be rewritten in place while the document is alive.
+    static XmlDocument load(const std::string& path)
+    {
+        return load(std::unique_ptr<MappedFile>(new MappedFile(path)));
+    }
+
+    // Parse an already mapped file; the document takes ownership of it
+    static XmlDocument load(std::unique_ptr<MappedFile> file)
+    {
+        XmlDocument doc;
+        doc.file_ = std::move(file);
+        doc.build(doc.file_->view());
+        return doc;
+    }
+
+    // Parse a document held in memory (the text is copied into the document)
+    static XmlDocument parse(std::string text)
+    {
+        XmlDocument doc;
+        doc.owned_.reset(new std::string(std::move(text)));
+        doc.build(*doc.owned_);
+        return doc;
+    }
+
+    XmlDocument(XmlDocument&&) = default;
+    XmlDocument& operator=(XmlDocument&&) = default;
+
+    XmlNode root() const { return nodeCount_ ? XmlNode(this, 0) : XmlNode(); }
+
+    // Absolute query: the first step must match the root element
+    std::vector<XmlNode> query(std::string_view path) const
+    {
+        return select(kNone, path);
+    }
+
+    XmlNode queryFirst(std::string_view path) const
+    {
+        std::vector<XmlNode> r = query(path);
+        return r.empty() ? XmlNode() : r.front();
+    }
+
+    size_t nodeCount() const { return nodeCount_; }
+
+    // Node by index; indices follow document order, so a node's descendants
+    // always have larger indices than the node itself
+    XmlNode node(size_t index) const { return XmlNode(this, static_cast<uint32_t>(index)); }
+
+    // Bytes of the arena in use (excluding the source text)
+    size_t memoryBytes() const { return arenaUsed_; }
+
+    std::string_view source() const { return source_; }
+
+private:
+    friend class XmlNode;
+
+    enum Kind : uint8_t
+    {
+        Element,
+        Text
+    };
+
+    // Offset and length of a string in the source text, or in the decoded
+    // text of the arena when the kDecoded bit of length is set
+    struct Str
+    {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    static const uint32_t kDecoded = 0x80000000u;
+
+    struct Node
+    {
+        Str str;                  ///< Element name or text content
+        uint32_t parent;
+        uint32_t firstAttr;
+        uint32_t firstChild;      ///< Offset into the child index array
+        uint32_t childCount;
+        uint16_t attrCount;
+        Kind kind;
+    };
+
+    struct Attr
+    {
+        Str name;
+        Str value;
+    };
+
+    struct Step
+    {
+        bool descendant = false;
+        std::string_view name;        ///< "*" for any
+        std::string_view attr;        ///< [@attr]
+        std::string_view attrValue;   ///< [@attr='value']
+        bool hasAttrValue = false;
+        size_t position = 0;          ///< [n], 1-based; 0 = all
+    };
+
+    struct Free
+    {
+        void operator()(char* p) const { free(p); }
+    };
+
+    XmlDocument() = default;
+
+    std::string_view view(Str s) const
+    {
+        const char* base = (s.length & kDecoded) ? text_ : source_.data();
+        return std::string_view(base + s.offset, s.length & ~kDecoded);
+    }
+
+    Str sourceStr(std::string_view s) const
+    {
+        return Str{static_cast<uint32_t>(s.data() - source_.data()), static_cast<uint32_t>(s.size())};
+    }
+
+    void build(std::string_view source)
+    {
+        if (source.size() >= kDecoded)
+        {
+            throw std::runtime_error("XmlDocument: documents are limited to 2 GiB");
+        }
+        source_ = source;
+
+        // Reserve the arena for the worst case: every node needs a '<' or
+        // follows a '>', every attribute an '=', and decoded text is never
+        // longer than its source. Pages are only committed as they are
+        // written (large blocks are fresh mappings), so the bound costs
+        // address space rather than memory.
+        const char* begin = source.data();
+        const char* end = begin + source.size();
+        size_t maxNodes = 2 * xml_detail::count(begin, end, '<') + 1;
+        size_t maxAttrs = xml_detail::count(begin, end, '=');
+        size_t maxText = xml_detail::find(begin, end, '&') < end ? source.size() : 0;
+        size_t nodeBytes = maxNodes * sizeof(Node);
+        size_t attrBytes = maxAttrs * sizeof(Attr);
+        size_t childBytes = maxNodes * sizeof(uint32_t);
+        size_t arenaBytes = nodeBytes + attrBytes + childBytes + maxText + 1;
+        arena_.reset(static_cast<char*>(malloc(arenaBytes)));
+        if (!arena_)
+        {
+            throw std::bad_alloc();
+        }
+        nodes_ = reinterpret_cast<Node*>(arena_.get());
+        attrs_ = reinterpret_cast<Attr*>(arena_.get() + nodeBytes);
+        children_ = reinterpret_cast<uint32_t*>(arena_.get() + nodeBytes + attrBytes);
+        text_ = arena_.get() + nodeBytes + attrBytes + childBytes;
+
+        // Nodes are appended in document order; the children of an open
+        // element wait on a side stack and are copied into the child index
+        // array as one contiguous run when it closes
+        uint32_t nodeCount = 0, attrCount = 0, childCount = 0;
+        size_t textSize = 0;
+        std::vector<uint32_t> pending;
+        std::vector<uint32_t> pendingStart;
+        std::vector<uint32_t> open;
+        std::string scratch;
+
+        auto valueStr = [&](std::string_view raw, bool entities)
+        {
+            if (!entities)
+            {
+                return sourceStr(raw);
+            }
+            scratch.clear();
+            XmlPullParser::decodeAppend(scratch, raw);
+            memcpy(text_ + textSize, scratch.data(), scratch.size());
+            Str s{static_cast<uint32_t>(textSize), static_cast<uint32_t>(scratch.size()) | kDecoded};
+            textSize += scratch.size();
+            return s;
+        };
+
+        XmlPullParser p(source);
+        for (XmlEvent e = p.next(); e != XmlEvent::EndDocument; e = p.next())
+        {
+            switch (e)
+            {
+            case XmlEvent::StartElement:
+            {
+                if (open.empty() && nodeCount > 0)
+                {
+                    throw std::runtime_error("XmlDocument: more than one root element");
+                }
+                if (p.attributeCount() > 0xFFFF)
+                {
+                    throw std::runtime_error("XmlDocument: too many attributes on " + std::string(p.name()));
+                }
+                Node& n = nodes_[nodeCount];
+                n.str = sourceStr(p.name());
+                n.parent = open.empty() ? kNone : open.back();
+                n.firstAttr = attrCount;
+                n.firstChild = 0;
+                n.childCount = 0;
+                n.attrCount = static_cast<uint16_t>(p.attributeCount());
+                n.kind = Element;
+                for (size_t i = 0; i < p.attributeCount(); ++i)
+                {
+                    const XmlAttribute& a = p.attribute(i);
+                    attrs_[attrCount++] = Attr{sourceStr(a.name), valueStr(a.value, a.hasEntities)};
+                }
+                if (!open.empty())
+                {
+                    pending.push_back(nodeCount);
+                }
+                open.push_back(nodeCount++);
+                pendingStart.push_back(static_cast<uint32_t>(pending.size()));
+                break;
+            }
+            case XmlEvent::EndElement:
+            {
+                Node& n = nodes_[open.back()];
+                uint32_t start = pendingStart.back();
+                n.firstChild = childCount;
+                n.childCount = static_cast<uint32_t>(pending.size()) - start;
+                memcpy(children_ + childCount, pending.data() + start, n.childCount * sizeof(uint32_t));
+                childCount += n.childCount;
+                pending.resize(start);
+                pendingStart.pop_back();
+                open.pop_back();
+                break;
+            }
+            case XmlEvent::Text:
+            case XmlEvent::CData:
+                if (!open.empty())
+                {
+                    Node& n = nodes_[nodeCount];
+                    n.str = valueStr(p.text(), p.textHasEntities());
+                    n.parent = open.back();
+                    n.firstAttr = n.firstChild = n.childCount = 0;
+                    n.attrCount = 0;
+                    n.kind = Text;
+                    pending.push_back(nodeCount++);
+                }
+                break;
+            case XmlEvent::Error:
+                throw std::runtime_error("XmlDocument: " + p.errorMessage());
+            default:
+                break;
+            }
+        }
+        if (nodeCount == 0)
+        {
+            throw std::runtime_error("XmlDocument: no root element");
+        }
+        nodeCount_ = nodeCount;
+        arenaUsed_ = nodeCount * sizeof(Node) + attrCount * sizeof(Attr) + childCount * sizeof(uint32_t) + textSize;
+    }
+
+    static std::string_view localPart(std::string_view qname)
+    {
+        size_t colon = qname.find(':');
+        return colon == std::string_view::npos ? qname : qname.substr(colon + 1);
+    }
+
+    std::string_view attributeOf(uint32_t node, std::string_view name) const
+    {
+        const Node& n = nodes_[node];
+        for (uint32_t i = 0; i < n.attrCount; ++i)
+        {
+            std::string_view attrName = view(attrs_[n.firstAttr + i].name);
+            if (attrName == name || localPart(attrName) == name)
+            {
+                return view(attrs_[n.firstAttr + i].value);
+            }
+        }
+        return std::string_view();
+    }
+
+    bool hasAttributeOf(uint32_t node, std::string_view name) const
+    {
+        const Node& n = nodes_[node];
+        for (uint32_t i = 0; i < n.attrCount; ++i)
+        {
+            std::string_view attrName = view(attrs_[n.firstAttr + i].name);
+            if (attrName == name || localPart(attrName) == name)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // [n] predicate; anything but a plain positive number (last(), [abc],
+    // [0], one too large to count to) becomes a position nothing reaches
+    static size_t parsePosition(std::string_view pred)
+    {
+        const size_t kNowhere = std::numeric_limits<size_t>::max();
+        if (pred.empty())
+        {
+            return kNowhere;
+        }
+        size_t n = 0;
+        for (char c : pred)
+        {
+            if (c < '0' || c > '9' || n > (kNowhere - 9) / 10)
+            {
+                return kNowhere;
+            }
+            n = n * 10 + static_cast<size_t>(c - '0');
+        }
+        return n == 0 ? kNowhere : n;
+    }
+
+    static std::vector<Step> parsePath(std::string_view path)
+    {
+        std::vector<Step> steps;
+        size_t i = 0;
+        if (!path.empty() && path[0] == '/' && !(path.size() > 1 && path[1] == '/'))
+        {
+            i = 1;
+        }
+        while (i < path.size())
+        {
+            Step s;
+            if (path.compare(i, 2, "//") == 0)
+            {
+                s.descendant = true;
+                i += 2;
+            }
+            size_t end = path.find_first_of("/[", i);
+            s.name = path.substr(i, end == std::string_view::npos ? std::string_view::npos : end - i);
+            i = end == std::string_view::npos ? path.size() : end;
+            while (i < path.size() && path[i] == '[')
+            {
+                size_t close = path.find(']', i);
+                if (close == std::string_view::npos)
+                {
+                    throw std::runtime_error("XmlDocument: unterminated predicate in " + std::string(path));
+                }
+                std::string_view pred = path.substr(i + 1, close - i - 1);
+                if (!pred.empty() && pred[0] == '@')
+                {
+                    size_t eq = pred.find('=');
+                    s.attr = pred.substr(1, eq == std::string_view::npos ? std::string_view::npos : eq - 1);
+                    if (eq != std::string_view::npos)
+                    {
+                        std::string_view v = pred.substr(eq + 1);
+                        if (v.size() >= 2 && (v[0] == '\'' || v[0] == '"'))
+                        {
+                            v = v.substr(1, v.size() - 2);
+                        }
+                        s.attrValue = v;
+                        s.hasAttrValue = true;
+                    }
+                }
+                else
+                {
+                    s.position = parsePosition(pred);
+                }
+                i = close + 1;
+            }
+            if (i < path.size() && path[i] == '/' && path.compare(i, 2, "//") != 0)
+            {
+                ++i;
+            }
+            steps.push_back(s);
+        }
+        return steps;
+    }
+
+    bool matches(uint32_t node, const Step& s) const
+    {
+        const Node& n = nodes_[node];
+        if (n.kind != Element)
+        {
+            return false;
+        }
+        std::string_view name = view(n.str);
+        if (s.name != "*" && name != s.name && localPart(name) != s.name)
+        {
+            return false;
+        }
+        if (!s.attr.empty())
+        {
+            if (!hasAttributeOf(node, s.attr))
+            {
+                return false;
+            }
+            if (s.hasAttrValue && attributeOf(node, s.attr) != s.attrValue)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Append matches of step s below context (kNone = above the root)
+    void collect(uint32_t context, const Step& s, std::vector<uint32_t>& out) const
+    {
+        size_t first = out.size();
+        if (context == kNone)
+        {
+            if (matches(0, s))
+            {
+                out.push_back(0);
+            }
+            if (s.descendant)
+            {
+                collectDescendants(0, s, out);
+            }
+        }
+        else if (s.descendant)
+        {
+            collectDescendants(context, s, out);
+        }
+        else
+        {
+            const Node& n = nodes_[context];
+            for (uint32_t i = 0; i < n.childCount; ++i)
+            {
+                uint32_t c = children_[n.firstChild + i];
+                if (matches(c, s))
+                {
+                    out.push_back(c);
+                }
+            }
+        }
+        if (s.position)
+        {
+            size_t found = out.size() - first;
+            if (s.position <= found)
+            {
+                out[first] = out[first + s.position - 1];
+                out.resize(first + 1);
+            }
+            else
+            {
+                out.resize(first);
+            }
+        }
+    }
+
+    void collectDescendants(uint32_t node, const Step& s, std::vector<uint32_t>& out) const
+    {
+        const Node& n = nodes_[node];
+        for (uint32_t i = 0; i < n.childCount; ++i)
+        {
+            uint32_t c = children_[n.firstChild + i];
+            if (matches(c, s))
+            {
+                out.push_back(c);
+            }
+            collectDescendants(c, s, out);
+        }
+    }
+
+    std::vector<XmlNode> select(uint32_t context, std::string_view path) const
+    {
+        std::vector<XmlNode> result;
+        if (nodeCount_ == 0)
+        {
+            return result;
+        }
+        std::vector<Step> steps = parsePath(path);
+        std::vector<uint32_t> current(1, context), next;
+        for (const Step& s : steps)
+        {
+            next.clear();
+            for (uint32_t c : current)
+            {
+                collect(c, s, next);
+            }
+            // Node indices are in document order; '//' can reach a node twice
+            std::sort(next.begin(), next.end());
+            next.erase(std::unique(next.begin(), next.end()), next.end());
+            current.swap(next);
+        }
+        result.reserve(current.size());
+        for (uint32_t i : current)
+        {
+            if (i != kNone)
+            {
+                result.push_back(XmlNode(this, i));
+            }
+        }
+        return result;
+    }
+
+    std::unique_ptr<MappedFile> file_;
+    std::unique_ptr<std::string> owned_;
+    std::string_view source_;
+    std::unique_ptr<char, Free> arena_;
+    size_t arenaUsed_ = 0;
+    size_t nodeCount_ = 0;
+    Node* nodes_ = nullptr;
+    Attr* attrs_ = nullptr;
+    uint32_t* children_ = nullptr;
+    char* text_ = nullptr;
+};
+
+class XmlNode::Range
+{
+public:
+    class iterator
+    {
+    public:
+        iterator(const XmlDocument* doc, const uint32_t* p) : doc_(doc), p_(p) {}
+        XmlNode operator*() const { return XmlNode(doc_, *p_); }
+        iterator& operator++()
+        {
+            ++p_;
+            return *this;
+        }
+        bool operator!=(const iterator& o) const { return p_ != o.p_; }
+
+    private:
+        const XmlDocument* doc_;
+        const uint32_t* p_;
+    };
+
+    Range(const XmlDocument* doc, const uint32_t* begin, const uint32_t* end) : doc_(doc), begin_(begin), end_(end) {}
+    iterator begin() const { return iterator(doc_, begin_); }
+    iterator end() const { return iterator(doc_, end_); }
+    size_t size() const { return static_cast<size_t>(end_ - begin_); }
+
+private:
+    const XmlDocument* doc_;
+    const uint32_t* begin_;
+    const uint32_t* end_;
+};
+
+inline bool XmlNode::isElement() const { return doc_ && doc_->nodes_[index_].kind == XmlDocument::Element; }
+inline bool XmlNode::isText() const { return doc_ && doc_->nodes_[index_].kind == XmlDocument::Text; }
+inline std::string_view XmlNode::name() const
+{
+    return isElement() ? doc_->view(doc_->nodes_[index_].str) : std::string_view();
+}
+inline std::string_view XmlNode::localName() const { return XmlDocument::localPart(name()); }
+
+inline std::string_view XmlNode::text() const
+{
+    if (!doc_)
+    {
+        return std::string_view();
+    }
+    if (isText())
+    {
+        return doc_->view(doc_->nodes_[index_].str);
+    }
+    for (XmlNode c : children())
+    {
+        if (c.isText())
+        {
+            return c.text();
+        }
+    }
+    return std::string_view();
+}
+
+inline std::string_view XmlNode::attribute(std::string_view name) const
+{
+    return doc_ ? doc_->attributeOf(index_, name) : std::string_view();
+}
+
+inline bool XmlNode::hasAttribute(std::string_view name) const { return doc_ && doc_->hasAttributeOf(index_, name); }
+inline size_t XmlNode::attributeCount() const { return doc_ ? doc_->nodes_[index_].attrCount : 0; }
+
+inline std::string_view XmlNode::attributeName(size_t i) const
+{
+    return doc_->view(doc_->attrs_[doc_->nodes_[index_].firstAttr + i].name);
+}
+
+inline std::string_view XmlNode::attributeValue(size_t i) const
+{
+    return doc_->view(doc_->attrs_[doc_->nodes_[index_].firstAttr + i].value);
+}
+
+inline XmlNode XmlNode::parent() const
+{
+    if (!doc_ || doc_->nodes_[index_].parent == XmlDocument::kNone)
+    {
+        return XmlNode();
+    }
+    return XmlNode(doc_, doc_->nodes_[index_].parent);
+}
+
+inline XmlNode::Range XmlNode::children() const
+{
+    if (!doc_)
+    {
+        return Range(nullptr, nullptr, nullptr);
+    }
+    const uint32_t* first = doc_->children_ + doc_->nodes_[index_].firstChild;
+    return Range(doc_, first, first + doc_->nodes_[index_].childCount);
+}
+
+inline size_t XmlNode::childCount() const { return doc_ ? doc_->nodes_[index_].childCount : 0; }
+
+inline XmlNode XmlNode::child(size_t i) const
+{
+    return XmlNode(doc_, doc_->children_[doc_->nodes_[index_].firstChild + i]);
+}
+
+inline std::vector<XmlNode> XmlNode::query(std::string_view path) const
+{
+    return doc_ ? doc_->select(index_, path) : std::vector<XmlNode>();
+}
+
+inline XmlNode XmlNode::queryFirst(std::string_view path) const
+{
+    std::vector<XmlNode> r = query(path);
+    return r.empty() ? XmlNode() : r.front();
+}
@@ -0,0 +1,176 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <string>
+#include <cstdio>
+#include "XmlDocument.hpp"
+#include "XmlConfigRead.hpp"
+
+// Synthetic forwarder config of roughly targetBytes; every tenth destination has no port
+static std::string makeConfig(size_t targetBytes)
+{
+    std::string doc = "<?xml version=\"1.0\"?>\n<config xmlns:fw=\"urn:snippets:fw\">\n";
+    for (int i = 0; doc.size() < targetBytes; ++i)
+    {
+        std::string port = i % 10 ? " port=\"" + std::to_string(7000 + i % 1000) + "\"" : "";
+        doc += "  <forwarder id=\"" + std::to_string(i) + "\" enabled=\"true\">\n"
+               "    <listen address=\"0.0.0.0\" port=\"" + std::to_string(5000 + i % 1000) + "\"/>\n"
+               "    <destination host=\"10.0." + std::to_string(i % 255) + ".1\"" + port + ">primary &amp; backup</destination>\n"
+               "    <fw:limits packetsPerSecond=\"100000\" burst=\"64\"/>\n"
+               "  </forwarder>\n";
+    }
+    doc += "</config>\n";
+    return doc;
+}
+
+static bool check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        std::cerr << "Self-test failed: " << what << std::endl;
+    }
+    return ok;
+}
+
+#define SELF_CHECK(cond) ok &= check((cond), #cond)
+
+static bool selfTest()
+{
+    bool ok = true;
+    XmlDocument doc = XmlDocument::parse(
+        "<config xmlns:fw='urn:fw'>\n"
+        "  <forwarder id='a'>\n"
+        "    <destination host='h1' port='1'>one &amp; only</destination>\n"
+        "    <destination host='h2'/>\n"
+        "  </forwarder>\n"
+        "  <forwarder id='b'>\n"
+        "    <destination host='h3' port='3'/>\n"
+        "    <fw:limits burst='&lt;64'/>\n"
+        "  </forwarder>\n"
+        "</config>");
+
+    XmlNode root = doc.root();
+    SELF_CHECK(root.name() == "config" && root.childCount() == 2 && !root.parent());
+    SELF_CHECK(doc.query("config/forwarder/destination").size() == 3);
+    SELF_CHECK(doc.query("/config/forwarder/destination[@port]").size() == 2);
+    SELF_CHECK(doc.query("config/forwarder[@id='b']/destination")[0].attribute("host") == "h3");
+    SELF_CHECK(doc.query("config/forwarder/destination[2]").size() == 1);
+    SELF_CHECK(doc.queryFirst("config/forwarder/destination[2]").attribute("host") == "h2");
+    SELF_CHECK(doc.query("config/forwarder/destination[last()]").empty());
+    SELF_CHECK(doc.query("config/forwarder/destination[abc]").empty());
+    SELF_CHECK(doc.query("config/forwarder/destination[0]").empty());
+    SELF_CHECK(doc.query("config/forwarder/destination[99999999999999999999]").empty());
+    SELF_CHECK(doc.query("//destination").size() == 3);
+    SELF_CHECK(doc.query("other/forwarder").empty());
+    SELF_CHECK(doc.query("config/*").size() == 2);
+
+    XmlNode first = doc.queryFirst("config/forwarder/destination");
+    SELF_CHECK(first.text() == "one & only");
+    SELF_CHECK(first.parent().attribute("id") == "a");
+    SELF_CHECK(first.parent().parent() == root);
+    SELF_CHECK(first.hasAttribute("port") && !first.hasAttribute("nope") && first.attribute("nope").empty());
+
+    XmlNode limits = doc.queryFirst("config/forwarder/limits");
+    SELF_CHECK(limits.name() == "fw:limits" && limits.localName() == "limits");
+    SELF_CHECK(limits.attribute("burst") == "<64");
+    SELF_CHECK(doc.query("config/forwarder/fw:limits").size() == 1);
+
+    XmlNode b = root.child(1);
+    SELF_CHECK(b.query("destination[@port='3']").size() == 1);
+    size_t elements = 0;
+    for (XmlNode c : b.children())
+    {
+        elements += c.isElement();
+    }
+    SELF_CHECK(elements == 2);
+
+    bool threw = false;
+    try
+    {
+        XmlDocument::parse("<a><b></a>");
+    }
+    catch (const std::runtime_error&)
+    {
+        threw = true;
+    }
+    SELF_CHECK(threw);
+    if (ok)
+    {
+        std::cout << "Self-test passed (" << doc.nodeCount() << " nodes, " << doc.memoryBytes() << " bytes)" << std::endl;
+    }
+    return ok;
+}
+
+template <typename Fn>
+static double bestSeconds(Fn fn)
+{
+    auto best = std::chrono::duration<double>::max();
+    for (int run = 0; run < 3; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        best = std::min<std::chrono::duration<double>>(best, std::chrono::steady_clock::now() - start);
+    }
+    return best.count();
+}
+
+// Heap bytes held by a token vector
+static size_t tokenBytes(const std::vector<std::string>& tokens)
+{
+    size_t bytes = tokens.capacity() * sizeof(std::string);
+    for (const auto& t : tokens)
+    {
+        bytes += t.capacity() > 15 ? t.capacity() + 1 : 0;
+    }
+    return bytes;
+}
+
+int main()
+{
+    if (!selfTest())
+    {
+        return 1;
+    }
+
+    std::string text = makeConfig(50 << 20);
+    const char* path = "/tmp/xml_document_demo.xml";
+    std::ofstream(path) << text;
+
+    // Load from disk and answer "which destinations have a port?"
+    size_t matches = 0, domBytes = 0, nodes = 0;
+    double dom = bestSeconds([&]()
+    {
+        XmlDocument doc = XmlDocument::load(path);
+        matches = doc.query("config/forwarder/destination[@port]").size();
+        domBytes = doc.memoryBytes();
+        nodes = doc.nodeCount();
+    });
+
+    // The same question answered the way XmlConfigRead used to: read the
+    // file into a string, tokenize with parseXML and scan the tokens
+    size_t legacyMatches = 0, legacyBytes = 0;
+    double legacy = bestSeconds([&]()
+    {
+        std::ifstream in(path);
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        std::vector<std::string> tokens = parseXML(buffer.str());
+        legacyMatches = 0;
+        for (const auto& t : tokens)
+        {
+            legacyMatches += t.compare(0, 12, "destination ") == 0 && t.find(" port=") != std::string::npos;
+        }
+        legacyBytes = tokenBytes(tokens);
+    });
+    std::remove(path);
+
+    std::cout << "Document: " << text.size() / (1 << 20) << " MiB, " << nodes << " nodes" << std::endl;
+    std::cout << "XmlDocument load + query: " << dom * 1e3 << " ms, " << domBytes / (1 << 20) << " MiB DOM ("
+              << matches << " matches)" << std::endl;
+    std::cout << "parseXML tokens + scan:   " << legacy * 1e3 << " ms, " << legacyBytes / (1 << 20) << " MiB tokens ("
+              << legacyMatches << " matches)" << std::endl;
+    std::cout << "Speedup: " << legacy / dom << "x, memory: " << static_cast<double>(legacyBytes) / domBytes << "x less"
+              << std::endl;
+    return matches == legacyMatches ? 0 : 1;
+}
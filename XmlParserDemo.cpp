@@ -0,0 +1,131 @@
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <string>
+#include <cstdio>
+#include "XmlPullParser.hpp"
+#include "XmlConfigRead.hpp"
+
+// Synthetic forwarder config of roughly targetBytes
+static std::string makeConfig(size_t targetBytes)
+{
+    std::string doc = "<?xml version=\"1.0\"?>\n<config xmlns=\"urn:snippets:config\" xmlns:fw=\"urn:snippets:fw\">\n";
+    for (int i = 0; doc.size() < targetBytes; ++i)
+    {
+        doc += "  <fw:forwarder id=\"" + std::to_string(i) + "\" enabled=\"true\">\n"
+               "    <listen address=\"0.0.0.0\" port=\"" + std::to_string(5000 + i % 1000) + "\"/>\n"
+               "    <destination host=\"10.0." + std::to_string(i % 255) + ".1\" port=\"7777\">primary &amp; backup</destination>\n"
+               "    <!-- rate limits -->\n"
+               "    <limits packetsPerSecond=\"100000\" burst=\"64\"/>\n"
+               "  </fw:forwarder>\n";
+    }
+    doc += "</config>\n";
+    return doc;
+}
+
+static bool check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        std::cerr << "Self-test failed: " << what << std::endl;
+    }
+    return ok;
+}
+
+#define SELF_CHECK(cond) ok &= check((cond), #cond)
+
+static bool selfTest()
+{
+    bool ok = true;
+    const char* doc =
+        "<?xml version='1.0'?>\n"
+        "<!DOCTYPE cfg [ <!ENTITY x 'y'> ]>\n"
+        "<a:root xmlns:a='urn:a' xmlns='urn:default'>\n"
+        "  <item key=\"k&lt;1\" a:flag='yes'>x &gt; y</item>\n"
+        "  <empty/>\n"
+        "  <![CDATA[<raw>]]>\n"
+        "</a:root>";
+    XmlPullParser p(doc);
+    SELF_CHECK(p.next() == XmlEvent::ProcessingInstruction && p.name() == "xml");
+    SELF_CHECK(p.next() == XmlEvent::Doctype);
+    SELF_CHECK(p.next() == XmlEvent::StartElement && p.localName() == "root" && p.namespaceUri() == "urn:a");
+    SELF_CHECK(p.next() == XmlEvent::StartElement && p.name() == "item" && p.namespaceUri() == "urn:default");
+    SELF_CHECK(p.attributeCount() == 2);
+    SELF_CHECK(p.findAttribute("key")->hasEntities && XmlPullParser::decode(p.findAttribute("key")->value) == "k<1");
+    SELF_CHECK(p.attribute(1).localName == "flag" && p.attribute(1).namespaceUri == "urn:a");
+    SELF_CHECK(p.next() == XmlEvent::Text && p.textHasEntities() && XmlPullParser::decode(p.text()) == "x > y");
+    SELF_CHECK(p.next() == XmlEvent::EndElement && p.name() == "item");
+    SELF_CHECK(p.next() == XmlEvent::StartElement && p.isEmptyElement() && p.depth() == 2);
+    SELF_CHECK(p.next() == XmlEvent::EndElement && p.name() == "empty");
+    SELF_CHECK(p.next() == XmlEvent::CData && p.text() == "<raw>");
+    SELF_CHECK(p.next() == XmlEvent::EndElement && p.namespaceUri() == "urn:a");
+    SELF_CHECK(p.next() == XmlEvent::EndDocument);
+    SELF_CHECK(XmlPullParser::decode("&#65;&#x263A;") == "A\xE2\x98\xBA");
+    SELF_CHECK(XmlPullParser::decode("&#x10FFFF;&#x1F600;") == "\xF4\x8F\xBF\xBF\xF0\x9F\x98\x80");
+    // References to no character, or to one XML forbids, are kept as written
+    SELF_CHECK(XmlPullParser::decode("&#x;&#abc;&#0;&#xD800;&#x110000;&#4294967361;&#6x;")
+               == "&#x;&#abc;&#0;&#xD800;&#x110000;&#4294967361;&#6x;");
+
+    XmlPullParser bad("<a><b></a>");
+    XmlEvent e;
+    while ((e = bad.next()) != XmlEvent::Error && e != XmlEvent::EndDocument)
+    {
+    }
+    SELF_CHECK(e == XmlEvent::Error);
+    if (ok)
+    {
+        std::cout << "Self-test passed (mismatch reported as: " << bad.errorMessage() << ")" << std::endl;
+    }
+    return ok;
+}
+
+template <typename Fn>
+static double megabytesPerSecond(size_t bytes, Fn fn)
+{
+    auto best = std::chrono::duration<double>::max();
+    for (int run = 0; run < 5; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        best = std::min<std::chrono::duration<double>>(best, std::chrono::steady_clock::now() - start);
+    }
+    return bytes / best.count() / 1e6;
+}
+
+int main()
+{
+    if (!selfTest())
+    {
+        return 1;
+    }
+
+    std::string doc = makeConfig(32 << 20);
+    const char* path = "/tmp/xml_parser_demo.xml";
+    std::ofstream(path) << doc;
+    MappedFile file(path);
+
+    size_t elements = 0;
+    double pull = megabytesPerSecond(file.size(), [&]()
+    {
+        elements = 0;
+        XmlPullParser p(file.view());
+        for (XmlEvent e; (e = p.next()) != XmlEvent::EndDocument;)
+        {
+            if (e == XmlEvent::Error)
+            {
+                std::cerr << p.errorMessage() << std::endl;
+                break;
+            }
+            elements += e == XmlEvent::StartElement;
+        }
+    });
+
+    size_t tokens = 0;
+    double legacy = megabytesPerSecond(doc.size(), [&]() { tokens = parseXML(doc).size(); });
+
+    std::cout << "Document: " << file.size() / (1 << 20) << " MiB, " << elements << " elements" << std::endl;
+    std::cout << "XmlPullParser (mmap): " << pull << " MB/s" << std::endl;
+    std::cout << "parseXML (tokens):    " << legacy << " MB/s (" << tokens << " tokens)" << std::endl;
+    std::remove(path);
+    return 0;
+}
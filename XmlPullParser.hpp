@@ -0,0 +1,671 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Read-only memory mapping of a whole file; throws std::runtime_error on failure
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string& path)
+    {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            throw std::runtime_error("MappedFile: cannot open " + path + ": " + strerror(errno));
+        }
+        struct stat st;
+        if (fstat(fd, &st) < 0)
+        {
+            close(fd);
+            throw std::runtime_error("MappedFile: cannot stat " + path);
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0)
+        {
+            void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+            if (p == MAP_FAILED)
+            {
+                close(fd);
+                throw std::runtime_error("MappedFile: cannot map " + path + ": " + strerror(errno));
+            }
+            madvise(p, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(p);
+        }
+        close(fd);
+    }
+
+    ~MappedFile()
+    {
+        if (data_ != nullptr)
+        {
+            munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return std::string_view(data_, size_); }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+namespace xml_detail
+{
+
+// First position in [p, end) holding a or b, or end. 32 or 16 bytes per
+// step with AVX2/SSE2 so long text runs and attribute values are skipped
+// without a per-byte branch.
+inline const char* findEither(const char* p, const char* end, char a, char b)
+{
+#if defined(__AVX2__)
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+    while (end - p >= 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        unsigned mask = static_cast<unsigned>(
+            _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb))));
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i sa = _mm_set1_epi8(a);
+    const __m128i sb = _mm_set1_epi8(b);
+    while (end - p >= 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, sa), _mm_cmpeq_epi8(v, sb))));
+        if (mask)
+        {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && *p != a && *p != b)
+    {
+        ++p;
+    }
+    return p;
+}
+
+inline const char* find(const char* p, const char* end, char c)
+{
+    const void* r = memchr(p, c, static_cast<size_t>(end - p));
+    return r ? static_cast<const char*>(r) : end;
+}
+
+// Occurrences of c in [p, end), 16 bytes per step with SSE2
+inline size_t count(const char* p, const char* end, char c)
+{
+    size_t n = 0;
+#if defined(__SSE2__)
+    const __m128i sc = _mm_set1_epi8(c);
+    while (end - p >= 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        n += static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, sc)))));
+        p += 16;
+    }
+#endif
+    for (; p < end; ++p)
+    {
+        n += *p == c;
+    }
+    return n;
+}
+
+inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+inline bool isNameChar(char c)
+{
+    unsigned char u = static_cast<unsigned char>(c);
+    return static_cast<unsigned>((u | 0x20) - 'a') < 26 || static_cast<unsigned>(u - '0') < 10 || c == '_' ||
+           c == ':' || c == '-' || c == '.' || u >= 0x80;
+}
+
+inline void appendUtf8(std::string& out, uint32_t cp)
+{
+    if (cp < 0x80)
+    {
+        out += static_cast<char>(cp);
+    }
+    else if (cp < 0x800)
+    {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000)
+    {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else
+    {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// Code point of a numeric character reference ("65" or "x41", without the
+// "&#" and ";"). False unless it names a character XML allows: at least one
+// digit, nothing else, and not NUL, a surrogate or above U+10FFFF.
+inline bool parseCharRef(std::string_view digits, uint32_t& cp)
+{
+    bool hex = !digits.empty() && digits[0] == 'x';
+    size_t i = hex ? 1 : 0;
+    if (i == digits.size())
+    {
+        return false;
+    }
+    cp = 0;
+    for (; i < digits.size(); ++i)
+    {
+        unsigned char c = static_cast<unsigned char>(digits[i]);
+        uint32_t d;
+        if (static_cast<unsigned>(c - '0') < 10)
+        {
+            d = c - '0';
+        }
+        else if (hex && static_cast<unsigned>((c | 0x20) - 'a') < 6)
+        {
+            d = (c | 0x20) - 'a' + 10;
+        }
+        else
+        {
+            return false;
+        }
+        cp = cp * (hex ? 16 : 10) + d;
+        if (cp > 0x10FFFF)
+        {
+            return false;
+        }
+    }
+    return cp != 0 && (cp < 0xD800 || cp > 0xDFFF);
+}
+
+} // namespace xml_detail
+
+enum class XmlEvent
+{
+    StartElement,
+    EndElement,
+    Text,
+    CData,
+    Comment,
+    ProcessingInstruction,
+    Doctype,
+    EndDocument,
+    Error
+};
+
+struct XmlAttribute
+{
+    std::string_view name;          ///< Qualified name as written
+    std::string_view prefix;
+    std::string_view localName;
+    std::string_view namespaceUri;  ///< Empty for unprefixed attributes
+    std::string_view value;         ///< Raw value; see XmlPullParser::decode
+    bool hasEntities;
+};
+
+// Zero-copy pull parser. Every name, value and text returned is a view into
+// the caller's buffer (typically a MappedFile), valid as long as the buffer.
+// Entity references are left raw and flagged; call decode() only for the
+// values you actually use.
+//
+//   XmlPullParser p(file.view());
+//   for (XmlEvent e; (e = p.next()) != XmlEvent::EndDocument && e != XmlEvent::Error;)
+//       if (e == XmlEvent::StartElement && p.localName() == "destination") ...
+//
+// Checks tag nesting and resolves namespace prefixes; it does not validate
+// against a DTD or expand external entities.
+class XmlPullParser
+{
+public:
+    explicit XmlPullParser(std::string_view document, bool skipWhitespace = true)
+        : begin_(document.data()), pos_(document.data()), end_(document.data() + document.size()),
+          skipWhitespace_(skipWhitespace)
+    {
+    }
+
+    XmlEvent next()
+    {
+        if (pendingEnd_)
+        {
+            pendingEnd_ = false;
+            return closeElement();
+        }
+        if (event_ == XmlEvent::Error || event_ == XmlEvent::EndDocument)
+        {
+            return event_;
+        }
+        if (event_ == XmlEvent::EndElement)
+        {
+            popScope();
+        }
+
+        for (;;)
+        {
+            if (pos_ >= end_)
+            {
+                if (!open_.empty())
+                {
+                    return fail("unexpected end of document inside <" + std::string(open_.back()) + ">");
+                }
+                return event_ = XmlEvent::EndDocument;
+            }
+            if (*pos_ != '<')
+            {
+                const char* start = pos_;
+                const char* stop = xml_detail::findEither(pos_, end_, '<', '&');
+                textEntities_ = stop < end_ && *stop == '&';
+                if (textEntities_)
+                {
+                    stop = xml_detail::find(stop, end_, '<');
+                }
+                pos_ = stop;
+                text_ = std::string_view(start, static_cast<size_t>(stop - start));
+                if (skipWhitespace_ && !textEntities_ && allSpace(text_))
+                {
+                    continue;
+                }
+                return event_ = XmlEvent::Text;
+            }
+            return markup();
+        }
+    }
+
+    XmlEvent event() const { return event_; }
+
+    // Element name for Start/EndElement, target for ProcessingInstruction
+    std::string_view name() const { return name_; }
+    std::string_view prefix() const { return prefix_; }
+    std::string_view localName() const { return local_; }
+    std::string_view namespaceUri() const { return uri_; }
+
+    // Raw content of Text, CData, Comment, ProcessingInstruction or Doctype
+    std::string_view text() const { return text_; }
+    bool textHasEntities() const { return event_ == XmlEvent::Text && textEntities_; }
+
+    // True when the current StartElement was written as <name/>
+    bool isEmptyElement() const { return pendingEnd_; }
+
+    // Nesting depth; 1 inside the root element
+    size_t depth() const { return open_.size(); }
+
+    size_t attributeCount() const { return attrs_.size(); }
+    const XmlAttribute& attribute(size_t i) const { return attrs_[i]; }
+
+    // Raw value of the attribute with the given qualified name, or nullptr
+    const XmlAttribute* findAttribute(std::string_view qname) const
+    {
+        for (const auto& a : attrs_)
+        {
+            if (a.name == qname)
+            {
+                return &a;
+            }
+        }
+        return nullptr;
+    }
+
+    const std::string& errorMessage() const { return error_; }
+    size_t offset() const { return static_cast<size_t>(pos_ - begin_); }
+
+    // Expand the predefined and numeric character references in raw
+    static std::string decode(std::string_view raw)
+    {
+        std::string out;
+        out.reserve(raw.size());
+        decodeAppend(out, raw);
+        return out;
+    }
+
+    // decode() appending to an existing buffer
+    static void decodeAppend(std::string& out, std::string_view raw)
+    {
+        const char* p = raw.data();
+        const char* end = p + raw.size();
+        uint32_t cp;
+        while (p < end)
+        {
+            const char* amp = xml_detail::find(p, end, '&');
+            out.append(p, amp);
+            if (amp == end)
+            {
+                break;
+            }
+            const char* semi = xml_detail::find(amp, end, ';');
+            std::string_view ref(amp + 1, static_cast<size_t>(semi - amp - 1));
+            p = semi < end ? semi + 1 : end;
+            if (ref == "lt") out += '<';
+            else if (ref == "gt") out += '>';
+            else if (ref == "amp") out += '&';
+            else if (ref == "quot") out += '"';
+            else if (ref == "apos") out += '\'';
+            else if (ref.size() > 1 && ref[0] == '#' && xml_detail::parseCharRef(ref.substr(1), cp))
+            {
+                xml_detail::appendUtf8(out, cp);
+            }
+            else
+            {
+                out.append(amp, p); // unknown entity or invalid character: keep as written
+            }
+        }
+    }
+
+private:
+    struct NsDecl
+    {
+        std::string_view prefix;
+        std::string_view uri;
+        size_t depth;
+    };
+
+    static bool allSpace(std::string_view s)
+    {
+        for (char c : s)
+        {
+            if (!xml_detail::isSpace(c))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool startsWith(const char* p, const char* end, const char* lit, size_t n)
+    {
+        return static_cast<size_t>(end - p) >= n && memcmp(p, lit, n) == 0;
+    }
+
+    XmlEvent fail(const std::string& message)
+    {
+        error_ = message + " at offset " + std::to_string(pos_ - begin_);
+        return event_ = XmlEvent::Error;
+    }
+
+    const char* skipSpace(const char* p) const
+    {
+        while (p < end_ && xml_detail::isSpace(*p))
+        {
+            ++p;
+        }
+        return p;
+    }
+
+    std::string_view scanName(const char*& p) const
+    {
+        const char* start = p;
+        while (p < end_ && xml_detail::isNameChar(*p))
+        {
+            ++p;
+        }
+        return std::string_view(start, static_cast<size_t>(p - start));
+    }
+
+    // Body between "<x" and a terminator; sets text_ and advances past it
+    XmlEvent delimited(XmlEvent e, size_t openLen, std::string_view terminator, const char* what)
+    {
+        std::string_view rest(pos_ + openLen, static_cast<size_t>(end_ - pos_ - openLen));
+        size_t at = rest.find(terminator);
+        if (at == std::string_view::npos)
+        {
+            return fail(std::string("unterminated ") + what);
+        }
+        text_ = rest.substr(0, at);
+        pos_ = rest.data() + at + terminator.size();
+        return event_ = e;
+    }
+
+    XmlEvent markup()
+    {
+        const char* p = pos_ + 1;
+        if (startsWith(p, end_, "!--", 3))
+        {
+            return delimited(XmlEvent::Comment, 4, "-->", "comment");
+        }
+        if (startsWith(p, end_, "![CDATA[", 8))
+        {
+            return delimited(XmlEvent::CData, 9, "]]>", "CDATA section");
+        }
+        if (p < end_ && *p == '?')
+        {
+            const char* t = p + 1;
+            name_ = scanName(t);
+            XmlEvent e = delimited(XmlEvent::ProcessingInstruction, 2 + name_.size(), "?>", "processing instruction");
+            size_t skip = text_.find_first_not_of(" \t\r\n");
+            text_.remove_prefix(skip == std::string_view::npos ? text_.size() : skip);
+            return e;
+        }
+        if (p < end_ && *p == '!')
+        {
+            // <!DOCTYPE ...> possibly with an internal subset in [...]
+            int brackets = 0;
+            const char* q = p;
+            for (; q < end_; ++q)
+            {
+                if (*q == '[') ++brackets;
+                else if (*q == ']') --brackets;
+                else if (*q == '>' && brackets <= 0) break;
+            }
+            if (q >= end_)
+            {
+                return fail("unterminated declaration");
+            }
+            text_ = std::string_view(p + 1, static_cast<size_t>(q - p - 1));
+            pos_ = q + 1;
+            return event_ = XmlEvent::Doctype;
+        }
+        if (p < end_ && *p == '/')
+        {
+            return endTag(p + 1);
+        }
+        return startTag(p);
+    }
+
+    XmlEvent startTag(const char* p)
+    {
+        name_ = scanName(p);
+        if (name_.empty())
+        {
+            return fail("expected element name");
+        }
+        attrs_.clear();
+        size_t depth = open_.size() + 1;
+        for (;;)
+        {
+            p = skipSpace(p);
+            if (p >= end_)
+            {
+                return fail("unterminated start tag <" + std::string(name_) + ">");
+            }
+            if (*p == '>')
+            {
+                ++p;
+                break;
+            }
+            if (*p == '/' && p + 1 < end_ && p[1] == '>')
+            {
+                pendingEnd_ = true;
+                p += 2;
+                break;
+            }
+            XmlAttribute a;
+            a.name = scanName(p);
+            if (a.name.empty())
+            {
+                pos_ = p;
+                return fail("malformed attribute in <" + std::string(name_) + ">");
+            }
+            p = skipSpace(p);
+            if (p >= end_ || *p != '=')
+            {
+                pos_ = p;
+                return fail("expected '=' after attribute " + std::string(a.name));
+            }
+            p = skipSpace(p + 1);
+            if (p >= end_ || (*p != '"' && *p != '\''))
+            {
+                pos_ = p;
+                return fail("expected quoted value for attribute " + std::string(a.name));
+            }
+            char quote = *p++;
+            const char* v = xml_detail::findEither(p, end_, quote, '&');
+            a.hasEntities = v < end_ && *v == '&';
+            if (a.hasEntities)
+            {
+                v = xml_detail::find(v, end_, quote);
+            }
+            if (v >= end_)
+            {
+                return fail("unterminated value for attribute " + std::string(a.name));
+            }
+            a.value = std::string_view(p, static_cast<size_t>(v - p));
+            p = v + 1;
+
+            if (a.name == "xmlns")
+            {
+                ns_.push_back(NsDecl{std::string_view(), a.value, depth});
+            }
+            else if (a.name.size() > 6 && a.name.compare(0, 6, "xmlns:") == 0)
+            {
+                ns_.push_back(NsDecl{a.name.substr(6), a.value, depth});
+            }
+            attrs_.push_back(a);
+        }
+        pos_ = p;
+        open_.push_back(name_);
+
+        splitName(name_, prefix_, local_);
+        uri_ = lookup(prefix_);
+        for (auto& a : attrs_)
+        {
+            splitName(a.name, a.prefix, a.localName);
+            if (a.prefix == "xmlns" || a.name == "xmlns")
+            {
+                a.namespaceUri = "http://www.w3.org/2000/xmlns/";
+            }
+            else if (!a.prefix.empty())
+            {
+                a.namespaceUri = lookup(a.prefix);
+            }
+        }
+        return event_ = XmlEvent::StartElement;
+    }
+
+    XmlEvent endTag(const char* p)
+    {
+        name_ = scanName(p);
+        p = skipSpace(p);
+        if (p >= end_ || *p != '>')
+        {
+            return fail("malformed end tag");
+        }
+        if (open_.empty() || open_.back() != name_)
+        {
+            return fail("mismatched end tag </" + std::string(name_) + ">" +
+                        (open_.empty() ? std::string() : ", expected </" + std::string(open_.back()) + ">"));
+        }
+        pos_ = p + 1;
+        splitName(name_, prefix_, local_);
+        uri_ = lookup(prefix_);
+        attrs_.clear();
+        return event_ = XmlEvent::EndElement;
+    }
+
+    // EndElement for <name/>: same name and namespace as the start event
+    XmlEvent closeElement()
+    {
+        attrs_.clear();
+        return event_ = XmlEvent::EndElement;
+    }
+
+    // Leave the element whose EndElement was just returned
+    void popScope()
+    {
+        size_t depth = open_.size();
+        while (!ns_.empty() && ns_.back().depth >= depth)
+        {
+            ns_.pop_back();
+        }
+        open_.pop_back();
+    }
+
+    static void splitName(std::string_view qname, std::string_view& prefix, std::string_view& local)
+    {
+        size_t colon = qname.find(':');
+        if (colon == std::string_view::npos)
+        {
+            prefix = std::string_view();
+            local = qname;
+        }
+        else
+        {
+            prefix = qname.substr(0, colon);
+            local = qname.substr(colon + 1);
+        }
+    }
+
+    std::string_view lookup(std::string_view prefix) const
+    {
+        if (prefix == "xml")
+        {
+            return "http://www.w3.org/XML/1998/namespace";
+        }
+        for (size_t i = ns_.size(); i-- > 0;)
+        {
+            if (ns_[i].prefix == prefix)
+            {
+                return ns_[i].uri;
+            }
+        }
+        return std::string_view();
+    }
+
+    const char* begin_;
+    const char* pos_;
+    const char* end_;
+    bool skipWhitespace_;
+    XmlEvent event_ = XmlEvent::Text;
+    bool pendingEnd_ = false;
+    bool textEntities_ = false;
+    std::string_view name_, prefix_, local_, uri_, text_;
+    std::vector<XmlAttribute> attrs_;
+    std::vector<std::string_view> open_;
+    std::vector<NsDecl> ns_;
+    std::string error_;
+};
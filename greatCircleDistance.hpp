@@ -1,6 +1,8 @@
+#pragma once
+
 #include <cmath>
 
-double greatCircleDistance(double lat1, double lon1, double lat2, double lon2) 
+inline double greatCircleDistance(double lat1, double lon1, double lat2, double lon2) 
 {
     const double earthRadius = 6371.0; // Radius of the Earth in kilometers
     
@@ -1,18 +1,17 @@
 #include <iostream>
+#include <cstring>
 #include <string>
-#include <regex>
 #include <cstdlib>
-#include <array>
+#include <utility>
+#include "AddressValidators.hpp"
+#include "OuiTable.hpp"
 
 #ifdef _WIN32
 #include <Windows.h>
 #include <iphlpapi.h>
 #pragma comment(lib, "iphlpapi.lib")
 #else
-#include <ifaddrs.h>
-#include <net/if.h>
-#include <sys/ioctl.h>
-#include <unistd.h>
+#include "NetInterfaces.hpp"
 #endif
 
 std::string getMacAddress() 
@@ -52,35 +51,19 @@ std::string getMacAddress()
 
     free(pAdapterInfo);
 #else
-    struct ifaddrs* ifaddr, * ifa;
-    if (getifaddrs(&ifaddr) == -1) 
-	  {
-        perror("getifaddrs");
-        exit(EXIT_FAILURE);
-    }
-
-    for (ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next) 
-	{
-        if (ifa->ifa_addr && ifa->ifa_addr->sa_family == AF_PACKET) 
-		    {
-            int fd = socket(AF_INET, SOCK_DGRAM, 0);
-            struct ifreq ifr;
-            strcpy(ifr.ifr_name, ifa->ifa_name);
-            if (ioctl(fd, SIOCGIFHWADDR, &ifr) != -1) 
-			      {
-                unsigned char* mac = reinterpret_cast<unsigned char*>(ifr.ifr_hwaddr.sa_data);
-                char macStr[18];
-                snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
-                    mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
-                macAddress = macStr;
-                close(fd);
-                break;
-            }
-            close(fd);
+    // One RTNETLINK dump instead of a socket and ioctl per interface
+    try
+    {
+        InterfaceInventory inventory;
+        if (const NetInterface* iface = inventory.firstEthernet())
+        {
+            macAddress = iface->macString();
         }
     }
-
-    freeifaddrs(ifaddr);
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+    }
 #endif
 
     return macAddress;
@@ -88,27 +71,39 @@ std::string getMacAddress()
 
 bool isValidMacAddress(const std::string& macAddress) 
 {
-    std::regex macRegex("^([0-9A-Fa-f]{2}[:-]){5}([0-9A-Fa-f]{2})$");
-    return std::regex_match(macAddress, macRegex);
+    return parseMacAddress(macAddress);
 }
 
-bool isMacAddressTampered(const std::string& macAddress) 
+// OUIs assigned to virtual machine NICs by hypervisor vendors
+static const OuiTable& virtualNicVendors()
 {
-    std::array<std::string, 8> commonPrefixes = 
-	  {
-        "00:50:56", "00:0C:29", "00:05:69", "00:1C:14",
-        "00:15:5D", "00:03:FF", "00:1C:42", "00:0F:4B"
-    };
-
-    for (const auto& prefix : commonPrefixes) 
-	  {
-        if (macAddress.substr(0, 8) == prefix) 
-		    {
-            return true;
+    static const OuiTable table = []()
+    {
+        OuiTable t;
+        const std::pair<uint32_t, const char*> prefixes[] =
+        {
+            {0x005056, "VMware"}, {0x000C29, "VMware"}, {0x000569, "VMware"}, {0x001C14, "VMware"},
+            {0x00155D, "Microsoft Hyper-V"}, {0x0003FF, "Microsoft Virtual PC"}, {0x001C42, "Parallels"},
+            {0x000F4B, "Oracle Virtual Iron"}
+        };
+        for (const auto& p : prefixes)
+        {
+            t.add(p.first, p.second);
         }
-    }
+        t.build();
+        return t;
+    }();
+    return table;
+}
 
-    return false;
+bool isMacAddressTampered(const std::string& macAddress) 
+{
+    MacAddressParts parts;
+    if (!parseMacAddress(macAddress, &parts))
+    {
+        return false;
+    }
+    return virtualNicVendors().classify(macToInt(parts.bytes.data())) != OuiTable::kUnknown;
 }
 
 int main() 
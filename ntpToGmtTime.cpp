@@ -1,22 +1,11 @@
 
 #include <ctime>
 #include <iostream>
-
-std::time_t ntpToGmtTime(uint64_t ntpTime) 
-{
-    const uint64_t ntpFracPerSec = 1LL << 32;
-    const uint64_t ntpEpochOffset = 2208988800ULL;
-
-    uint64_t ntpSec = ntpTime / ntpFracPerSec;
-    uint64_t ntpFrac = ntpTime % ntpFracPerSec;
-
-    std::time_t gmtTime = static_cast<std::time_t>(ntpSec - ntpEpochOffset);
-    return gmtTime;
-}
+#include "NtpConvert.hpp"
 
 int main() 
 {
-    uint64_t ntpTime = 3785936769ULL; // Example NTP time
+    uint64_t ntpTime = 3785936769ULL << 32; // Example NTP time (2019-12-22), seconds in the high word
     std::time_t gmtTime = ntpToGmtTime(ntpTime);
 
     std::cout << "NTP Time: " << ntpTime << std::endl;
@@ -1,17 +1,6 @@
 #include <ctime>
 #include <iostream>
-
-std::time_t ntpToUtc(uint64_t ntpTime) 
-{
-    const uint64_t ntpFracPerSec = 0x100000000; // 2^32
-    const uint64_t ntpEpochOffset = 0x83AA7E80; // 2208988800 (seconds between 01/01/1900 and 01/01/1970)
-
-    uint64_t ntpSecs = ntpTime / ntpFracPerSec;
-    uint64_t ntpFrac = ntpTime % ntpFracPerSec;
-
-    std::time_t utcTime = static_cast<std::time_t>(ntpSecs - ntpEpochOffset);
-    return utcTime;
-}
+#include "NtpConvert.hpp"
 
 int main() 
 {